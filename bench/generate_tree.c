@@ -0,0 +1,257 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file generates a synthetic asset tree for the
+ *    benchmarks. The same options (and seed) always give
+ *    the same tree, byte for byte.
+ *
+ *    Usage: generate_tree <folder> [options]
+ *      --files <n>         how many files to create (default 10000)
+ *      --depth <n>         how deep the folders go (default 4)
+ *      --fanout <n>        sub-folders per folder (default 4)
+ *      --min-size <bytes>  smallest file (default 64)
+ *      --max-size <bytes>  largest file (default 262144)
+ *      --image-ratio <r>   fraction of files that are images (default 0.3)
+ *      --seed <n>          random seed (default 1)
+ *
+ *    File sizes are log-uniform between the min and max, which
+ *    is roughly what real asset folders look like: lots of small
+ *    files and a few big ones. It prints a JSON summary of what
+ *    it generated.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `strcmp()`.
+#include <string.h>
+
+// For fixed width integers, e.g., `uint64_t`.
+#include <stdint.h>
+
+// For `exp()` and `log()`.
+#include <math.h>
+
+// For `mkdir()`.
+#include <sys/stat.h>
+
+// For `errno`.
+#include <errno.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define MAX_PATH_LENGTH 1024
+#define WRITE_BLOCK_LENGTH 65536
+
+
+/*  ------------------------------------------------------------
+ *
+ *  NON-CONSTANT VARIABLES THAT CAN BE SET
+ *
+ *  ------------------------------------------------------------
+ */
+long number_of_files = 10000;
+int depth = 4;
+int fanout = 4;
+long min_size = 64;
+long max_size = 262144;
+double image_ratio = 0.3;
+uint64_t seed = 1;
+uint64_t random_state;
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Get the next pseudo-random number (xorshift64*).
+ *
+ *  @return uint64_t The number.
+ */
+static uint64_t next_random(void) {
+  random_state ^= random_state >> 12;
+  random_state ^= random_state << 25;
+  random_state ^= random_state >> 27;
+  return random_state * 2685821657736338717ULL;
+}
+
+/*
+ *  Get a pseudo-random number in [0, 1).
+ *
+ *  @return double The number.
+ */
+static double next_unit(void) {
+  return (next_random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ *  Make a folder, if it isn't there already.
+ *
+ *  @param char *path The folder.
+ *  @return void
+ */
+static void make_folder(const char *path) {
+  if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+    printf("Could not create this folder:\n%s\n", path);
+    exit(1);
+  }
+}
+
+/*
+ *  Write a file of pseudo-random bytes.
+ *
+ *  @param char *path The file.
+ *  @param long size How many bytes.
+ *  @return void
+ */
+static void write_file(const char *path, long size) {
+
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    printf("Could not create this file:\n%s\n", path);
+    exit(1);
+  }
+
+  static unsigned char block[WRITE_BLOCK_LENGTH];
+  while (size > 0) {
+    long length = size < WRITE_BLOCK_LENGTH ? size : WRITE_BLOCK_LENGTH;
+    long i;
+    for (i = 0; i + 8 <= length; i += 8) {
+      uint64_t value = next_random();
+      memcpy(block + i, &value, 8);
+    }
+    for (; i < length; i++) {
+      block[i] = (unsigned char) next_random();
+    }
+    if (fwrite(block, 1, length, file) != (size_t) length) {
+      printf("Could not write this file:\n%s\n", path);
+      exit(1);
+    }
+    size -= length;
+  }
+
+  fclose(file);
+
+}
+
+/*
+ *  Generate the tree, and print a summary.
+ *
+ *  @param int number_of_arguments The number of arguments.
+ *  @param char *argument[] The list of arguments.
+ *  @return int A status code.
+ */
+int main(int number_of_arguments, char *argument[]) {
+
+  if (number_of_arguments < 2) {
+    puts("Usage: generate_tree <folder> [--files n] [--depth n] [--fanout n]");
+    puts("       [--min-size bytes] [--max-size bytes] [--image-ratio r] [--seed n]");
+    return 1;
+  }
+
+  const char *root = argument[1];
+  int i;
+  for (i = 2; i + 1 < number_of_arguments; i += 2) {
+    if (strcmp(argument[i], "--files") == 0) {
+      number_of_files = atol(argument[i + 1]);
+    } else if (strcmp(argument[i], "--depth") == 0) {
+      depth = atoi(argument[i + 1]);
+    } else if (strcmp(argument[i], "--fanout") == 0) {
+      fanout = atoi(argument[i + 1]);
+    } else if (strcmp(argument[i], "--min-size") == 0) {
+      min_size = atol(argument[i + 1]);
+    } else if (strcmp(argument[i], "--max-size") == 0) {
+      max_size = atol(argument[i + 1]);
+    } else if (strcmp(argument[i], "--image-ratio") == 0) {
+      image_ratio = atof(argument[i + 1]);
+    } else if (strcmp(argument[i], "--seed") == 0) {
+      seed = strtoull(argument[i + 1], NULL, 10);
+    } else {
+      printf("Unknown option: %s\n", argument[i]);
+      return 1;
+    }
+  }
+  random_state = seed ? seed : 1;
+  if (min_size < 1) {
+    min_size = 1;
+  }
+  if (max_size < min_size) {
+    max_size = min_size;
+  }
+  if (fanout < 1) {
+    fanout = 1;
+  }
+
+  static const char *image_extensions[] = { "png", "jpg", "gif", "svg" };
+  static const char *other_extensions[] = { "js", "css", "html", "json", "woff2", "txt" };
+
+  make_folder(root);
+
+  long images = 0;
+  long long bytes = 0;
+  long file;
+  for (file = 0; file < number_of_files; file++) {
+
+    // Pick a folder: a random walk down from the root.
+    char path[MAX_PATH_LENGTH];
+    int length = snprintf(path, sizeof(path), "%s", root);
+    int levels = (int) (next_random() % (depth + 1));
+    int level;
+    for (level = 0; level < levels; level++) {
+      length += snprintf(path + length, sizeof(path) - length, "/d%d", (int) (next_random() % fanout));
+      make_folder(path);
+    }
+
+    // Pick a type and a size.
+    const char *file_extension;
+    if (next_unit() < image_ratio) {
+      file_extension = image_extensions[next_random() % 4];
+      images++;
+    } else {
+      file_extension = other_extensions[next_random() % 6];
+    }
+    long size = (long) exp(log((double) min_size) + next_unit() * (log((double) max_size) - log((double) min_size)));
+
+    snprintf(path + length, sizeof(path) - length, "/asset%ld.%s", file, file_extension);
+    write_file(path, size);
+    bytes += size;
+
+  }
+
+  printf("{\"files\":%ld,\"images\":%ld,\"bytes\":%lld,\"depth\":%d,\"fanout\":%d,"
+         "\"min_size\":%ld,\"max_size\":%ld,\"image_ratio\":%g,\"seed\":%llu}\n",
+         number_of_files, images, bytes, depth, fanout, min_size, max_size, image_ratio,
+         (unsigned long long) seed);
+
+  return 0;
+
+}
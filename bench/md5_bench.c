@@ -0,0 +1,130 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is a throughput benchmark for the
+ *    built-in md5 implementation.
+ *
+ *    Usage: md5_bench [<megabytes>] [<block-size>]
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For `clock_gettime()`.
+#include <time.h>
+
+// The md5 implementation we're measuring.
+#include "../src/md5.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define DEFAULT_MEGABYTES 256
+#define DEFAULT_BLOCK_SIZE 65536
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Get the current monotonic time in seconds.
+ *
+ *  @return double The time.
+ */
+static double now(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/*
+ *  Hash a buffer over and over, and report the throughput.
+ *
+ *  @param int number_of_arguments The number of arguments.
+ *  @param char *argument[] The list of arguments.
+ *  @return int A status code.
+ */
+int main(int number_of_arguments, char *argument[]) {
+
+  long megabytes = DEFAULT_MEGABYTES;
+  long block_size = DEFAULT_BLOCK_SIZE;
+  if (number_of_arguments > 1) {
+    megabytes = atol(argument[1]);
+  }
+  if (number_of_arguments > 2) {
+    block_size = atol(argument[2]);
+  }
+  if (megabytes <= 0 || block_size <= 0) {
+    puts("Usage: md5_bench [<megabytes>] [<block-size>]");
+    return 1;
+  }
+
+  // Fill a block with reproducible, non-trivial bytes.
+  unsigned char *block = malloc(block_size);
+  if (block == NULL) {
+    puts("malloc failure");
+    return 1;
+  }
+  unsigned int seed = 12345;
+  long i;
+  for (i = 0; i < block_size; i++) {
+    seed = seed * 1103515245 + 12345;
+    block[i] = (unsigned char) (seed >> 16);
+  }
+
+  // Hash the same block until we've covered the requested size.
+  long long total = (long long) megabytes * 1024 * 1024;
+  long long hashed = 0;
+  struct md5_context context;
+  unsigned char digest[MD5_DIGEST_LENGTH];
+
+  double start = now();
+  md5_init(&context);
+  while (hashed < total) {
+    md5_update(&context, block, block_size);
+    hashed += block_size;
+  }
+  md5_final(&context, digest);
+  double elapsed = now() - start;
+
+  // Print the digest too, so the work can't be optimized away.
+  printf("md5 block=%ld bytes=%lld seconds=%.3f MB/s=%.1f digest=",
+         block_size, hashed, elapsed, hashed / (1024.0 * 1024.0) / elapsed);
+  int j;
+  for (j = 0; j < MD5_DIGEST_LENGTH; j++) {
+    printf("%02x", digest[j]);
+  }
+  printf("\n");
+
+  free(block);
+  return 0;
+
+}
@@ -0,0 +1,251 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file runs a command and measures it for the
+ *    benchmarks: wall time, CPU time, peak RSS and (with
+ *    `--trace`) the number of system calls it makes.
+ *
+ *    Usage: measure --files <n> --bytes <n> [--trace] -- <command> [args]
+ *
+ *    The command's stdout is discarded. A JSON object with
+ *    the measurements (and files/s and MB/s worked out from
+ *    `--files` and `--bytes`) is printed on stdout.
+ *
+ *    System calls are counted with ptrace, following every
+ *    thread and child, so a traced run is much slower than a
+ *    real one. Its time isn't reported: run the command again
+ *    without `--trace` for that.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `strcmp()`.
+#include <string.h>
+
+// For `fork()`, `execvp()` and `dup2()`.
+#include <unistd.h>
+
+// For `open()`.
+#include <fcntl.h>
+
+// For `raise()` and the signal numbers.
+#include <signal.h>
+
+// For `clock_gettime()`.
+#include <time.h>
+
+// For `errno`.
+#include <errno.h>
+
+// For `wait4()` and `struct rusage`.
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+// For `ptrace()`.
+#include <sys/ptrace.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Get the current monotonic time in seconds.
+ *
+ *  @return double The time.
+ */
+static double now(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/*
+ *  Start the command in a child process, with stdout discarded.
+ *
+ *  @param char *command[] The command and its arguments.
+ *  @param int trace 1 to let the parent trace the child.
+ *  @return pid_t The child.
+ */
+static pid_t start_command(char *command[], int trace) {
+
+  pid_t child = fork();
+  if (child < 0) {
+    puts("Could not fork.");
+    exit(1);
+  }
+
+  if (child == 0) {
+    int null = open("/dev/null", O_WRONLY);
+    if (null >= 0) {
+      dup2(null, STDOUT_FILENO);
+      close(null);
+    }
+    if (trace) {
+      ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+      raise(SIGSTOP);
+    }
+    execvp(command[0], command);
+    _exit(127);
+  }
+
+  return child;
+
+}
+
+/*
+ *  Run the command under ptrace, and count its system calls.
+ *
+ *  @param char *command[] The command and its arguments.
+ *  @param int *status Where to store the command's exit status.
+ *  @return long The number of system calls, or -1 if tracing isn't allowed.
+ */
+static long count_syscalls(char *command[], int *status) {
+
+  pid_t child = start_command(command, 1);
+
+  // Wait for the child to stop itself, then ask to see its
+  // system calls, and those of any thread or process it starts.
+  int wait_status;
+  if (waitpid(child, &wait_status, 0) < 0 || !WIFSTOPPED(wait_status)) {
+    return -1;
+  }
+  long options = PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE
+    | PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK | PTRACE_O_EXITKILL;
+  if (ptrace(PTRACE_SETOPTIONS, child, NULL, (void *) options) != 0) {
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    return -1;
+  }
+  ptrace(PTRACE_SYSCALL, child, NULL, NULL);
+
+  // Every system call stops the tracee twice: on entry and exit.
+  long stops = 0;
+  *status = 0;
+  while (1) {
+
+    pid_t tracee = waitpid(-1, &wait_status, __WALL);
+    if (tracee < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    if (WIFEXITED(wait_status) || WIFSIGNALED(wait_status)) {
+      if (tracee == child) {
+        *status = WIFEXITED(wait_status) ? WEXITSTATUS(wait_status) : 128 + WTERMSIG(wait_status);
+      }
+      continue;
+    }
+
+    int signal_to_deliver = 0;
+    if (WIFSTOPPED(wait_status)) {
+      int signal = WSTOPSIG(wait_status);
+      if (signal == (SIGTRAP | 0x80)) {
+        stops++;
+      } else if (signal != SIGTRAP && signal != SIGSTOP) {
+        signal_to_deliver = signal;
+      }
+    }
+    ptrace(PTRACE_SYSCALL, tracee, NULL, (void *) (long) signal_to_deliver);
+
+  }
+
+  return (stops + 1) / 2;
+
+}
+
+/*
+ *  Run a command and print what it cost.
+ *
+ *  @param int number_of_arguments The number of arguments.
+ *  @param char *argument[] The list of arguments.
+ *  @return int A status code.
+ */
+int main(int number_of_arguments, char *argument[]) {
+
+  long files = 0;
+  double bytes = 0;
+  int trace = 0;
+  char **command = NULL;
+
+  int i;
+  for (i = 1; i < number_of_arguments; i++) {
+    if (strcmp(argument[i], "--files") == 0 && i + 1 < number_of_arguments) {
+      files = atol(argument[++i]);
+    } else if (strcmp(argument[i], "--bytes") == 0 && i + 1 < number_of_arguments) {
+      bytes = atof(argument[++i]);
+    } else if (strcmp(argument[i], "--trace") == 0) {
+      trace = 1;
+    } else if (strcmp(argument[i], "--") == 0 && i + 1 < number_of_arguments) {
+      command = &argument[i + 1];
+      break;
+    }
+  }
+  if (command == NULL) {
+    puts("Usage: measure --files <n> --bytes <n> [--trace] -- <command> [args]");
+    return 1;
+  }
+
+  // Count system calls in a separate run, since tracing is slow.
+  if (trace) {
+    int status;
+    long syscalls = count_syscalls(command, &status);
+    if (syscalls < 0) {
+      printf("{\"syscalls\":null}\n");
+    } else {
+      printf("{\"syscalls\":%ld,\"status\":%d}\n", syscalls, status);
+    }
+    return 0;
+  }
+
+  // Otherwise, time it and get its resource usage.
+  double start = now();
+  pid_t child = start_command(command, 0);
+  int wait_status;
+  struct rusage usage;
+  if (wait4(child, &wait_status, 0, &usage) < 0) {
+    puts("Could not wait for the command.");
+    return 1;
+  }
+  double seconds = now() - start;
+  int status = WIFEXITED(wait_status) ? WEXITSTATUS(wait_status) : 128 + WTERMSIG(wait_status);
+
+  printf("{\"seconds\":%.6f,\"user_seconds\":%.6f,\"system_seconds\":%.6f,"
+         "\"max_rss_kb\":%ld,\"files_per_second\":%.1f,\"mb_per_second\":%.2f,\"status\":%d}\n",
+         seconds,
+         usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6,
+         usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6,
+         usage.ru_maxrss,
+         seconds > 0 ? files / seconds : 0.0,
+         seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0,
+         status);
+
+  return 0;
+
+}
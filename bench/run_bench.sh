@@ -0,0 +1,77 @@
+#!/bin/sh
+#
+#    ASSETS
+#
+#    Run the benchmarks: generate a synthetic asset tree,
+#    run `assets` over it in each of its main modes, and
+#    write the measurements to a JSON file.
+#
+#    Everything can be set from the environment, e.g.:
+#
+#        BENCH_FILES=100000 BENCH_DEPTH=6 BENCH_IMAGE_RATIO=0.5 make bench
+#
+#    Author JT Paasch
+#    Copyright 2014 Nara Logics
+#    License MIT (included with this source code)
+#
+
+set -e
+
+BUILD=${BUILD:-build}
+ASSETS=${ASSETS:-$BUILD/assets}
+GENERATE=$BUILD/generate_tree
+MEASURE=$BUILD/measure
+RESULTS=${RESULTS:-$BUILD/bench_results.json}
+WORK=${WORK:-$BUILD/bench_tree}
+
+BENCH_FILES=${BENCH_FILES:-10000}
+BENCH_DEPTH=${BENCH_DEPTH:-4}
+BENCH_FANOUT=${BENCH_FANOUT:-4}
+BENCH_MIN_SIZE=${BENCH_MIN_SIZE:-64}
+BENCH_MAX_SIZE=${BENCH_MAX_SIZE:-262144}
+BENCH_IMAGE_RATIO=${BENCH_IMAGE_RATIO:-0.3}
+BENCH_SEED=${BENCH_SEED:-1}
+BENCH_BASE64_LIMIT=${BENCH_BASE64_LIMIT:-8192}
+BENCH_IGNORE_LIST=${BENCH_IGNORE_LIST:-d0,d3,node_modules,.git,dist,tmp,cache,build,coverage,vendor}
+
+# Generate the tree once; cachebust runs get a fresh copy each time.
+rm -rf "$WORK" "$WORK.pristine"
+TREE=$("$GENERATE" "$WORK.pristine" --files "$BENCH_FILES" --depth "$BENCH_DEPTH" --fanout "$BENCH_FANOUT" \
+  --min-size "$BENCH_MIN_SIZE" --max-size "$BENCH_MAX_SIZE" --image-ratio "$BENCH_IMAGE_RATIO" --seed "$BENCH_SEED")
+
+# Run one mode: once untimed with `--stats-file` to count the files
+# and bytes it actually processes (`--ignore` skips part of the tree),
+# once timed, and once traced for system calls.
+run_mode() {
+  mode=$1
+  shift
+  rm -rf "$WORK"
+  cp -a "$WORK.pristine" "$WORK"
+  "$ASSETS" "$WORK" "$@" --stats-file "$WORK.stats" > /dev/null
+  files=$(sed 's/.*"counters":{"files":\([0-9]*\).*/\1/' "$WORK.stats")
+  bytes=$(sed 's/.*"bytes_read":\([0-9]*\).*/\1/' "$WORK.stats")
+  rm -f "$WORK.stats"
+  rm -rf "$WORK"
+  cp -a "$WORK.pristine" "$WORK"
+  timing=$("$MEASURE" --files "$files" --bytes "$bytes" -- "$ASSETS" "$WORK" "$@")
+  rm -rf "$WORK"
+  cp -a "$WORK.pristine" "$WORK"
+  syscalls=$("$MEASURE" --files "$files" --bytes "$bytes" --trace -- "$ASSETS" "$WORK" "$@")
+  printf '{"mode":"%s","arguments":"%s","files":%s,"bytes":%s,"timing":%s,"trace":%s}' \
+    "$mode" "$*" "$files" "$bytes" "$timing" "$syscalls"
+}
+
+{
+  printf '{"tree":%s,"results":[' "$TREE"
+  run_mode plain
+  printf ','
+  run_mode cachebust --cachebust
+  printf ','
+  run_mode base64 --base64 "$BENCH_BASE64_LIMIT"
+  printf ','
+  run_mode ignore --ignore "$BENCH_IGNORE_LIST"
+  printf ']}\n'
+} > "$RESULTS"
+
+rm -rf "$WORK" "$WORK.pristine"
+cat "$RESULTS"
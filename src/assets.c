@@ -33,6 +33,9 @@
 // For working with strings, e.g., `strcat()`.
 #include <string.h>
 
+// For `sysconf()`.
+#include <unistd.h>
+
 // Our own utilities are defined in utilities.h.
 #include "utilities.h"
 
@@ -42,6 +45,33 @@
 // Our tools for logging/writing output are defined in logging.h.
 #include "logging.h"
 
+// The options for a scan are defined in libassets.h.
+#include "libassets.h"
+
+// Our hash cache is defined in cache.h.
+#include "cache.h"
+
+// Our per-phase timers are defined in stats.h.
+#include "stats.h"
+
+// Our hash algorithms are defined in digest.h.
+#include "digest.h"
+
+// The duplicate finder is defined in dedupe.h.
+#include "dedupe.h"
+
+// Sorting the manifest is defined in sort.h.
+#include "sort.h"
+
+// Comparing with an old manifest is defined in diff.h.
+#include "diff.h"
+
+// The compression methods are defined in compress.h.
+#include "compress.h"
+
+// Watch mode is defined in watch.h.
+#include "watch.h"
+
 // Prototypes for this file's functions.
 #include "assets.h"
 
@@ -55,17 +85,6 @@
 #define MAX_PATH_LENGTH 1024
 
 
-/*  ------------------------------------------------------------
- *
- *  NON-CONSTANT VARIABLES THAT CAN BE SET
- *
- *  ------------------------------------------------------------
- */
-int has_blacklist_additions = 0;
-char *blacklist_additions;
-char *blacklist;
-
-
 /*  ------------------------------------------------------------
  *
  *  FUNCTION DEFINITIONS
@@ -93,6 +112,26 @@ void print_usage(void) {
   puts("--cachebust     : renames files with cachebusting names");
   puts("--base64 <size> : base64 encode files smaller than <size> bytes");
   puts("--ignore file1,file2,file3 : ignore the specified files"); 
+  puts("                  (.gitignore style patterns, e.g. \"*.map,build/**/tmp,!keep.map\")");
+  puts("--ignore-file <file> : ignore the patterns in a .gitignore style <file>");
+  puts("--jobs <n>      : walk and process files on <n> threads");
+  puts("--pipeline <n>  : walk on one thread, process files on <n> more,");
+  puts("                  and keep the output in walk order");
+  puts("--cache <file>  : reuse hashes of unchanged files from <file>");
+  puts("--hash <name>   : hash with md5 (the default), sha256, xxh3 or blake3");
+  puts("--sniff         : tell file types by their first bytes, not only their extension");
+  puts("--dimensions    : add the width and height of images (from their headers)");
+  puts("--sri <names>   : add an integrity value with sha256, sha384 and/or sha512 (e.g. sha384)");
+  puts("--precompress <names> : write gzip and/or zstd siblings of files (e.g. gzip,zstd)");
+  puts("--format <name> : write the dictionary as json (the default) or bin");
+  puts("--compress <name> : compress the dictionary with gzip, zstd or none (the default goes by .gz/.zst)");
+  puts("--sort <order>  : sort the dictionary by path, key or size");
+  puts("--sort-memory <bytes> : sort in this much memory, and use temporary files beyond it");
+  puts("--dedupe <file> : write a report of files with the same contents to <file>");
+  puts("--diff <file>   : only write what was added, removed, modified or renamed since <file>");
+  puts("--watch         : keep running, and update the dictionary when files change");
+  puts("--stats         : print time spent in each phase to stderr");
+  puts("--stats-file <file> : write those stats to <file> as JSON");
   puts("");
   puts("Example: assets . assets.json");
   puts("-- This will crawl the current directory (\".\")");
@@ -101,6 +140,38 @@ void print_usage(void) {
   puts("");
 }
 
+/*
+ *  Log a record (or hold on to it, to be sorted).
+ *
+ *  @param struct asset_record *record The record.
+ *  @return void
+ */
+static void output_record(const struct asset_record *record) {
+  if (sort_is_enabled()) {
+    sort_remember(record);
+  } else {
+    log_record(record);
+  }
+}
+
+/*
+ *  Log each record the scan finds (with `--diff`, only if it changed).
+ *
+ *  @param struct asset_record *record The record.
+ *  @param void *context Unused.
+ *  @return void
+ */
+static void log_scanned_record(const struct asset_record *record, void *context) {
+  if (dedupe_is_enabled()) {
+    dedupe_remember(record);
+  }
+  if (diff_is_enabled()) {
+    diff_record(record, output_record);
+  } else {
+    output_record(record);
+  }
+}
+
 
 
 /*  ------------------------------------------------------------
@@ -132,25 +203,49 @@ int main(int number_of_arguments, char *argument[]) {
     // a directory to crawl, or an output file to write to.
     int has_folder_to_crawl = 0;
     int has_output_file = 0;
+    int has_cachebust = 0;
+    int has_bin_format = 0;
 
     // We'll store the path to the folder to crawl here:
     char folder_to_crawl[MAX_PATH_LENGTH];
 
+    // And the path to the output file here (the logger
+    // keeps pointing at it, so it has to outlive the loop):
+    char output_file[MAX_PATH_LENGTH];
+
+    // The options for the scan.
+    struct assets_options options;
+    init_assets_options(&options);
+    options.folder = folder_to_crawl;
+    options.on_record = log_scanned_record;
+
     // Now we can process each argument.
     int i;
     for (i = 1; i < number_of_arguments; i++) {
 
       // Is this argument the optional "--cachebust"?
       if (strncmp(argument[i], "--cachebust", 11) == 0) {
-        set_cachebust(1);
+        options.cachebust = 1;
+        has_cachebust = 1;
+      }
+
+      // Is this argument the optional "--ignore-file"?
+      // (Check it before "--ignore", which is a prefix of it.)
+      else if (strncmp(argument[i], "--ignore-file", 13) == 0) {
+
+        // The path to the file will be the next argument.
+        options.ignore_file = argument[i + 1];
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
       }
 
       // Is this argument the optional "--ignore"? 
       else if (strncmp(argument[i], "--ignore", 8) == 0) {
 
         // The string of items to blacklist/ignore will be the next argument.
-        blacklist_additions = argument[i + 1];
-        has_blacklist_additions = 1;
+        options.ignore = argument[i + 1];
 
         // Increment the counter so the next iteration of the loop
         // won't try to process the blacklist string.
@@ -166,7 +261,204 @@ int main(int number_of_arguments, char *argument[]) {
         // TODO - could this argument be larger than an int?
         // Consider atol here. Consider limiting the number of characters
         // in the argument before conversion.
-        set_max_filesize_to_base64_encode(atoi(argument[i + 1]));
+        options.base64_max_size = atoi(argument[i + 1]);
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
+      }
+
+      // Is this argument the optional "--jobs"?
+      else if (strncmp(argument[i], "--jobs", 6) == 0) {
+
+        // The number of threads will be the next argument.
+        options.jobs = atoi(argument[i + 1]);
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
+      }
+
+      // Is this argument the optional "--pipeline"?
+      else if (strncmp(argument[i], "--pipeline", 10) == 0) {
+
+        // The number of worker threads will be the next argument.
+        options.pipeline_workers = atoi(argument[i + 1]);
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
+      }
+
+      // Is this argument the optional "--watch"?
+      else if (strncmp(argument[i], "--watch", 7) == 0) {
+        set_watch(1);
+      }
+
+      // Is this argument the optional "--hash"?
+      else if (strncmp(argument[i], "--hash", 6) == 0) {
+
+        // The name of the algorithm will be the next argument.
+        int algorithm = find_digest_algorithm(argument[i + 1] != NULL ? argument[i + 1] : "");
+        if (algorithm < 0) {
+          puts("--hash must be one of: md5, sha256, xxh3, blake3");
+          exit(1);
+        }
+        set_digest_algorithm(algorithm);
+        options.hash = argument[i + 1];
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
+      }
+
+      // Is this argument the optional "--sniff"?
+      else if (strncmp(argument[i], "--sniff", 7) == 0) {
+        options.sniff = 1;
+      }
+
+      // Is this argument the optional "--dimensions"?
+      else if (strncmp(argument[i], "--dimensions", 12) == 0) {
+        options.dimensions = 1;
+      }
+
+      // Is this argument the optional "--sri"?
+      else if (strncmp(argument[i], "--sri", 5) == 0) {
+
+        // The list of digests will be the next argument
+        // (`init_scan()` checks it).
+        options.sri = argument[i + 1] != NULL ? argument[i + 1] : "";
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
+      }
+
+      // Is this argument the optional "--precompress"?
+      else if (strncmp(argument[i], "--precompress", 13) == 0) {
+
+        // The list of variants will be the next argument
+        // (`init_scan()` checks it).
+        options.precompress = argument[i + 1] != NULL ? argument[i + 1] : "";
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
+      }
+
+      // Is this argument the optional "--dedupe"?
+      else if (strncmp(argument[i], "--dedupe", 8) == 0) {
+
+        // The path to the report will be the next argument.
+        set_dedupe_file(argument[i + 1]);
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
+      }
+
+      // Is this argument the optional "--diff"?
+      else if (strncmp(argument[i], "--diff", 6) == 0) {
+
+        // The path to the old manifest will be the next argument.
+        set_diff_file(argument[i + 1]);
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
+      }
+
+      // Is this argument the optional "--format"?
+      else if (strncmp(argument[i], "--format", 8) == 0) {
+
+        // The format will be the next argument.
+        const char *format = argument[i + 1] != NULL ? argument[i + 1] : "";
+        if (strcmp(format, "json") == 0) {
+          set_log_format(LOG_FORMAT_JSON);
+        } else if (strcmp(format, "bin") == 0) {
+          set_log_format(LOG_FORMAT_BIN);
+          has_bin_format = 1;
+        } else {
+          puts("--format must be one of: json, bin");
+          exit(1);
+        }
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
+      }
+
+      // Is this argument the optional "--compress"?
+      else if (strncmp(argument[i], "--compress", 10) == 0) {
+
+        // The method will be the next argument.
+        int method = find_compression(argument[i + 1] != NULL ? argument[i + 1] : "");
+        if (method < 0) {
+          puts("--compress must be one of: gzip, zstd, none");
+          exit(1);
+        }
+        set_log_compression(method);
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
+      }
+
+      // Is this argument the optional "--sort-memory"?
+      // (Check it before "--sort", which is a prefix of it.)
+      else if (strncmp(argument[i], "--sort-memory", 13) == 0) {
+
+        // The budget will be the next argument.
+        long long bytes = argument[i + 1] != NULL ? atoll(argument[i + 1]) : 0;
+        if (bytes <= 0) {
+          puts("--sort-memory must be a number of bytes.");
+          exit(1);
+        }
+        set_sort_memory((size_t) bytes);
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
+      }
+
+      // Is this argument the optional "--sort"?
+      else if (strncmp(argument[i], "--sort", 6) == 0) {
+
+        // The order will be the next argument.
+        int order = find_sort_order(argument[i + 1] != NULL ? argument[i + 1] : "");
+        if (order < 0) {
+          puts("--sort must be one of: path, key, size");
+          exit(1);
+        }
+        set_sort_order(order);
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
+      }
+
+      // Is this argument the optional "--stats-file"?
+      // (Check it before "--stats", which is a prefix of it.)
+      else if (strncmp(argument[i], "--stats-file", 12) == 0) {
+
+        // The path to the stats file will be the next argument.
+        set_stats_file(argument[i + 1]);
+
+        // Increment the counter so the next iteration skips that argument.
+        i++;
+
+      }
+
+      // Is this argument the optional "--stats"?
+      else if (strncmp(argument[i], "--stats", 7) == 0) {
+        set_stats(1);
+      }
+
+      // Is this argument the optional "--cache"?
+      else if (strncmp(argument[i], "--cache", 7) == 0) {
+
+        // The path to the cache file will be the next argument.
+        set_cache_file(argument[i + 1]);
 
         // Increment the counter so the next iteration skips that argument.
         i++;
@@ -191,7 +483,6 @@ int main(int number_of_arguments, char *argument[]) {
         else if (!has_output_file) {
 
           // Calculate the real path to this file.
-          char output_file[MAX_PATH_LENGTH];
           set_real_path(output_file, argument[i]);
 
           // Set this file as our log file.
@@ -215,51 +506,111 @@ int main(int number_of_arguments, char *argument[]) {
       print_usage();
     }
 
+    // Renaming files would set off the watch all over again.
+    else if (has_cachebust && watch_is_enabled()) {
+      puts("--watch can't be used with --cachebust.");
+      exit(1);
+    }
+
+    // The duplicates report is made once, at the end of a walk.
+    else if (dedupe_is_enabled() && watch_is_enabled()) {
+      puts("--watch can't be used with --dedupe.");
+      exit(1);
+    }
+
+    // A diff is made once, against a manifest that's already there.
+    else if (diff_is_enabled() && watch_is_enabled()) {
+      puts("--watch can't be used with --diff.");
+      exit(1);
+    }
+
+    // The changes are noted in each entry, which a binary manifest has no room for.
+    else if (diff_is_enabled() && has_bin_format) {
+      puts("--diff can only write --format json.");
+      exit(1);
+    }
+
+    // zstd is only there if it was built in.
+    else if (!compression_is_available(get_log_compression())) {
+      puts("This build can't write zstd. Rebuild with `make ZSTD=1` (it needs libzstd).");
+      exit(1);
+    }
+
     // Otherwise, we can get on with it.
     else {
 
-      // Initialize the blacklist.
-      if (has_blacklist_additions) {
+      // Compressing siblings is slow, so unless `--jobs` says
+      // otherwise, it runs on a pipeline with a worker per core
+      // (which keeps the output in the order of a plain walk).
+      if (options.precompress != NULL && options.jobs <= 1 && options.pipeline_workers <= 0) {
+        options.pipeline_workers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+      }
 
-        // TODO - Did you include the null terminators in ".,..," in the malloc argument size?
-        // I'm pretty sure this is wrong. I've tried to fix it but please check my code.
+      // Big files can be hashed on every core, unless `--jobs` or
+      // `--pipeline` already has the cores busy with one file each.
+      if (options.jobs <= 1 && options.pipeline_workers <= 0) {
+        options.hash_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+      }
 
-        blacklist = malloc(strlen(blacklist_additions) + 6);
-        if (blacklist != NULL) {
-          initialize_string(blacklist);
-          add_to_string(blacklist, ".,..,");
-          add_to_string(blacklist, blacklist_additions);
-        } else {
-          // malloc failed, bail out
-          puts("malloc failure, wtf");
-          return 1;
-        }
-      } else {
+      // Set the scan up (this also builds the set of names to ignore).
+      struct scan scan;
+      char error[ASSETS_ERROR_LENGTH];
+      if (!init_scan(&scan, &options, error, sizeof(error))) {
+        puts(error);
+        exit(1);
+      }
+      scan.use_cache = cache_is_enabled();
 
-        // TODO - Did you include the null terminators in ".,..," in the malloc argument size?
-        // I'm pretty sure this is wrong. I've tried to fix it but please check my code.
+      // Start the clock for `--stats`.
+      start_stats();
 
-        blacklist = malloc(5);
-        if (blacklist != NULL) {
-          initialize_string(blacklist);
-          add_to_string(blacklist, ".,..");
-        } else {
-          // malloc failed, bail out
-          puts("malloc failure, wtf");
-          return 1;
-        }
+      // Load the hash cache from the last run (if there is one).
+      uint64_t started = start_timer();
+      load_cache();
+      stop_timer(PHASE_CACHE, started);
+
+      // In watch mode, walk the tree and keep the log up to date
+      // until we're interrupted.
+      if (watch_is_enabled()) {
+        run_watch(&scan, folder_to_crawl);
       }
 
-      // Start the logging.
-      start_logging();
+      // Otherwise, walk the tree once, logging as we go.
+      else {
+
+        // The old manifest is read before the new one is started,
+        // in case they're the same file.
+        if (diff_is_enabled()) {
+          load_old_manifest();
+        }
+        start_logging();
+        walk(&scan, folder_to_crawl);
+        if (scan_failed(&scan)) {
+          puts(scan.error);
+          exit(1);
+        }
+        if (diff_is_enabled()) {
+          finish_diff(output_record);
+        }
+        if (sort_is_enabled()) {
+          finish_sort(log_record);
+        }
+        stop_logging();
+
+        // Look for duplicates among the files we found.
+        write_dedupe_report();
+      }
 
-      // Walk the tree.
-      walk(folder_to_crawl, blacklist);
+      // Save the hash cache for the next run.
+      started = start_timer();
+      save_cache();
+      stop_timer(PHASE_CACHE, started);
 
-      // Stop the logging.
-      stop_logging();
+      // Report where the time went.
+      report_stats();
 
-      // TODO - explicitly state if we're letting the system free the memory we're malloc'ing.
+      // We're done with the scan.
+      free_scan(&scan);
     }
 
   }
@@ -0,0 +1,251 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides a base64 encoder (RFC 4648, no
+ *    line wrapping), so we don't have to shell out to `base64`.
+ *
+ *    On x86 there are SSSE3 and AVX2 fast paths, which are
+ *    picked at runtime based on what the CPU supports. Both
+ *    turn 12 (or 24) input bytes into 16 (or 32) characters
+ *    at a time, and leave the tail to the scalar encoder.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// For fixed width integers, e.g., `uint32_t`.
+#include <stdint.h>
+
+// The SSE/AVX intrinsics (on x86 only).
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BASE64_HAVE_X86 1
+#endif
+
+// We need the header that declares the prototypes for this file.
+#include "base64.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+static const char base64_alphabet[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in base64.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Encode bytes with the portable, one-group-at-a-time encoder.
+ *
+ *  @param char *destination Where to write the characters. It must have room
+ *                           for BASE64_ENCODED_LENGTH(length) + 1 characters.
+ *  @param unsigned char *source The bytes to encode.
+ *  @param size_t length The number of bytes.
+ *  @return size_t The number of characters written (not counting the '\0').
+ */
+size_t base64_encode_scalar(char *destination, const unsigned char *source, size_t length) {
+
+  char *out = destination;
+
+  // Encode whole 3 byte groups.
+  while (length >= 3) {
+    uint32_t group = ((uint32_t) source[0] << 16) | ((uint32_t) source[1] << 8) | source[2];
+    out[0] = base64_alphabet[(group >> 18) & 0x3f];
+    out[1] = base64_alphabet[(group >> 12) & 0x3f];
+    out[2] = base64_alphabet[(group >> 6) & 0x3f];
+    out[3] = base64_alphabet[group & 0x3f];
+    source += 3;
+    length -= 3;
+    out += 4;
+  }
+
+  // Encode the last one or two bytes, with padding.
+  if (length > 0) {
+    uint32_t group = (uint32_t) source[0] << 16;
+    if (length == 2) {
+      group |= (uint32_t) source[1] << 8;
+    }
+    out[0] = base64_alphabet[(group >> 18) & 0x3f];
+    out[1] = base64_alphabet[(group >> 12) & 0x3f];
+    out[2] = (length == 2) ? base64_alphabet[(group >> 6) & 0x3f] : '=';
+    out[3] = '=';
+    out += 4;
+  }
+
+  *out = '\0';
+  return (size_t) (out - destination);
+
+}
+
+#ifdef BASE64_HAVE_X86
+
+/*
+ *  Split 12 bytes (in the low 12 lanes) into 16 six bit indices,
+ *  and map those to ASCII. This is the 128 bit half of the
+ *  vector encoder, shared by the SSSE3 and AVX2 paths.
+ *
+ *  @param __m128i input The bytes to encode.
+ *  @return __m128i The 16 characters.
+ */
+__attribute__((target("ssse3")))
+static inline __m128i base64_encode_block_ssse3(__m128i input) {
+
+  // Arrange each 3 byte group as [b1, b0, b2, b1], so every
+  // 6 bit index sits inside one of two 16 bit lanes.
+  input = _mm_shuffle_epi8(input, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+  // Shift the four indices of each group into their own bytes.
+  __m128i high = _mm_mulhi_epu16(_mm_and_si128(input, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+  __m128i low = _mm_mullo_epi16(_mm_and_si128(input, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+  __m128i indices = _mm_or_si128(high, low);
+
+  // Work out which range of the alphabet each index falls in,
+  // then add the matching offset to turn it into ASCII.
+  __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  __m128i is_upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+  range = _mm_or_si128(range, _mm_and_si128(is_upper, _mm_set1_epi8(13)));
+  __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                  '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                  '/' - 63, 'A', 0, 0);
+  return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range));
+
+}
+
+/*
+ *  Encode bytes 12 at a time with SSSE3.
+ *
+ *  @param char *destination Where to write the characters.
+ *  @param unsigned char *source The bytes to encode.
+ *  @param size_t length The number of bytes.
+ *  @return size_t The number of characters written (not counting the '\0').
+ */
+__attribute__((target("ssse3")))
+static size_t base64_encode_ssse3(char *destination, const unsigned char *source, size_t length) {
+
+  char *out = destination;
+
+  // Each step loads 16 bytes but only consumes 12,
+  // so stop while there are still 16 readable.
+  while (length >= 16) {
+    __m128i input = _mm_loadu_si128((const __m128i *) source);
+    _mm_storeu_si128((__m128i *) out, base64_encode_block_ssse3(input));
+    source += 12;
+    length -= 12;
+    out += 16;
+  }
+
+  return (size_t) (out - destination) + base64_encode_scalar(out, source, length);
+
+}
+
+/*
+ *  Encode bytes 24 at a time with AVX2.
+ *
+ *  @param char *destination Where to write the characters.
+ *  @param unsigned char *source The bytes to encode.
+ *  @param size_t length The number of bytes.
+ *  @return size_t The number of characters written (not counting the '\0').
+ */
+__attribute__((target("avx2")))
+static size_t base64_encode_avx2(char *destination, const unsigned char *source, size_t length) {
+
+  char *out = destination;
+
+  // Each 128 bit lane gets its own 12 byte group. The second
+  // load reads 16 bytes starting at +12, so we need 28 readable.
+  while (length >= 28) {
+    __m256i input = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) source)),
+      _mm_loadu_si128((const __m128i *) (source + 12)), 1);
+
+    input = _mm256_shuffle_epi8(input, _mm256_set_epi8(
+      10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+      10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    __m256i high = _mm256_mulhi_epu16(_mm256_and_si256(input, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+    __m256i low = _mm256_mullo_epi16(_mm256_and_si256(input, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+    __m256i indices = _mm256_or_si256(high, low);
+
+    __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    __m256i is_upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    range = _mm256_or_si256(range, _mm256_and_si256(is_upper, _mm256_set1_epi8(13)));
+    __m256i offsets = _mm256_setr_epi8(
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    __m256i result = _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, range));
+
+    _mm256_storeu_si256((__m256i *) out, result);
+    source += 24;
+    length -= 24;
+    out += 32;
+  }
+
+  return (size_t) (out - destination) + base64_encode_ssse3(out, source, length);
+
+}
+
+#endif
+
+/*
+ *  Encode bytes with the fastest encoder this CPU supports.
+ *
+ *  @param char *destination Where to write the characters. It must have room
+ *                           for BASE64_ENCODED_LENGTH(length) + 1 characters.
+ *  @param unsigned char *source The bytes to encode.
+ *  @param size_t length The number of bytes.
+ *  @return size_t The number of characters written (not counting the '\0').
+ */
+size_t base64_encode(char *destination, const unsigned char *source, size_t length) {
+#ifdef BASE64_HAVE_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return base64_encode_avx2(destination, source, length);
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return base64_encode_ssse3(destination, source, length);
+  }
+#endif
+  return base64_encode_scalar(destination, source, length);
+}
+
+/*
+ *  Name the encoder that `base64_encode()` will use on this CPU.
+ *
+ *  @return char * "avx2", "ssse3" or "scalar".
+ */
+const char *base64_implementation(void) {
+#ifdef BASE64_HAVE_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return "avx2";
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return "ssse3";
+  }
+#endif
+  return "scalar";
+}
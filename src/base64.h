@@ -0,0 +1,47 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for base64.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef BASE64_H
+#define BASE64_H
+
+// For `size_t`.
+#include <stddef.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// How many characters (not counting the null terminator)
+// it takes to encode `length` bytes.
+#define BASE64_ENCODED_LENGTH(length) ((((length) + 2) / 3) * 4)
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in base64.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+size_t base64_encode(char *destination, const unsigned char *source, size_t length);
+size_t base64_encode_scalar(char *destination, const unsigned char *source, size_t length);
+const char *base64_implementation(void);
+
+#endif
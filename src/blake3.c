@@ -0,0 +1,338 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides the BLAKE3 hash (32 byte output,
+ *    no key), computed in one shot over a whole buffer.
+ *
+ *    BLAKE3 splits its input into 1 KiB chunks, and hashes
+ *    them as the leaves of a binary tree. Every subtree can
+ *    be hashed on its own, so for big files (videos, fonts)
+ *    we hand left subtrees to other threads while this one
+ *    works on the right, and join their chaining values
+ *    on the way back up.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// For fixed width integers, e.g., `uint32_t`.
+#include <stdint.h>
+
+// For working with memory, e.g., `memcpy()`.
+#include <string.h>
+
+// We hash subtrees on other threads.
+#include <pthread.h>
+
+// We need the header that declares the prototypes for this file.
+#include "blake3.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define BLAKE3_BLOCK_LENGTH 64
+
+// The domain flags.
+#define BLAKE3_CHUNK_START 1
+#define BLAKE3_CHUNK_END 2
+#define BLAKE3_PARENT 4
+#define BLAKE3_ROOT 8
+
+// Rotate a 32 bit word right.
+#define BLAKE3_ROTATE(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+// The initial chaining value (the same as sha256's).
+static const uint32_t blake3_iv[8] = {
+  0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+  0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+// The order message words are used in, for each of the 7 rounds.
+static const unsigned char blake3_schedule[7][16] = {
+  { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+  { 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 },
+  { 3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1 },
+  { 10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6 },
+  { 12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4 },
+  { 9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7 },
+  { 11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13 }
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// A subtree for another thread to hash.
+struct blake3_subtree {
+  const unsigned char *data;
+  size_t length;
+  uint64_t chunk_counter;
+  int threads;
+  uint32_t chaining_value[8];
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in blake3.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Read a little-endian 32 bit word.
+ *
+ *  @param unsigned char *bytes The 4 bytes to read.
+ *  @return uint32_t The word.
+ */
+static uint32_t blake3_read_word(const unsigned char *bytes) {
+  return (uint32_t) bytes[0]
+    | ((uint32_t) bytes[1] << 8)
+    | ((uint32_t) bytes[2] << 16)
+    | ((uint32_t) bytes[3] << 24);
+}
+
+/*
+ *  The quarter-round mixing function.
+ *
+ *  @param uint32_t state[] The state.
+ *  @param int a, b, c, d Which words of the state to mix.
+ *  @param uint32_t x, y The message words to mix in.
+ *  @return void
+ */
+static void blake3_mix(uint32_t state[16], int a, int b, int c, int d, uint32_t x, uint32_t y) {
+  state[a] = state[a] + state[b] + x;
+  state[d] = BLAKE3_ROTATE(state[d] ^ state[a], 16);
+  state[c] = state[c] + state[d];
+  state[b] = BLAKE3_ROTATE(state[b] ^ state[c], 12);
+  state[a] = state[a] + state[b] + y;
+  state[d] = BLAKE3_ROTATE(state[d] ^ state[a], 8);
+  state[c] = state[c] + state[d];
+  state[b] = BLAKE3_ROTATE(state[b] ^ state[c], 7);
+}
+
+/*
+ *  Compress one block, and store the new chaining value.
+ *
+ *  @param uint32_t chaining_value[] The chaining value (updated in place).
+ *  @param unsigned char *block The 64 byte block (zero padded).
+ *  @param size_t block_length How many bytes of the block are input.
+ *  @param uint64_t counter The chunk counter.
+ *  @param uint32_t flags The domain flags.
+ *  @return void
+ */
+static void blake3_compress(uint32_t chaining_value[8], const unsigned char block[BLAKE3_BLOCK_LENGTH],
+                            size_t block_length, uint64_t counter, uint32_t flags) {
+
+  uint32_t message[16];
+  int i;
+  for (i = 0; i < 16; i++) {
+    message[i] = blake3_read_word(block + 4 * i);
+  }
+
+  uint32_t state[16] = {
+    chaining_value[0], chaining_value[1], chaining_value[2], chaining_value[3],
+    chaining_value[4], chaining_value[5], chaining_value[6], chaining_value[7],
+    blake3_iv[0], blake3_iv[1], blake3_iv[2], blake3_iv[3],
+    (uint32_t) counter, (uint32_t) (counter >> 32), (uint32_t) block_length, flags
+  };
+
+  int round;
+  for (round = 0; round < 7; round++) {
+    const unsigned char *s = blake3_schedule[round];
+    blake3_mix(state, 0, 4, 8, 12, message[s[0]], message[s[1]]);
+    blake3_mix(state, 1, 5, 9, 13, message[s[2]], message[s[3]]);
+    blake3_mix(state, 2, 6, 10, 14, message[s[4]], message[s[5]]);
+    blake3_mix(state, 3, 7, 11, 15, message[s[6]], message[s[7]]);
+    blake3_mix(state, 0, 5, 10, 15, message[s[8]], message[s[9]]);
+    blake3_mix(state, 1, 6, 11, 12, message[s[10]], message[s[11]]);
+    blake3_mix(state, 2, 7, 8, 13, message[s[12]], message[s[13]]);
+    blake3_mix(state, 3, 4, 9, 14, message[s[14]], message[s[15]]);
+  }
+
+  for (i = 0; i < 8; i++) {
+    chaining_value[i] = state[i] ^ state[i + 8];
+  }
+
+}
+
+/*
+ *  Hash one chunk (up to 1 KiB) to its chaining value.
+ *
+ *  @param unsigned char *data The chunk.
+ *  @param size_t length The length of the chunk.
+ *  @param uint64_t chunk_counter The chunk's index in the input.
+ *  @param uint32_t root_flag BLAKE3_ROOT if this chunk is the whole input, 0 if not.
+ *  @param uint32_t chaining_value[] Where to store the result.
+ *  @return void
+ */
+static void blake3_chunk(const unsigned char *data, size_t length, uint64_t chunk_counter,
+                         uint32_t root_flag, uint32_t chaining_value[8]) {
+
+  memcpy(chaining_value, blake3_iv, sizeof(blake3_iv));
+
+  // Every chunk has at least one block, even an empty one.
+  uint32_t flags = BLAKE3_CHUNK_START;
+  do {
+    size_t block_length = length < BLAKE3_BLOCK_LENGTH ? length : BLAKE3_BLOCK_LENGTH;
+    unsigned char block[BLAKE3_BLOCK_LENGTH] = { 0 };
+    if (block_length > 0) {
+      memcpy(block, data, block_length);
+    }
+    data += block_length;
+    length -= block_length;
+    if (length == 0) {
+      flags |= BLAKE3_CHUNK_END | root_flag;
+    }
+    blake3_compress(chaining_value, block, block_length, chunk_counter, flags);
+    flags = 0;
+  } while (length > 0);
+
+}
+
+/*
+ *  Join two children's chaining values into their parent's.
+ *
+ *  @param uint32_t left[] The left child.
+ *  @param uint32_t right[] The right child.
+ *  @param uint32_t root_flag BLAKE3_ROOT if this is the root, 0 if not.
+ *  @param uint32_t chaining_value[] Where to store the result.
+ *  @return void
+ */
+static void blake3_parent(const uint32_t left[8], const uint32_t right[8],
+                          uint32_t root_flag, uint32_t chaining_value[8]) {
+  unsigned char block[BLAKE3_BLOCK_LENGTH];
+  int i;
+  for (i = 0; i < 8; i++) {
+    int j;
+    for (j = 0; j < 4; j++) {
+      block[4 * i + j] = (unsigned char) (left[i] >> (8 * j));
+      block[32 + 4 * i + j] = (unsigned char) (right[i] >> (8 * j));
+    }
+  }
+  memcpy(chaining_value, blake3_iv, sizeof(blake3_iv));
+  blake3_compress(chaining_value, block, BLAKE3_BLOCK_LENGTH, 0, BLAKE3_PARENT | root_flag);
+}
+
+/*
+ *  How much of an input (of more than one chunk) goes in the
+ *  left subtree: the largest power of two chunks that leaves
+ *  something for the right.
+ *
+ *  @param size_t length The length of the input.
+ *  @return size_t The length of the left subtree.
+ */
+static size_t blake3_left_length(size_t length) {
+  size_t chunks = (length - 1) / BLAKE3_CHUNK_LENGTH;
+  size_t left_chunks = 1;
+  while (left_chunks * 2 <= chunks) {
+    left_chunks *= 2;
+  }
+  return left_chunks * BLAKE3_CHUNK_LENGTH;
+}
+
+static void *blake3_subtree_thread(void *argument);
+
+/*
+ *  Hash a subtree to its chaining value, maybe sharing it with other threads.
+ *
+ *  @param unsigned char *data The subtree's input.
+ *  @param size_t length The length of the input.
+ *  @param uint64_t chunk_counter The index of the subtree's first chunk.
+ *  @param uint32_t root_flag BLAKE3_ROOT if this is the whole input, 0 if not.
+ *  @param int threads How many threads (including this one) may work on it.
+ *  @param uint32_t chaining_value[] Where to store the result.
+ *  @return void
+ */
+static void blake3_subtree(const unsigned char *data, size_t length, uint64_t chunk_counter,
+                           uint32_t root_flag, int threads, uint32_t chaining_value[8]) {
+
+  if (length <= BLAKE3_CHUNK_LENGTH) {
+    blake3_chunk(data, length, chunk_counter, root_flag, chaining_value);
+    return;
+  }
+
+  size_t left_length = blake3_left_length(length);
+  struct blake3_subtree left;
+  left.data = data;
+  left.length = left_length;
+  left.chunk_counter = chunk_counter;
+  left.threads = threads / 2;
+  uint32_t right[8];
+
+  // Hand the left half to another thread, if it's worth it.
+  pthread_t thread;
+  int forked = threads > 1
+    && left_length >= BLAKE3_MIN_PARALLEL_LENGTH
+    && pthread_create(&thread, NULL, blake3_subtree_thread, &left) == 0;
+
+  blake3_subtree(data + left_length, length - left_length,
+                 chunk_counter + left_length / BLAKE3_CHUNK_LENGTH, 0,
+                 forked ? threads - threads / 2 : 1, right);
+
+  if (forked) {
+    pthread_join(thread, NULL);
+  } else {
+    blake3_subtree(left.data, left.length, left.chunk_counter, 0, 1, left.chaining_value);
+  }
+
+  blake3_parent(left.chaining_value, right, root_flag, chaining_value);
+
+}
+
+/*
+ *  Hash a subtree on another thread.
+ *
+ *  @param void *argument The `struct blake3_subtree` to hash.
+ *  @return void * Nothing.
+ */
+static void *blake3_subtree_thread(void *argument) {
+  struct blake3_subtree *subtree = argument;
+  blake3_subtree(subtree->data, subtree->length, subtree->chunk_counter, 0,
+                 subtree->threads, subtree->chaining_value);
+  return NULL;
+}
+
+/*
+ *  Get the BLAKE3 hash of some bytes.
+ *
+ *  @param unsigned char *data The bytes.
+ *  @param size_t length The number of bytes.
+ *  @param int threads How many threads may work on it (1 for just this one).
+ *  @param unsigned char digest[] The variable to store the 32 byte digest in.
+ *  @return void
+ */
+void blake3(const unsigned char *data, size_t length, int threads, unsigned char digest[BLAKE3_DIGEST_LENGTH]) {
+  uint32_t chaining_value[8];
+  blake3_subtree(data, length, 0, BLAKE3_ROOT, threads, chaining_value);
+  int i;
+  for (i = 0; i < 8; i++) {
+    digest[4 * i] = (unsigned char) chaining_value[i];
+    digest[4 * i + 1] = (unsigned char) (chaining_value[i] >> 8);
+    digest[4 * i + 2] = (unsigned char) (chaining_value[i] >> 16);
+    digest[4 * i + 3] = (unsigned char) (chaining_value[i] >> 24);
+  }
+}
@@ -0,0 +1,46 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for blake3.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef BLAKE3_H
+#define BLAKE3_H
+
+// For `size_t`.
+#include <stddef.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define BLAKE3_DIGEST_LENGTH 32
+#define BLAKE3_CHUNK_LENGTH 1024
+
+// Subtrees smaller than this are never handed to another thread.
+#define BLAKE3_MIN_PARALLEL_LENGTH (512 * 1024)
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in blake3.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void blake3(const unsigned char *data, size_t length, int threads, unsigned char digest[BLAKE3_DIGEST_LENGTH]);
+
+#endif
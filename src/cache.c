@@ -0,0 +1,436 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides the hash cache (`--cache <file>`).
+ *
+ *    The cache remembers each file's hash (and base64, if it
+ *    was encoded) keyed by device and inode, and reuses them
+ *    on the next run if the file's size and mtime (to the
+ *    nanosecond) haven't changed.
+ *
+ *    The file is a fixed header, then fixed-width records
+ *    sorted by (device, inode), then the base64 strings.
+ *    It's mapped into memory and searched in place, so loading
+ *    it costs nothing per entry. A fresh cache holding just
+ *    the files seen in this run is written to a temporary
+ *    file at the end and renamed over the old one.
+ *
+ *    Files modified within CACHE_RACY_WINDOW_NS of the run
+ *    that cached them are never trusted: they could have been
+ *    changed again within the same timestamp tick.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `memcmp()`.
+#include <string.h>
+
+// For `open()`.
+#include <fcntl.h>
+
+// For `close()` and `getpid()`.
+#include <unistd.h>
+
+// For `mmap()`.
+#include <sys/mman.h>
+
+// For `clock_gettime()`.
+#include <time.h>
+
+// For the mutex that guards new records.
+#include <pthread.h>
+
+// A cache is only good for the hash algorithm it was made with.
+#include "digest.h"
+
+// We need the header that declares the prototypes for this file.
+#include "cache.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define CACHE_RACY_WINDOW_NS 2000000000LL
+#define INITIAL_NEW_RECORDS 1024
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// A record gathered during this run, waiting to be saved.
+struct new_record {
+  struct cache_record record;
+  char *base64;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  NON-CONSTANT VARIABLES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The path to the cache file (NULL if there's no cache).
+const char *cache_file_path = NULL;
+
+// The mapped cache from the last run.
+void *cache_map = NULL;
+size_t cache_map_length = 0;
+const struct cache_header *cache_header = NULL;
+const struct cache_record *cache_records = NULL;
+const char *cache_strings = NULL;
+
+// When this run started.
+int64_t run_started_ns = 0;
+
+// The records gathered during this run.
+struct new_record *new_records = NULL;
+size_t new_record_count = 0;
+size_t new_record_capacity = 0;
+pthread_mutex_t new_records_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in cache.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Set the path to the cache file, which turns the cache on.
+ *
+ *  @param char *path The path to the file.
+ *  @return void
+ */
+void set_cache_file(const char *path) {
+  cache_file_path = path;
+}
+
+/*
+ *  Is the cache turned on?
+ *
+ *  @return int 1 if yes, 0 if no.
+ */
+int cache_is_enabled(void) {
+  return cache_file_path != NULL;
+}
+
+/*
+ *  Get a file's mtime in nanoseconds.
+ *
+ *  @param struct stat *info Info about the file returned by `stat()`.
+ *  @return int64_t The mtime.
+ */
+static int64_t mtime_ns(struct stat *info) {
+  return (int64_t) info->st_mtim.tv_sec * 1000000000LL + info->st_mtim.tv_nsec;
+}
+
+/*
+ *  Forget a cache file that doesn't look right.
+ *
+ *  @param char *reason Why we're ignoring it.
+ *  @return void
+ */
+static void discard_cache(const char *reason) {
+  fprintf(stderr, "Ignoring cache file %s: %s\n", cache_file_path, reason);
+  munmap(cache_map, cache_map_length);
+  cache_map = NULL;
+  cache_header = NULL;
+  cache_records = NULL;
+  cache_strings = NULL;
+}
+
+/*
+ *  Map the cache file from the last run, if there is one.
+ *
+ *  @return void
+ */
+void load_cache(void) {
+
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  run_started_ns = (int64_t) now.tv_sec * 1000000000LL + now.tv_nsec;
+
+  if (!cache_is_enabled()) {
+    return;
+  }
+
+  // No cache yet is fine: this run will create one.
+  int descriptor = open(cache_file_path, O_RDONLY);
+  if (descriptor < 0) {
+    return;
+  }
+
+  struct stat info;
+  if (fstat(descriptor, &info) != 0 || info.st_size < (off_t) sizeof(struct cache_header)) {
+    close(descriptor);
+    return;
+  }
+
+  cache_map_length = (size_t) info.st_size;
+  cache_map = mmap(NULL, cache_map_length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  close(descriptor);
+  if (cache_map == MAP_FAILED) {
+    cache_map = NULL;
+    return;
+  }
+
+  // Check it's a cache file we understand, and that it isn't truncated.
+  cache_header = cache_map;
+  if (memcmp(cache_header->magic, CACHE_MAGIC, sizeof(cache_header->magic)) != 0
+      || cache_header->version != CACHE_VERSION
+      || cache_header->record_size != sizeof(struct cache_record)) {
+    discard_cache("not a cache file from this version");
+    return;
+  }
+  size_t records_length = cache_header->record_count * sizeof(struct cache_record);
+  if (cache_header->record_count > cache_map_length / sizeof(struct cache_record)
+      || sizeof(struct cache_header) + records_length + cache_header->strings_length != cache_map_length) {
+    discard_cache("the file is damaged");
+    return;
+  }
+  if (cache_header->algorithm != (uint32_t) get_digest_algorithm()) {
+    discard_cache("it holds hashes from a different --hash algorithm");
+    return;
+  }
+
+  cache_records = (const struct cache_record *) ((const char *) cache_map + sizeof(struct cache_header));
+  cache_strings = (const char *) cache_records + records_length;
+
+}
+
+/*
+ *  Compare two records by (device, inode).
+ *
+ *  @param void *a The first record.
+ *  @param void *b The second record.
+ *  @return int <0, 0 or >0.
+ */
+static int compare_records(const struct cache_record *a, const struct cache_record *b) {
+  if (a->device != b->device) {
+    return a->device < b->device ? -1 : 1;
+  }
+  if (a->inode != b->inode) {
+    return a->inode < b->inode ? -1 : 1;
+  }
+  return 0;
+}
+
+/*
+ *  Look a file up in the cache from the last run.
+ *
+ *  @param struct stat *info Info about the file returned by `stat()`.
+ *  @param struct cache_hit *hit Where to store what we found.
+ *  @return int 1 if the file is cached and unchanged, 0 if not.
+ */
+int cache_lookup(struct stat *info, struct cache_hit *hit) {
+
+  if (cache_records == NULL) {
+    return 0;
+  }
+
+  struct cache_record key;
+  key.device = (uint64_t) info->st_dev;
+  key.inode = (uint64_t) info->st_ino;
+
+  // Binary search the sorted records.
+  size_t low = 0;
+  size_t high = cache_header->record_count;
+  while (low < high) {
+
+    size_t middle = low + (high - low) / 2;
+    const struct cache_record *record = &cache_records[middle];
+    int order = compare_records(&key, record);
+
+    if (order < 0) {
+      high = middle;
+    } else if (order > 0) {
+      low = middle + 1;
+    }
+
+    // Found it. Only trust it if the file hasn't changed,
+    // and wasn't modified too close to when it was cached.
+    else {
+      if (record->size != (int64_t) info->st_size
+          || record->mtime_ns != mtime_ns(info)
+          || record->mtime_ns > cache_header->written_at_ns - CACHE_RACY_WINDOW_NS
+          || record->hash[CACHE_HASH_LENGTH - 1] != '\0') {
+        return 0;
+      }
+      if (record->has_base64
+          && record->base64_offset + record->base64_length > cache_header->strings_length) {
+        return 0;
+      }
+      hit->hash = record->hash;
+      hit->has_base64 = record->has_base64;
+      hit->base64 = cache_strings + record->base64_offset;
+      hit->base64_length = record->base64_length;
+      return 1;
+    }
+
+  }
+
+  return 0;
+
+}
+
+/*
+ *  Remember a file's hash (and base64) for the next run.
+ *
+ *  @param struct stat *info Info about the file returned by `stat()`.
+ *  @param char *hash The file's hash.
+ *  @param char *base64 The file's base64 string (if it has one).
+ *  @param size_t base64_length The length of the base64 string.
+ *  @param int has_base64 1 if the file was base64 encoded, 0 if not.
+ *  @return void
+ */
+void cache_remember(struct stat *info, const char *hash, const char *base64, size_t base64_length, int has_base64) {
+
+  if (!cache_is_enabled()) {
+    return;
+  }
+
+  struct new_record entry;
+  memset(&entry.record, 0, sizeof(entry.record));
+  entry.record.device = (uint64_t) info->st_dev;
+  entry.record.inode = (uint64_t) info->st_ino;
+  entry.record.size = (int64_t) info->st_size;
+  entry.record.mtime_ns = mtime_ns(info);
+  strncpy(entry.record.hash, hash, CACHE_HASH_LENGTH - 1);
+  entry.record.has_base64 = has_base64 ? 1 : 0;
+  entry.record.base64_length = has_base64 ? (uint32_t) base64_length : 0;
+  entry.base64 = NULL;
+  if (has_base64) {
+    entry.base64 = malloc(base64_length);
+    if (entry.base64 == NULL) {
+      puts("malloc failure, wtf");
+      exit(1);
+    }
+    memcpy(entry.base64, base64, base64_length);
+  }
+
+  pthread_mutex_lock(&new_records_lock);
+  if (new_record_count == new_record_capacity) {
+    new_record_capacity = new_record_capacity ? new_record_capacity * 2 : INITIAL_NEW_RECORDS;
+    new_records = realloc(new_records, new_record_capacity * sizeof(struct new_record));
+    if (new_records == NULL) {
+      puts("malloc failure, wtf");
+      exit(1);
+    }
+  }
+  new_records[new_record_count++] = entry;
+  pthread_mutex_unlock(&new_records_lock);
+
+}
+
+/*
+ *  Compare two new records by (device, inode), for `qsort()`.
+ *
+ *  @param void *a The first record.
+ *  @param void *b The second record.
+ *  @return int <0, 0 or >0.
+ */
+static int compare_new_records(const void *a, const void *b) {
+  return compare_records(&((const struct new_record *) a)->record, &((const struct new_record *) b)->record);
+}
+
+/*
+ *  Write out everything we saw in this run as the new cache.
+ *
+ *  @return void
+ */
+void save_cache(void) {
+
+  if (!cache_is_enabled()) {
+    return;
+  }
+
+  // Sort the records, and work out where each base64 string goes.
+  qsort(new_records, new_record_count, sizeof(struct new_record), compare_new_records);
+  uint64_t strings_length = 0;
+  size_t i;
+  for (i = 0; i < new_record_count; i++) {
+    new_records[i].record.base64_offset = strings_length;
+    strings_length += new_records[i].record.base64_length;
+  }
+
+  struct cache_header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+  header.version = CACHE_VERSION;
+  header.record_size = sizeof(struct cache_record);
+  header.record_count = new_record_count;
+  header.strings_length = strings_length;
+  header.written_at_ns = run_started_ns;
+  header.algorithm = (uint32_t) get_digest_algorithm();
+
+  // Write to a temporary file, then rename it into place,
+  // so a crash never leaves a half-written cache behind.
+  char temporary_path[strlen(cache_file_path) + 32];
+  snprintf(temporary_path, sizeof(temporary_path), "%s.tmp.%ld", cache_file_path, (long) getpid());
+  FILE *file = fopen(temporary_path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "Could not write the cache file: %s\n", temporary_path);
+    return;
+  }
+
+  int failed = fwrite(&header, sizeof(header), 1, file) != 1;
+  for (i = 0; i < new_record_count && !failed; i++) {
+    failed = fwrite(&new_records[i].record, sizeof(struct cache_record), 1, file) != 1;
+  }
+  for (i = 0; i < new_record_count && !failed; i++) {
+    size_t length = new_records[i].record.base64_length;
+    failed = length > 0 && fwrite(new_records[i].base64, 1, length, file) != length;
+  }
+  failed = (fclose(file) != 0) || failed;
+
+  if (failed || rename(temporary_path, cache_file_path) != 0) {
+    fprintf(stderr, "Could not write the cache file: %s\n", cache_file_path);
+    remove(temporary_path);
+  }
+
+  // Let go of everything.
+  for (i = 0; i < new_record_count; i++) {
+    free(new_records[i].base64);
+  }
+  free(new_records);
+  new_records = NULL;
+  new_record_count = 0;
+  new_record_capacity = 0;
+  if (cache_map != NULL) {
+    munmap(cache_map, cache_map_length);
+    cache_map = NULL;
+  }
+
+}
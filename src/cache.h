@@ -0,0 +1,96 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for cache.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef CACHE_H
+#define CACHE_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For fixed width integers, e.g., `uint64_t`.
+#include <stdint.h>
+
+// For `struct stat`.
+#include <sys/stat.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define CACHE_MAGIC "ASSETSC1"
+#define CACHE_VERSION 2
+#define CACHE_HASH_LENGTH 72
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The header at the start of a cache file.
+struct cache_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint64_t record_count;
+  uint64_t strings_length;
+  int64_t written_at_ns;
+  uint32_t algorithm;
+  uint32_t padding;
+};
+
+// One cached file. Records are sorted by (device, inode), and
+// `base64_offset` points into the string area after the records.
+struct cache_record {
+  uint64_t device;
+  uint64_t inode;
+  int64_t size;
+  int64_t mtime_ns;
+  char hash[CACHE_HASH_LENGTH];
+  uint64_t base64_offset;
+  uint32_t base64_length;
+  uint32_t has_base64;
+};
+
+// What a cache lookup found.
+struct cache_hit {
+  const char *hash;
+  const char *base64;
+  size_t base64_length;
+  int has_base64;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in cache.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void set_cache_file(const char *path);
+int cache_is_enabled(void);
+void load_cache(void);
+int cache_lookup(struct stat *info, struct cache_hit *hit);
+void cache_remember(struct stat *info, const char *hash, const char *base64, size_t base64_length, int has_base64);
+void save_cache(void);
+
+#endif
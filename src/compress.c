@@ -0,0 +1,392 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file compresses the output as it's written
+ *    (`--compress gzip|zstd`, or an output file ending
+ *    in .gz or .zst).
+ *
+ *    The compression runs on a thread of its own, so it overlaps
+ *    with the walk and the hashing. The output sink fills one
+ *    buffer while the thread compresses and writes the other:
+ *    when the sink's buffer is full, it hands it over with
+ *    `compress_buffer()` and gets the other one back (once the
+ *    thread is done with it) to fill next.
+ *
+ *    gzip uses zlib. zstd needs libzstd, and is only built in
+ *    with `make ZSTD=1` (which defines ASSETS_ZSTD).
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `strcmp()`.
+#include <string.h>
+
+// For `errno` and `strerror()`.
+#include <errno.h>
+
+// For `write()`.
+#include <unistd.h>
+
+// For the compressing thread.
+#include <pthread.h>
+
+// For gzip.
+#include <zlib.h>
+
+// For zstd (if it's built in).
+#ifdef ASSETS_ZSTD
+#include <zstd.h>
+#endif
+
+// We time the compression (`--stats`) with these.
+#include "stats.h"
+
+// We need the header that declares the prototypes for this file.
+#include "compress.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+struct compressor {
+  int method;
+  int descriptor;
+  const char *name;
+
+  // The stream, and where its output is built up.
+  z_stream gzip;
+#ifdef ASSETS_ZSTD
+  ZSTD_CCtx *zstd;
+#endif
+  char *output;
+
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+
+  // The buffer the thread is compressing (if `has_pending`),
+  // and the one it's done with, for the sink to fill next.
+  char *pending;
+  size_t pending_length;
+  int has_pending;
+  char *spare;
+
+  // Set once the sink has handed over its last buffer.
+  int finishing;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in compress.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Find a compression method by name.
+ *
+ *  @param char *name The name ("gzip", "zstd" or "none").
+ *  @return int The method, or -1 if there's no such method.
+ */
+int find_compression(const char *name) {
+  if (strcmp(name, "gzip") == 0) {
+    return COMPRESS_GZIP;
+  } else if (strcmp(name, "zstd") == 0) {
+    return COMPRESS_ZSTD;
+  } else if (strcmp(name, "none") == 0) {
+    return COMPRESS_NONE;
+  }
+  return -1;
+}
+
+/*
+ *  Work out how to compress a file from its extension.
+ *
+ *  @param char *path The path to the file.
+ *  @return int COMPRESS_GZIP for .gz, COMPRESS_ZSTD for .zst,
+ *              and COMPRESS_NONE for anything else.
+ */
+int compression_for_path(const char *path) {
+  size_t length = strlen(path);
+  if (length > 3 && strcmp(path + length - 3, ".gz") == 0) {
+    return COMPRESS_GZIP;
+  } else if (length > 4 && strcmp(path + length - 4, ".zst") == 0) {
+    return COMPRESS_ZSTD;
+  }
+  return COMPRESS_NONE;
+}
+
+/*
+ *  Is a compression method built in?
+ *
+ *  @param int method The method.
+ *  @return int 1 if yes, 0 if no.
+ */
+int compression_is_available(int method) {
+#ifndef ASSETS_ZSTD
+  if (method == COMPRESS_ZSTD) {
+    return 0;
+  }
+#endif
+  return 1;
+}
+
+/*
+ *  Report a failure to compress or write the output, and exit.
+ *
+ *  @param struct compressor *compressor The compressor.
+ *  @param char *what What went wrong.
+ *  @return void
+ */
+static void compressor_failed(struct compressor *compressor, const char *what) {
+  fprintf(stderr, "Could not %s this file: %s\n", what, compressor->name);
+  exit(1);
+}
+
+/*
+ *  Write compressed bytes out, retrying short writes.
+ *
+ *  @param struct compressor *compressor The compressor.
+ *  @param size_t length How many bytes of its output to write.
+ *  @return void
+ */
+static void write_output(struct compressor *compressor, size_t length) {
+  const char *data = compressor->output;
+  while (length > 0) {
+    ssize_t written = write(compressor->descriptor, data, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fprintf(stderr, "Could not write to this file: %s (%s)\n", compressor->name, strerror(errno));
+      exit(1);
+    }
+    data += written;
+    length -= (size_t) written;
+  }
+}
+
+/*
+ *  Compress some bytes and write out what comes of it.
+ *
+ *  @param struct compressor *compressor The compressor.
+ *  @param char *data The bytes.
+ *  @param size_t length The number of bytes.
+ *  @param int finish 1 to end the stream after them, 0 not to.
+ *  @return void
+ */
+static void compress_bytes(struct compressor *compressor, const char *data, size_t length, int finish) {
+
+  uint64_t started = start_timer();
+
+#ifdef ASSETS_ZSTD
+  if (compressor->method == COMPRESS_ZSTD) {
+    ZSTD_inBuffer in = { data, length, 0 };
+    size_t remaining;
+    do {
+      ZSTD_outBuffer out = { compressor->output, COMPRESS_OUTPUT_LENGTH, 0 };
+      remaining = ZSTD_compressStream2(compressor->zstd, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+      if (ZSTD_isError(remaining)) {
+        compressor_failed(compressor, "compress");
+      }
+      write_output(compressor, out.pos);
+    } while (finish ? remaining != 0 : in.pos < in.size);
+    stop_timer(PHASE_COMPRESS, started);
+    return;
+  }
+#endif
+
+  // zlib wants a non-const pointer, but doesn't write through it.
+  compressor->gzip.next_in = (Bytef *) data;
+  compressor->gzip.avail_in = (uInt) length;
+  do {
+    compressor->gzip.next_out = (Bytef *) compressor->output;
+    compressor->gzip.avail_out = COMPRESS_OUTPUT_LENGTH;
+    if (deflate(&compressor->gzip, finish ? Z_FINISH : Z_NO_FLUSH) == Z_STREAM_ERROR) {
+      compressor_failed(compressor, "compress");
+    }
+    write_output(compressor, COMPRESS_OUTPUT_LENGTH - compressor->gzip.avail_out);
+  } while (compressor->gzip.avail_out == 0);
+
+  stop_timer(PHASE_COMPRESS, started);
+
+}
+
+/*
+ *  The main loop of the compressing thread: compress each
+ *  buffer the sink hands over, then end the stream.
+ *
+ *  @param void *argument The compressor.
+ *  @return void * Nothing.
+ */
+static void *compressor_loop(void *argument) {
+
+  struct compressor *compressor = argument;
+
+  pthread_mutex_lock(&compressor->lock);
+  for (;;) {
+
+    while (!compressor->has_pending && !compressor->finishing) {
+      pthread_cond_wait(&compressor->changed, &compressor->lock);
+    }
+    if (!compressor->has_pending) {
+      break;
+    }
+
+    // The buffer is ours until we give it back as the spare.
+    pthread_mutex_unlock(&compressor->lock);
+    compress_bytes(compressor, compressor->pending, compressor->pending_length, 0);
+    pthread_mutex_lock(&compressor->lock);
+
+    compressor->spare = compressor->pending;
+    compressor->pending = NULL;
+    compressor->has_pending = 0;
+    pthread_cond_broadcast(&compressor->changed);
+
+  }
+  pthread_mutex_unlock(&compressor->lock);
+
+  compress_bytes(compressor, NULL, 0, 1);
+  return NULL;
+
+}
+
+/*
+ *  Start compressing everything written to a descriptor.
+ *
+ *  @param int method COMPRESS_GZIP or COMPRESS_ZSTD.
+ *  @param int descriptor Where the compressed bytes go.
+ *  @param char *name The name of the output (for errors).
+ *  @param size_t buffer_length The size of the sink's buffers.
+ *  @return struct compressor* The compressor.
+ */
+struct compressor *start_compressor(int method, int descriptor, const char *name, size_t buffer_length) {
+
+  struct compressor *compressor = malloc(sizeof(struct compressor));
+  if (compressor == NULL) {
+    fprintf(stderr, "malloc failure, wtf\n");
+    exit(1);
+  }
+  memset(compressor, 0, sizeof(struct compressor));
+  compressor->method = method;
+  compressor->descriptor = descriptor;
+  compressor->name = name;
+  compressor->output = malloc(COMPRESS_OUTPUT_LENGTH);
+  compressor->spare = malloc(buffer_length);
+  if (compressor->output == NULL || compressor->spare == NULL) {
+    fprintf(stderr, "malloc failure, wtf\n");
+    exit(1);
+  }
+
+#ifdef ASSETS_ZSTD
+  if (method == COMPRESS_ZSTD) {
+    compressor->zstd = ZSTD_createCCtx();
+    if (compressor->zstd == NULL) {
+      compressor_failed(compressor, "compress");
+    }
+  } else
+#endif
+
+  // A window of 15 bits, plus 16 for a gzip header and trailer.
+  if (deflateInit2(&compressor->gzip, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    compressor_failed(compressor, "compress");
+  }
+
+  pthread_mutex_init(&compressor->lock, NULL);
+  pthread_cond_init(&compressor->changed, NULL);
+  if (pthread_create(&compressor->thread, NULL, compressor_loop, compressor) != 0) {
+    fprintf(stderr, "Could not start a compression thread.\n");
+    exit(1);
+  }
+
+  return compressor;
+
+}
+
+/*
+ *  Hand a full buffer to the compressing thread.
+ *
+ *  @param struct compressor *compressor The compressor.
+ *  @param char *data The buffer (it belongs to the compressor now).
+ *  @param size_t length How many bytes are in it.
+ *  @return char* The other buffer, for the sink to fill next.
+ */
+char *compress_buffer(struct compressor *compressor, char *data, size_t length) {
+
+  pthread_mutex_lock(&compressor->lock);
+
+  // Wait until the thread is done with the last buffer.
+  while (compressor->has_pending) {
+    pthread_cond_wait(&compressor->changed, &compressor->lock);
+  }
+
+  char *spare = compressor->spare;
+  compressor->spare = NULL;
+  compressor->pending = data;
+  compressor->pending_length = length;
+  compressor->has_pending = 1;
+  pthread_cond_broadcast(&compressor->changed);
+
+  pthread_mutex_unlock(&compressor->lock);
+
+  return spare;
+
+}
+
+/*
+ *  End the compressed stream, wait for it to be written, and
+ *  free the compressor. The sink's last buffer must already
+ *  have been handed over.
+ *
+ *  @param struct compressor *compressor The compressor.
+ *  @return void
+ */
+void finish_compressor(struct compressor *compressor) {
+
+  pthread_mutex_lock(&compressor->lock);
+  compressor->finishing = 1;
+  pthread_cond_broadcast(&compressor->changed);
+  pthread_mutex_unlock(&compressor->lock);
+  pthread_join(compressor->thread, NULL);
+
+#ifdef ASSETS_ZSTD
+  if (compressor->method == COMPRESS_ZSTD) {
+    ZSTD_freeCCtx(compressor->zstd);
+  } else
+#endif
+  deflateEnd(&compressor->gzip);
+
+  pthread_cond_destroy(&compressor->changed);
+  pthread_mutex_destroy(&compressor->lock);
+  free(compressor->spare);
+  free(compressor->output);
+  free(compressor);
+
+}
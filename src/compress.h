@@ -0,0 +1,67 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for compress.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+// For `size_t`.
+#include <stddef.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// How the output is compressed. COMPRESS_AUTO goes
+// by the output file's extension (.gz or .zst).
+#define COMPRESS_NONE 0
+#define COMPRESS_GZIP 1
+#define COMPRESS_ZSTD 2
+#define COMPRESS_AUTO 3
+
+// How much compressed output is built up before it's written.
+#define COMPRESS_OUTPUT_LENGTH (256 * 1024)
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// A compressing writer, running on a thread of its own.
+struct compressor;
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in compress.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+int find_compression(const char *name);
+int compression_for_path(const char *path);
+int compression_is_available(int method);
+struct compressor *start_compressor(int method, int descriptor, const char *name, size_t buffer_length);
+char *compress_buffer(struct compressor *compressor, char *data, size_t length);
+void finish_compressor(struct compressor *compressor);
+
+#endif
@@ -0,0 +1,189 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file loads a file's contents once, for everything
+ *    that needs them.
+ *
+ *    Small files are read into memory with a single `read()`.
+ *    Big ones are mapped with `mmap()`, and the kernel is told
+ *    we'll go through them in order (`MADV_SEQUENTIAL`), so it
+ *    reads ahead aggressively and drops pages behind us. (Unless
+ *    the caller says not to: touching a mapped page past the end
+ *    of a file that was truncated under us raises SIGBUS.)
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For `errno`.
+#include <errno.h>
+
+// For `open()`.
+#include <fcntl.h>
+
+// For `read()` and `close()`.
+#include <unistd.h>
+
+// For `fstat()`.
+#include <sys/stat.h>
+
+// For `mmap()` and `madvise()`.
+#include <sys/mman.h>
+
+// We count the bytes we read (`--stats`).
+#include "stats.h"
+
+// We need the header that declares the prototypes for this file.
+#include "content.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in content.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Map an open file into memory.
+ *
+ *  @param struct file_content *content Where to put the mapping.
+ *  @param int descriptor The open file.
+ *  @param size_t size The size of the file.
+ *  @return int 1 if it worked, 0 if not.
+ */
+static int map_content(struct file_content *content, int descriptor, size_t size) {
+
+  void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  if (mapping == MAP_FAILED) {
+    return 0;
+  }
+
+  // We only go through it once, front to back.
+  (void) madvise(mapping, size, MADV_SEQUENTIAL);
+
+  content->mapping = mapping;
+  content->data = mapping;
+  content->length = size;
+  return 1;
+
+}
+
+/*
+ *  Read an open file into memory.
+ *
+ *  @param struct file_content *content Where to put the bytes.
+ *  @param int descriptor The open file.
+ *  @param size_t size The size of the file.
+ *  @return int 1 if it worked, 0 if not.
+ */
+static int read_content(struct file_content *content, int descriptor, size_t size) {
+
+  content->buffer = malloc(size > 0 ? size : 1);
+  if (content->buffer == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+
+  // Usually one `read()` gets the lot, but it's allowed to come up short.
+  size_t length = 0;
+  while (length < size) {
+    ssize_t bytes_read = read(descriptor, content->buffer + length, size - length);
+    if (bytes_read < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      free(content->buffer);
+      content->buffer = NULL;
+      return 0;
+    }
+    if (bytes_read == 0) {
+      break;
+    }
+    length += (size_t) bytes_read;
+  }
+
+  content->data = content->buffer;
+  content->length = length;
+  return 1;
+
+}
+
+/*
+ *  Load a file's contents.
+ *
+ *  @param struct file_content *content Where to put the contents.
+ *  @param char *path The path to the file.
+ *  @param int may_map 1 if a big file may be mapped, 0 to always read it.
+ *  @return int 1 if we got them, 0 if the file couldn't be read.
+ */
+int load_file_content(struct file_content *content, const char *path, int may_map) {
+
+  content->data = NULL;
+  content->length = 0;
+  content->mapping = NULL;
+  content->buffer = NULL;
+
+  // Open the file, and find out how big it is now.
+  int descriptor = open(path, O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0) {
+    return 0;
+  }
+  struct stat info;
+  if (fstat(descriptor, &info) != 0) {
+    close(descriptor);
+    return 0;
+  }
+  size_t size = (size_t) info.st_size;
+
+  // Map big files (falling back to reading them if that fails), read small ones.
+  int success = (may_map && size >= CONTENT_MAP_THRESHOLD && map_content(content, descriptor, size))
+    || read_content(content, descriptor, size);
+
+  // A mapping stays valid after the file is closed.
+  close(descriptor);
+
+  if (success) {
+    count(COUNT_BYTES_READ, content->length);
+  }
+  return success;
+
+}
+
+/*
+ *  Let go of a file's contents.
+ *
+ *  @param struct file_content *content The contents.
+ *  @return void
+ */
+void release_file_content(struct file_content *content) {
+  if (content->mapping != NULL) {
+    munmap(content->mapping, content->length);
+  }
+  free(content->buffer);
+  content->data = NULL;
+  content->length = 0;
+  content->mapping = NULL;
+  content->buffer = NULL;
+}
@@ -0,0 +1,63 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for content.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef CONTENT_H
+#define CONTENT_H
+
+// For `size_t`.
+#include <stddef.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// Files at least this big are mapped rather than read.
+#define CONTENT_MAP_THRESHOLD 262144
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The contents of a file, read (or mapped) once, so everything
+// that needs the bytes (the digest, the base64 encoder, etc.)
+// can look at the same copy.
+struct file_content {
+  const unsigned char *data;
+  size_t length;
+  void *mapping;
+  unsigned char *buffer;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in content.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+int load_file_content(struct file_content *content, const char *path, int may_map);
+void release_file_content(struct file_content *content);
+
+#endif
@@ -0,0 +1,484 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file finds files with the same contents
+ *    (`--dedupe <file>`), and writes a report of them.
+ *
+ *    Every file's path and size are noted during the walk.
+ *    Afterwards, candidates are narrowed down in stages, each
+ *    costlier than the last, and each only run on what survived
+ *    the one before:
+ *
+ *      1. Files are grouped by size. A file whose size nobody
+ *         else has can't have a duplicate, and is never read.
+ *      2. Files of the same size are hashed on their first and
+ *         last DEDUPE_PARTIAL_LENGTH bytes (for small files, that's
+ *         the whole file).
+ *      3. Files whose partial hashes still match are hashed in full.
+ *
+ *    Hashes are BLAKE3 (whatever `--hash` is), so a match means
+ *    the same bytes.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `strcmp()`.
+#include <string.h>
+
+// For `open()`.
+#include <fcntl.h>
+
+// For `pread()` and `close()`.
+#include <unistd.h>
+
+// For `fstat()`.
+#include <sys/stat.h>
+
+// For `errno`.
+#include <errno.h>
+
+// For the mutex that guards the list during a `--jobs` walk.
+#include <pthread.h>
+
+// We read whole files with these.
+#include "content.h"
+
+// We hash with these.
+#include "digest.h"
+
+// We time the report, and count what we read (`--stats`).
+#include "stats.h"
+
+// For `make_room()`.
+#include "utilities.h"
+
+// We need the header that declares the prototypes for this file.
+#include "dedupe.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// A file that might have a duplicate.
+struct dedupe_file {
+  char *path;
+  int64_t size;
+  int readable;
+  char partial[MAX_DIGEST_HEX_LENGTH + 1];
+  char full[MAX_DIGEST_HEX_LENGTH + 1];
+};
+
+// A set of files with the same contents: a run in the list.
+struct dedupe_group {
+  size_t first;
+  size_t count;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  NON-CONSTANT VARIABLES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// Where to write the report (NULL means we're not looking).
+const char *dedupe_file_path = NULL;
+
+// Every file the walk found.
+struct dedupe_file *dedupe_files = NULL;
+size_t dedupe_file_count = 0;
+size_t dedupe_file_capacity = 0;
+pthread_mutex_t dedupe_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// The groups of duplicates we found.
+struct dedupe_group *dedupe_groups = NULL;
+size_t dedupe_group_count = 0;
+size_t dedupe_group_capacity = 0;
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in dedupe.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Look for duplicates, and write the report to a file.
+ *
+ *  @param char *path The path to the report.
+ *  @return void
+ */
+void set_dedupe_file(const char *path) {
+  dedupe_file_path = path;
+}
+
+/*
+ *  Are we looking for duplicates?
+ *
+ *  @return int 1 if yes, 0 if no.
+ */
+int dedupe_is_enabled(void) {
+  return dedupe_file_path != NULL;
+}
+
+/*
+ *  Note a file the walk found. Files are noted by their current
+ *  name (after `--cachebust` has renamed them).
+ *
+ *  @param struct asset_record *record The file's record.
+ *  @return void
+ */
+void dedupe_remember(const struct asset_record *record) {
+
+  // A file we couldn't look at can't be compared.
+  if (record->size < 0) {
+    return;
+  }
+
+  size_t directory_length = strlen(record->directory);
+  size_t filename_length = strlen(record->filename);
+  char *path = malloc(directory_length + filename_length + 1);
+  if (path == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  memcpy(path, record->directory, directory_length);
+  memcpy(path + directory_length, record->filename, filename_length + 1);
+
+  pthread_mutex_lock(&dedupe_lock);
+  make_room((void **) &dedupe_files, &dedupe_file_capacity, dedupe_file_count, sizeof(struct dedupe_file), INITIAL_DEDUPE_FILES);
+  struct dedupe_file *file = &dedupe_files[dedupe_file_count++];
+  file->path = path;
+  file->size = record->size;
+  file->readable = 1;
+  file->partial[0] = '\0';
+  file->full[0] = '\0';
+  pthread_mutex_unlock(&dedupe_lock);
+
+}
+
+/*
+ *  Read some bytes from a place in a file, all of them or nothing.
+ *
+ *  @param int descriptor The open file.
+ *  @param unsigned char *buffer Where to put them.
+ *  @param size_t length How many to read.
+ *  @param off_t offset Where from.
+ *  @return int 1 if we got them all, 0 if not.
+ */
+static int read_exactly(int descriptor, unsigned char *buffer, size_t length, off_t offset) {
+  size_t done = 0;
+  while (done < length) {
+    ssize_t bytes_read = pread(descriptor, buffer + done, length - done, offset + (off_t) done);
+    if (bytes_read < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytes_read <= 0) {
+      return 0;
+    }
+    done += (size_t) bytes_read;
+  }
+  return 1;
+}
+
+/*
+ *  Hash the first and last DEDUPE_PARTIAL_LENGTH bytes of a file
+ *  (or, if it's no bigger than that twice over, all of it).
+ *
+ *  @param struct dedupe_file *file The file.
+ *  @return void
+ */
+static void hash_partial(struct dedupe_file *file) {
+
+  unsigned char buffer[2 * DEDUPE_PARTIAL_LENGTH];
+  size_t size = (size_t) file->size;
+  size_t length = size <= sizeof(buffer) ? size : sizeof(buffer);
+
+  int descriptor = open(file->path, O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0) {
+    file->readable = 0;
+    return;
+  }
+
+  // If it's changed size since the walk, leave it out.
+  struct stat info;
+  int ok = fstat(descriptor, &info) == 0 && info.st_size == file->size;
+  if (ok && size <= sizeof(buffer)) {
+    ok = read_exactly(descriptor, buffer, length, 0);
+  } else if (ok) {
+    ok = read_exactly(descriptor, buffer, DEDUPE_PARTIAL_LENGTH, 0)
+      && read_exactly(descriptor, buffer + DEDUPE_PARTIAL_LENGTH, DEDUPE_PARTIAL_LENGTH,
+                      (off_t) (size - DEDUPE_PARTIAL_LENGTH));
+  }
+  close(descriptor);
+
+  if (!ok) {
+    file->readable = 0;
+    return;
+  }
+  count(COUNT_DEDUPE_PARTIAL, 1);
+  count(COUNT_BYTES_READ, length);
+  digest_to_hex(DIGEST_BLAKE3, 1, buffer, length, file->partial);
+
+}
+
+/*
+ *  Hash the whole of a file. A small file's partial hash
+ *  already covered all of it.
+ *
+ *  @param struct dedupe_file *file The file.
+ *  @return void
+ */
+static void hash_full(struct dedupe_file *file) {
+
+  if (file->size <= 2 * DEDUPE_PARTIAL_LENGTH) {
+    memcpy(file->full, file->partial, sizeof(file->full));
+    return;
+  }
+
+  struct file_content content;
+  if (!load_file_content(&content, file->path, 1)) {
+    file->readable = 0;
+    return;
+  }
+  if ((int64_t) content.length != file->size) {
+    file->readable = 0;
+  } else {
+    count(COUNT_DEDUPE_FULL, 1);
+    digest_to_hex(DIGEST_BLAKE3, 1, content.data, content.length, file->full);
+  }
+  release_file_content(&content);
+
+}
+
+/*
+ *  Compare two files by size, then path, for `qsort()`.
+ *
+ *  @param void *a The first file.
+ *  @param void *b The second file.
+ *  @return int <0, 0 or >0.
+ */
+static int compare_sizes(const void *a, const void *b) {
+  const struct dedupe_file *first = a;
+  const struct dedupe_file *second = b;
+  if (first->size != second->size) {
+    return first->size < second->size ? -1 : 1;
+  }
+  return strcmp(first->path, second->path);
+}
+
+/*
+ *  Compare two files by partial hash, then path, for `qsort()`.
+ *  Files we couldn't read go last.
+ *
+ *  @param void *a The first file.
+ *  @param void *b The second file.
+ *  @return int <0, 0 or >0.
+ */
+static int compare_partials(const void *a, const void *b) {
+  const struct dedupe_file *first = a;
+  const struct dedupe_file *second = b;
+  if (first->readable != second->readable) {
+    return first->readable ? -1 : 1;
+  }
+  int order = strcmp(first->partial, second->partial);
+  return order != 0 ? order : strcmp(first->path, second->path);
+}
+
+/*
+ *  Compare two files by full hash, then path, for `qsort()`.
+ *  Files we couldn't read go last.
+ *
+ *  @param void *a The first file.
+ *  @param void *b The second file.
+ *  @return int <0, 0 or >0.
+ */
+static int compare_fulls(const void *a, const void *b) {
+  const struct dedupe_file *first = a;
+  const struct dedupe_file *second = b;
+  if (first->readable != second->readable) {
+    return first->readable ? -1 : 1;
+  }
+  int order = strcmp(first->full, second->full);
+  return order != 0 ? order : strcmp(first->path, second->path);
+}
+
+/*
+ *  Compare two groups, biggest files first, for `qsort()`.
+ *
+ *  @param void *a The first group.
+ *  @param void *b The second group.
+ *  @return int <0, 0 or >0.
+ */
+static int compare_groups(const void *a, const void *b) {
+  const struct dedupe_file *first = &dedupe_files[((const struct dedupe_group *) a)->first];
+  const struct dedupe_file *second = &dedupe_files[((const struct dedupe_group *) b)->first];
+  if (first->size != second->size) {
+    return first->size > second->size ? -1 : 1;
+  }
+  return strcmp(first->path, second->path);
+}
+
+/*
+ *  How long is the run of files starting at `first` that
+ *  are the same, as far as a stage can tell?
+ *
+ *  @param size_t first Where the run starts.
+ *  @param size_t end Where to stop looking.
+ *  @param int stage 1 for size, 2 for partial hash, 3 for full hash.
+ *  @return size_t The length of the run.
+ */
+static size_t run_length(size_t first, size_t end, int stage) {
+  const struct dedupe_file *head = &dedupe_files[first];
+  size_t i = first + 1;
+  while (i < end) {
+    const struct dedupe_file *file = &dedupe_files[i];
+    int same = stage == 1 ? file->size == head->size
+      : stage == 2 ? file->readable && head->readable && strcmp(file->partial, head->partial) == 0
+      : file->readable && head->readable && strcmp(file->full, head->full) == 0;
+    if (!same) {
+      break;
+    }
+    i++;
+  }
+  return i - first;
+}
+
+/*
+ *  Narrow a run of files down a stage, and note the groups
+ *  of duplicates that come out of the last stage.
+ *
+ *  @param size_t first Where the run starts.
+ *  @param size_t length How many files are in it.
+ *  @param int stage 2 to hash the ends of the files, 3 to hash them in full.
+ *  @return void
+ */
+static void narrow_down(size_t first, size_t length, int stage) {
+
+  size_t i;
+  for (i = first; i < first + length; i++) {
+    if (stage == 2) {
+      hash_partial(&dedupe_files[i]);
+    } else {
+      hash_full(&dedupe_files[i]);
+    }
+  }
+  qsort(&dedupe_files[first], length, sizeof(struct dedupe_file), stage == 2 ? compare_partials : compare_fulls);
+
+  // Only runs of two or more can hold duplicates.
+  size_t end = first + length;
+  for (i = first; i < end && dedupe_files[i].readable; ) {
+    size_t run = run_length(i, end, stage);
+    if (run > 1 && stage == 2) {
+      narrow_down(i, run, 3);
+    } else if (run > 1) {
+      make_room((void **) &dedupe_groups, &dedupe_group_capacity, dedupe_group_count, sizeof(struct dedupe_group), INITIAL_DEDUPE_FILES);
+      dedupe_groups[dedupe_group_count].first = i;
+      dedupe_groups[dedupe_group_count].count = run;
+      dedupe_group_count++;
+    }
+    i += run;
+  }
+
+}
+
+/*
+ *  Find the duplicates among the files the walk found,
+ *  and write the report.
+ *
+ *  @return void
+ */
+void write_dedupe_report(void) {
+
+  if (!dedupe_is_enabled()) {
+    return;
+  }
+  uint64_t started = start_timer();
+
+  // Stage 1: sizes. Only sizes shared by two or more files go on.
+  qsort(dedupe_files, dedupe_file_count, sizeof(struct dedupe_file), compare_sizes);
+  size_t i;
+  for (i = 0; i < dedupe_file_count; ) {
+    size_t run = run_length(i, dedupe_file_count, 1);
+    if (run > 1) {
+      narrow_down(i, run, 2);
+    }
+    i += run;
+  }
+  qsort(dedupe_groups, dedupe_group_count, sizeof(struct dedupe_group), compare_groups);
+
+  FILE *report = fopen(dedupe_file_path, "w");
+  if (report == NULL) {
+    fprintf(stderr, "Could not write the dedupe report: %s\n", dedupe_file_path);
+    exit(1);
+  }
+
+  // A summary, then each group.
+  uint64_t duplicate_files = 0;
+  uint64_t wasted_bytes = 0;
+  for (i = 0; i < dedupe_group_count; i++) {
+    duplicate_files += dedupe_groups[i].count - 1;
+    wasted_bytes += (dedupe_groups[i].count - 1) * (uint64_t) dedupe_files[dedupe_groups[i].first].size;
+  }
+  fprintf(report, "{\"groups\":%zu,\"duplicate_files\":%llu,\"wasted_bytes\":%llu,\"duplicates\":[",
+          dedupe_group_count, (unsigned long long) duplicate_files, (unsigned long long) wasted_bytes);
+  for (i = 0; i < dedupe_group_count; i++) {
+    const struct dedupe_file *files = &dedupe_files[dedupe_groups[i].first];
+    fprintf(report, "%s{\"size\":%lld,\"blake3\":\"%s\",\"files\":[",
+            i > 0 ? "," : "", (long long) files[0].size, files[0].full);
+    size_t j;
+    for (j = 0; j < dedupe_groups[i].count; j++) {
+      fprintf(report, "%s\"%s\"", j > 0 ? "," : "", files[j].path);
+    }
+    fprintf(report, "]}");
+  }
+  fprintf(report, "]}\n");
+  if (fclose(report) != 0) {
+    fprintf(stderr, "Could not write the dedupe report: %s\n", dedupe_file_path);
+    exit(1);
+  }
+
+  // Let go of everything.
+  for (i = 0; i < dedupe_file_count; i++) {
+    free(dedupe_files[i].path);
+  }
+  free(dedupe_files);
+  free(dedupe_groups);
+  dedupe_files = NULL;
+  dedupe_groups = NULL;
+  dedupe_file_count = 0;
+  dedupe_file_capacity = 0;
+  dedupe_group_count = 0;
+  dedupe_group_capacity = 0;
+
+  stop_timer(PHASE_DEDUPE, started);
+
+}
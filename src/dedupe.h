@@ -0,0 +1,49 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for dedupe.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef DEDUPE_H
+#define DEDUPE_H
+
+// For `struct asset_record`.
+#include "record.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// How much of each end of a file the partial hash looks at.
+#define DEDUPE_PARTIAL_LENGTH 4096
+
+#define INITIAL_DEDUPE_FILES 1024
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in dedupe.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void set_dedupe_file(const char *path);
+int dedupe_is_enabled(void);
+void dedupe_remember(const struct asset_record *record);
+void write_dedupe_report(void);
+
+#endif
@@ -0,0 +1,986 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file compares the walk with an earlier manifest
+ *    (`--diff <old-manifest>`), and only lets through the
+ *    entries that were added, removed, modified or renamed.
+ *
+ *    The old manifest is read a chunk at a time by a small
+ *    streaming parser, which keeps only the fields we compare
+ *    (the base64, which can be most of the file, is skipped
+ *    over, never stored). A JSON manifest can be gzip (or, with
+ *    `make ZSTD=1`, zstd) compressed, as `--compress` writes it:
+ *    it's decompressed a chunk at a time as it's parsed. A binary
+ *    manifest (`--format bin`) is read through manifest_reader.c
+ *    instead, so it has to be decompressed first. Each old entry goes
+ *    in two hash tables: one by path, to find what became of each
+ *    file, and one by digest, to spot files that were renamed.
+ *
+ *    A file whose path is in the old manifest is modified if its
+ *    digest changed. A file whose path isn't is held back until
+ *    the walk is done: if an old file with the same digest is
+ *    gone by then, it was renamed, otherwise it was added. Old
+ *    files nobody claimed were removed.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `strcmp()`.
+#include <string.h>
+
+// For fixed width integers, e.g., `uint32_t`.
+#include <stdint.h>
+
+// For the mutex that guards the tables during a `--jobs` walk.
+#include <pthread.h>
+
+// For reading gzip compressed manifests.
+#include <zlib.h>
+
+// For reading zstd compressed manifests (if it's built in).
+#ifdef ASSETS_ZSTD
+#include <zstd.h>
+#endif
+
+// For the names of the digest algorithms.
+#include "digest.h"
+
+// For recognizing (and reading) a binary manifest.
+#include "manifest.h"
+#include "manifest_reader.h"
+
+// For `make_room()` and `hash_bytes()`.
+#include "utilities.h"
+
+// We need the header that declares the prototypes for this file.
+#include "diff.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// A file in the old manifest. Its strings share one block.
+struct old_entry {
+  char *block;
+  const char *path;
+  const char *key;
+  const char *directory;
+  const char *filename;
+  const char *extension;
+  const char *mime;
+  const char *digest;
+
+  // The next old entry with the same digest (its index + 1, or 0).
+  size_t next_with_digest;
+
+  // Whether the walk found a file at its path, and whether
+  // a renamed file has been matched up with it.
+  int seen;
+  int claimed;
+};
+
+// A string being read out of the old manifest.
+struct field_buffer {
+  char *data;
+  size_t length;
+  size_t capacity;
+};
+
+// The old manifest, a chunk at a time. If it's compressed,
+// `gzip` (or `zstd`) decompresses it into `buffer`.
+struct json_reader {
+  FILE *file;
+  gzFile gzip;
+#ifdef ASSETS_ZSTD
+  ZSTD_DCtx *zstd;
+  ZSTD_inBuffer zstd_input;
+  size_t zstd_result;
+  unsigned char compressed[DIFF_READ_LENGTH];
+#endif
+  int failed;
+  unsigned char buffer[DIFF_READ_LENGTH];
+  size_t position;
+  size_t length;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  NON-CONSTANT VARIABLES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The old manifest (NULL means we're not comparing).
+const char *diff_file_path = NULL;
+
+// The files in it, and the algorithm of its digests.
+struct old_entry *old_entries = NULL;
+size_t old_entry_count = 0;
+size_t old_entry_capacity = 0;
+char old_algorithm[MAX_DIFF_FIELD_LENGTH] = "";
+
+// The hash tables, by path and by digest. Each slot
+// holds an index + 1 (0 is empty).
+size_t *path_slots = NULL;
+size_t *digest_slots = NULL;
+size_t diff_slot_capacity = 0;
+
+// Files whose paths are new, until we know if they were renamed.
+struct asset_record **new_files = NULL;
+size_t new_file_count = 0;
+size_t new_file_capacity = 0;
+
+pthread_mutex_t diff_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in diff.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Compare the walk with an old manifest.
+ *
+ *  @param char *path The path to the old manifest.
+ *  @return void
+ */
+void set_diff_file(const char *path) {
+  diff_file_path = path;
+}
+
+/*
+ *  Are we comparing with an old manifest?
+ *
+ *  @return int 1 if yes, 0 if no.
+ */
+int diff_is_enabled(void) {
+  return diff_file_path != NULL;
+}
+
+/*
+ *  Say the old manifest can't be used, and stop.
+ *
+ *  @param char *message What's wrong with it.
+ *  @return void
+ */
+static void old_manifest_failure(const char *message) {
+  printf("%s\n%s\n", message, diff_file_path);
+  exit(1);
+}
+
+/*
+ *  Add a file from the old manifest.
+ *
+ *  @param char *key Its key.
+ *  @param char *directory Its directory.
+ *  @param char *filename Its filename.
+ *  @param char *extension Its extension.
+ *  @param char *mime Its MIME type (NULL for manifests from before there was one).
+ *  @param char *digest Its digest.
+ *  @return void
+ */
+static void add_old_entry(const char *key, const char *directory, const char *filename,
+                          const char *extension, const char *mime, const char *digest) {
+
+  // The block holds the path (the directory and the filename run
+  // together), then each field, one after the other.
+  const char *strings[] = { key, directory, filename, extension, mime != NULL ? mime : "", digest };
+  size_t directory_length = strlen(directory);
+  size_t filename_length = strlen(filename);
+  size_t total = directory_length + filename_length + 1;
+  size_t i;
+  for (i = 0; i < 6; i++) {
+    total += strlen(strings[i]) + 1;
+  }
+
+  char *block = malloc(total);
+  if (block == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  memcpy(block, directory, directory_length);
+  memcpy(block + directory_length, filename, filename_length + 1);
+
+  const char *starts[6];
+  char *cursor = block + directory_length + filename_length + 1;
+  for (i = 0; i < 6; i++) {
+    size_t length = strlen(strings[i]);
+    memcpy(cursor, strings[i], length + 1);
+    starts[i] = cursor;
+    cursor += length + 1;
+  }
+
+  make_room((void **) &old_entries, &old_entry_capacity, old_entry_count, sizeof(struct old_entry), INITIAL_DIFF_ENTRIES);
+  struct old_entry *entry = &old_entries[old_entry_count++];
+  memset(entry, 0, sizeof(struct old_entry));
+  entry->block = block;
+  entry->path = block;
+  entry->key = starts[0];
+  entry->directory = starts[1];
+  entry->filename = starts[2];
+  entry->extension = starts[3];
+  entry->mime = mime != NULL ? starts[4] : NULL;
+  entry->digest = starts[5];
+
+}
+
+/*
+ *  Clear a field buffer, leaving it an empty string
+ *  (so a field read as "" is never NULL).
+ *
+ *  @param struct field_buffer *field The buffer.
+ *  @return void
+ */
+static void clear_field(struct field_buffer *field) {
+  if (field->data == NULL) {
+    field->data = malloc(64);
+    if (field->data == NULL) {
+      puts("malloc failure, wtf");
+      exit(1);
+    }
+    field->capacity = 64;
+  }
+  field->length = 0;
+  field->data[0] = '\0';
+}
+
+/*
+ *  Add a byte to a field buffer.
+ *
+ *  @param struct field_buffer *field The buffer.
+ *  @param char byte The byte.
+ *  @return void
+ */
+static void add_to_field(struct field_buffer *field, char byte) {
+  if (field->length + 2 > field->capacity) {
+    size_t new_capacity = field->capacity ? field->capacity * 2 : 64;
+    char *grown = realloc(field->data, new_capacity);
+    if (grown == NULL) {
+      puts("malloc failure, wtf");
+      exit(1);
+    }
+    field->data = grown;
+    field->capacity = new_capacity;
+  }
+  field->data[field->length++] = byte;
+  field->data[field->length] = '\0';
+}
+
+/*
+ *  Read the next chunk of the old manifest into the buffer,
+ *  decompressing it if need be.
+ *
+ *  @param struct json_reader *reader The reader.
+ *  @return size_t How many bytes there are (0 at the end, or
+ *                 if it can't be read: then `failed` is set).
+ */
+static size_t read_chunk(struct json_reader *reader) {
+
+  if (reader->gzip != NULL) {
+    // A stream that was cut short shows up as an error at the end.
+    int length = gzread(reader->gzip, reader->buffer, sizeof(reader->buffer));
+    int error = Z_OK;
+    if (length <= 0) {
+      gzerror(reader->gzip, &error);
+    }
+    if (length < 0 || error != Z_OK) {
+      reader->failed = 1;
+      return 0;
+    }
+    return (size_t) length;
+  }
+
+#ifdef ASSETS_ZSTD
+  if (reader->zstd != NULL) {
+    ZSTD_outBuffer output = { reader->buffer, sizeof(reader->buffer), 0 };
+    while (output.pos == 0) {
+      if (reader->zstd_input.pos == reader->zstd_input.size) {
+        reader->zstd_input.size = fread(reader->compressed, 1, sizeof(reader->compressed), reader->file);
+        reader->zstd_input.pos = 0;
+        if (reader->zstd_input.size == 0) {
+
+          // A frame that was cut short is damaged, not finished.
+          reader->failed = ferror(reader->file) || reader->zstd_result != 0;
+          return 0;
+
+        }
+      }
+      reader->zstd_result = ZSTD_decompressStream(reader->zstd, &output, &reader->zstd_input);
+      if (ZSTD_isError(reader->zstd_result)) {
+        reader->failed = 1;
+        return 0;
+      }
+    }
+    return output.pos;
+  }
+#endif
+
+  size_t length = fread(reader->buffer, 1, sizeof(reader->buffer), reader->file);
+  if (length == 0 && ferror(reader->file)) {
+    reader->failed = 1;
+  }
+  return length;
+
+}
+
+/*
+ *  Look at the next byte of the old manifest, without taking it.
+ *
+ *  @param struct json_reader *reader The reader.
+ *  @return int The byte, or -1 at the end of the file.
+ */
+static int peek_byte(struct json_reader *reader) {
+  if (reader->position == reader->length) {
+    reader->length = read_chunk(reader);
+    reader->position = 0;
+    if (reader->length == 0) {
+      return -1;
+    }
+  }
+  return reader->buffer[reader->position];
+}
+
+/*
+ *  Take the next byte of the old manifest.
+ *
+ *  @param struct json_reader *reader The reader.
+ *  @return int The byte, or -1 at the end of the file.
+ */
+static int next_byte(struct json_reader *reader) {
+  int byte = peek_byte(reader);
+  if (byte >= 0) {
+    reader->position++;
+  }
+  return byte;
+}
+
+/*
+ *  Skip whitespace, and look at the byte after it.
+ *
+ *  @param struct json_reader *reader The reader.
+ *  @return int The byte, or -1 at the end of the file.
+ */
+static int skip_space(struct json_reader *reader) {
+  int byte = peek_byte(reader);
+  while (byte == ' ' || byte == '\t' || byte == '\n' || byte == '\r') {
+    reader->position++;
+    byte = peek_byte(reader);
+  }
+  return byte;
+}
+
+/*
+ *  Read the four hex digits of a "\u" escape.
+ *
+ *  @param struct json_reader *reader The reader.
+ *  @return long The code unit, or -1 if it isn't one.
+ */
+static long read_hex4(struct json_reader *reader) {
+  long value = 0;
+  int i;
+  for (i = 0; i < 4; i++) {
+    int byte = next_byte(reader);
+    int digit = (byte >= '0' && byte <= '9') ? byte - '0'
+      : (byte >= 'a' && byte <= 'f') ? byte - 'a' + 10
+      : (byte >= 'A' && byte <= 'F') ? byte - 'A' + 10 : -1;
+    if (digit < 0) {
+      return -1;
+    }
+    value = value * 16 + digit;
+  }
+  return value;
+}
+
+/*
+ *  Add a code point to a field buffer, as UTF-8.
+ *
+ *  @param struct field_buffer *field The buffer.
+ *  @param long point The code point.
+ *  @return void
+ */
+static void add_code_point(struct field_buffer *field, long point) {
+  if (point < 0x80) {
+    add_to_field(field, (char) point);
+  } else if (point < 0x800) {
+    add_to_field(field, (char) (0xC0 | (point >> 6)));
+    add_to_field(field, (char) (0x80 | (point & 0x3F)));
+  } else if (point < 0x10000) {
+    add_to_field(field, (char) (0xE0 | (point >> 12)));
+    add_to_field(field, (char) (0x80 | ((point >> 6) & 0x3F)));
+    add_to_field(field, (char) (0x80 | (point & 0x3F)));
+  } else {
+    add_to_field(field, (char) (0xF0 | (point >> 18)));
+    add_to_field(field, (char) (0x80 | ((point >> 12) & 0x3F)));
+    add_to_field(field, (char) (0x80 | ((point >> 6) & 0x3F)));
+    add_to_field(field, (char) (0x80 | (point & 0x3F)));
+  }
+}
+
+/*
+ *  Read a string (its opening quote already taken), unescaping it.
+ *
+ *  @param struct json_reader *reader The reader.
+ *  @param struct field_buffer *into Where to put it, or NULL to skip it.
+ *  @return int 1 if it was read, 0 if the manifest is broken.
+ */
+static int read_string(struct json_reader *reader, struct field_buffer *into) {
+
+  if (into != NULL) {
+    clear_field(into);
+  }
+
+  for (;;) {
+    int byte = next_byte(reader);
+    if (byte < 0) {
+      return 0;
+    }
+    if (byte == '"') {
+      return 1;
+    }
+    if (byte == '\\') {
+      byte = next_byte(reader);
+      long point = -1;
+      switch (byte) {
+        case '"': case '\\': case '/': point = byte; break;
+        case 'b': point = '\b'; break;
+        case 'f': point = '\f'; break;
+        case 'n': point = '\n'; break;
+        case 'r': point = '\r'; break;
+        case 't': point = '\t'; break;
+        case 'u':
+          point = read_hex4(reader);
+
+          // A surrogate pair is two escapes for one code point.
+          if (point >= 0xD800 && point < 0xDC00) {
+            if (next_byte(reader) != '\\' || next_byte(reader) != 'u') {
+              return 0;
+            }
+            long low = read_hex4(reader);
+            if (low < 0xDC00 || low >= 0xE000) {
+              return 0;
+            }
+            point = 0x10000 + ((point - 0xD800) << 10) + (low - 0xDC00);
+          }
+          break;
+      }
+      if (point < 0) {
+        return 0;
+      }
+      if (into != NULL) {
+        add_code_point(into, point);
+      }
+    } else if (into != NULL) {
+      add_to_field(into, (char) byte);
+    }
+  }
+
+}
+
+/*
+ *  Skip a number, `true`, `false` or `null`.
+ *
+ *  @param struct json_reader *reader The reader.
+ *  @return void
+ */
+static void skip_scalar(struct json_reader *reader) {
+  int byte = peek_byte(reader);
+  while (byte >= 0 && byte != ',' && byte != '}' && byte != ']'
+         && byte != ' ' && byte != '\t' && byte != '\n' && byte != '\r') {
+    reader->position++;
+    byte = peek_byte(reader);
+  }
+}
+
+/*
+ *  Skip an object or an array (like an entry's "precompressed"),
+ *  and everything in it.
+ *
+ *  @param struct json_reader *reader The reader.
+ *  @return int 1 if it was skipped, 0 if the manifest is broken.
+ */
+static int skip_nested(struct json_reader *reader) {
+  int depth = 0;
+  do {
+    int byte = next_byte(reader);
+    if (byte < 0) {
+      return 0;
+    } else if (byte == '{' || byte == '[') {
+      depth++;
+    } else if (byte == '}' || byte == ']') {
+      depth--;
+    } else if (byte == '"' && !read_string(reader, NULL)) {
+      return 0;
+    }
+  } while (depth > 0);
+  return 1;
+}
+
+/*
+ *  Read a JSON manifest, one entry at a time.
+ *
+ *  @param struct json_reader *reader The reader.
+ *  @return int 1 if it was read, 0 if it isn't a manifest we can read.
+ */
+static int read_json_manifest(struct json_reader *reader) {
+
+  // The fields we keep (the digest is whichever algorithm's it is).
+  struct field_buffer name = { NULL, 0, 0 };
+  struct field_buffer fields[6];
+  memset(fields, 0, sizeof(fields));
+  struct field_buffer *key = &fields[0], *directory = &fields[1], *filename = &fields[2];
+  struct field_buffer *extension = &fields[3], *mime = &fields[4], *digest = &fields[5];
+  int ok = 0;
+  int i;
+
+  if (skip_space(reader) != '[') {
+    goto done;
+  }
+  reader->position++;
+  if (skip_space(reader) == ']') {
+    ok = 1;
+    goto done;
+  }
+
+  for (;;) {
+
+    if (skip_space(reader) != '{') {
+      goto done;
+    }
+    reader->position++;
+    int has[6] = { 0, 0, 0, 0, 0, 0 };
+
+    // Each field: a name, a colon, and a value.
+    if (skip_space(reader) == '}') {
+      reader->position++;
+    } else {
+      for (;;) {
+        if (next_byte(reader) != '"' || !read_string(reader, &name) || name.length == 0) {
+          goto done;
+        }
+        if (skip_space(reader) != ':') {
+          goto done;
+        }
+        reader->position++;
+        int byte = skip_space(reader);
+
+        if (byte == '"') {
+          reader->position++;
+          int which = strcmp(name.data, "key") == 0 ? 0
+            : strcmp(name.data, "directory") == 0 ? 1
+            : strcmp(name.data, "filename") == 0 ? 2
+            : strcmp(name.data, "extension") == 0 ? 3
+            : strcmp(name.data, "mime") == 0 ? 4
+            : find_digest_algorithm(name.data) >= 0 ? 5 : -1;
+          if (!read_string(reader, which >= 0 ? &fields[which] : NULL)) {
+            goto done;
+          }
+          if (which >= 0) {
+            has[which] = 1;
+          }
+          if (which == 5 && name.length < sizeof(old_algorithm)) {
+            memcpy(old_algorithm, name.data, name.length + 1);
+          }
+        } else if (byte == '{' || byte == '[') {
+          if (!skip_nested(reader)) {
+            goto done;
+          }
+        } else if (byte < 0) {
+          goto done;
+        } else {
+          skip_scalar(reader);
+        }
+
+        byte = skip_space(reader);
+        reader->position++;
+        if (byte == '}') {
+          break;
+        } else if (byte != ',') {
+          goto done;
+        }
+      }
+
+      // Every entry we write has these.
+      if (!has[1] || !has[2] || !has[5]) {
+        goto done;
+      }
+      add_old_entry(has[0] ? key->data : "", directory->data, filename->data,
+                    has[3] ? extension->data : "", has[4] ? mime->data : NULL, digest->data);
+    }
+
+    int byte = skip_space(reader);
+    reader->position++;
+    if (byte == ']') {
+      ok = 1;
+      goto done;
+    } else if (byte != ',') {
+      goto done;
+    }
+
+  }
+
+done:
+  free(name.data);
+  for (i = 0; i < 6; i++) {
+    free(fields[i].data);
+  }
+  return ok;
+
+}
+
+/*
+ *  Read a binary manifest (`--format bin`).
+ *
+ *  @return int 1 if it was read, 0 if it isn't a manifest we can read.
+ */
+static int read_binary_manifest(void) {
+  struct manifest *manifest = open_manifest(diff_file_path);
+  if (manifest == NULL) {
+    return 0;
+  }
+  snprintf(old_algorithm, sizeof(old_algorithm), "%s", manifest_algorithm(manifest));
+  size_t i;
+  for (i = 0; i < manifest_count(manifest); i++) {
+    struct manifest_entry entry;
+    if (!manifest_entry(manifest, i, &entry)) {
+      close_manifest(manifest);
+      return 0;
+    }
+    add_old_entry(entry.key, entry.directory, entry.filename, entry.extension, entry.mime, entry.digest);
+  }
+  close_manifest(manifest);
+  return 1;
+}
+
+/*
+ *  Find the slot for a path: the one holding it, or the empty one it would go in.
+ *
+ *  @param char *path The path.
+ *  @return size_t* The slot.
+ */
+static size_t *find_path_slot(const char *path) {
+  size_t mask = diff_slot_capacity - 1;
+  size_t index = hash_bytes(path, strlen(path)) & mask;
+  while (path_slots[index] != 0 && strcmp(old_entries[path_slots[index] - 1].path, path) != 0) {
+    index = (index + 1) & mask;
+  }
+  return &path_slots[index];
+}
+
+/*
+ *  Find the slot for a digest: the one holding the first old
+ *  entry with it, or the empty one it would go in.
+ *
+ *  @param char *digest The digest.
+ *  @return size_t* The slot.
+ */
+static size_t *find_digest_slot(const char *digest) {
+  size_t mask = diff_slot_capacity - 1;
+  size_t index = hash_bytes(digest, strlen(digest)) & mask;
+  while (digest_slots[index] != 0 && strcmp(old_entries[digest_slots[index] - 1].digest, digest) != 0) {
+    index = (index + 1) & mask;
+  }
+  return &digest_slots[index];
+}
+
+/*
+ *  Load the old manifest, and index it by path and by digest.
+ *  It's read before anything is written, so it can be the
+ *  same file as the new one.
+ *
+ *  @return void
+ */
+void load_old_manifest(void) {
+
+  FILE *file = fopen(diff_file_path, "rb");
+  if (file == NULL) {
+    old_manifest_failure("Could not read the old manifest:");
+  }
+
+  // A binary manifest starts with its magic number, and so do
+  // gzip and zstd streams. Otherwise, it's JSON.
+  char magic[sizeof(MANIFEST_MAGIC) - 1];
+  size_t magic_length = fread(magic, 1, sizeof(magic), file);
+  int is_binary = magic_length == sizeof(magic) && memcmp(magic, MANIFEST_MAGIC, sizeof(magic)) == 0;
+  int is_gzip = magic_length >= 2 && memcmp(magic, "\x1f\x8b", 2) == 0;
+  int is_zstd = magic_length >= 4 && memcmp(magic, "\x28\xb5\x2f\xfd", 4) == 0;
+  int ok = 0;
+  if (is_binary) {
+    fclose(file);
+    ok = read_binary_manifest();
+  } else {
+    rewind(file);
+    struct json_reader *reader = malloc(sizeof(struct json_reader));
+    if (reader == NULL) {
+      puts("malloc failure, wtf");
+      exit(1);
+    }
+    reader->file = file;
+    reader->gzip = NULL;
+#ifdef ASSETS_ZSTD
+    reader->zstd = NULL;
+    reader->zstd_input.src = reader->compressed;
+    reader->zstd_input.size = 0;
+    reader->zstd_input.pos = 0;
+    reader->zstd_result = 0;
+#endif
+    reader->failed = 0;
+    reader->position = 0;
+    reader->length = 0;
+    if (is_gzip) {
+      reader->gzip = gzopen(diff_file_path, "rb");
+      if (reader->gzip == NULL) {
+        old_manifest_failure("Could not read the old manifest:");
+      }
+    }
+    if (is_zstd) {
+#ifdef ASSETS_ZSTD
+      reader->zstd = ZSTD_createDCtx();
+      if (reader->zstd == NULL) {
+        puts("malloc failure, wtf");
+        exit(1);
+      }
+#else
+      old_manifest_failure("This build can't read zstd. Rebuild with `make ZSTD=1` (it needs libzstd), "
+                           "or decompress the old manifest first:");
+#endif
+    }
+
+    // A compressed binary manifest can't be mapped in place.
+    if ((is_gzip || is_zstd) && peek_byte(reader) >= 0 && reader->length >= sizeof(magic)
+        && memcmp(reader->buffer, MANIFEST_MAGIC, sizeof(magic)) == 0) {
+      old_manifest_failure("A compressed binary manifest has to be decompressed first:");
+    }
+
+    ok = read_json_manifest(reader);
+
+    // Read to the end, so a compressed stream's trailer is checked too.
+    while (ok && read_chunk(reader) > 0) {
+    }
+    ok = ok && !reader->failed;
+    if (reader->gzip != NULL) {
+      gzclose(reader->gzip);
+    }
+#ifdef ASSETS_ZSTD
+    if (reader->zstd != NULL) {
+      ZSTD_freeDCtx(reader->zstd);
+    }
+#endif
+    free(reader);
+    fclose(file);
+  }
+  if (!ok) {
+    old_manifest_failure("This isn't a manifest we can read:");
+  }
+
+  // Digests made by another algorithm can't be compared.
+  const char *algorithm = digest_name(get_digest_algorithm());
+  if (old_entry_count > 0 && strcmp(old_algorithm, algorithm) != 0) {
+    printf("The old manifest was made with --hash %s, not %s:\n%s\n", old_algorithm, algorithm, diff_file_path);
+    exit(1);
+  }
+
+  // Keep the tables at most half full.
+  diff_slot_capacity = 16;
+  while (diff_slot_capacity < old_entry_count * 2) {
+    diff_slot_capacity *= 2;
+  }
+  path_slots = calloc(diff_slot_capacity, sizeof(size_t));
+  digest_slots = calloc(diff_slot_capacity, sizeof(size_t));
+  if (path_slots == NULL || digest_slots == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+
+  // Entries with the same digest are chained, in the order
+  // they're in the manifest (so we go backwards, pushing each
+  // on the front of its chain).
+  size_t i;
+  for (i = old_entry_count; i > 0; i--) {
+    struct old_entry *entry = &old_entries[i - 1];
+    size_t *slot = find_path_slot(entry->path);
+    *slot = i;
+    slot = find_digest_slot(entry->digest);
+    entry->next_with_digest = *slot;
+    *slot = i;
+  }
+
+}
+
+/*
+ *  Hand a record on with its change noted at the front of its entry.
+ *
+ *  @param struct asset_record *record The record.
+ *  @param char *change "added", "modified" or "renamed".
+ *  @param char *from The old path of a renamed file (or NULL).
+ *  @param void (*handler)(const struct asset_record*) Who gets it.
+ *  @return void
+ */
+static void hand_on(const struct asset_record *record, const char *change, const char *from,
+                    void (*handler)(const struct asset_record *record)) {
+
+  size_t length = strlen(record->entry) + strlen(change) + (from != NULL ? strlen(from) : 0) + 32;
+  char *entry = malloc(length);
+  if (entry == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  if (from != NULL) {
+    snprintf(entry, length, "{\"change\":\"%s\",\"from\":\"%s\",%s", change, from, record->entry + 1);
+  } else {
+    snprintf(entry, length, "{\"change\":\"%s\",%s", change, record->entry + 1);
+  }
+
+  struct asset_record changed = *record;
+  changed.entry = entry;
+  handler(&changed);
+  free(entry);
+
+}
+
+/*
+ *  Compare a file the walk found with the old manifest, and
+ *  hand it on if it's modified. New paths are held back (see
+ *  `finish_diff()`); files that haven't changed are dropped.
+ *
+ *  @param struct asset_record *record The file's record.
+ *  @param void (*handler)(const struct asset_record*) Who gets changed files.
+ *  @return void
+ */
+void diff_record(const struct asset_record *record, void (*handler)(const struct asset_record *record)) {
+
+  size_t directory_length = strlen(record->directory);
+  size_t filename_length = strlen(record->filename);
+  char path[directory_length + filename_length + 1];
+  memcpy(path, record->directory, directory_length);
+  memcpy(path + directory_length, record->filename, filename_length + 1);
+
+  pthread_mutex_lock(&diff_lock);
+  size_t index = *find_path_slot(path);
+  int modified = 0;
+  if (index != 0) {
+    struct old_entry *entry = &old_entries[index - 1];
+    entry->seen = 1;
+    modified = strcmp(entry->digest, record->digest) != 0;
+  } else {
+    make_room((void **) &new_files, &new_file_capacity, new_file_count, sizeof(struct asset_record *), INITIAL_DIFF_ENTRIES);
+    new_files[new_file_count++] = copy_record(record);
+  }
+  pthread_mutex_unlock(&diff_lock);
+
+  if (modified) {
+    hand_on(record, "modified", NULL, handler);
+  }
+
+}
+
+/*
+ *  Once the walk is done: hand on the files that were renamed
+ *  or added, then the ones that were removed, and let go of
+ *  the old manifest.
+ *
+ *  @param void (*handler)(const struct asset_record*) Who gets them.
+ *  @return void
+ */
+void finish_diff(void (*handler)(const struct asset_record *record)) {
+
+  size_t i;
+
+  // A new path with the digest of an old file that's gone was a rename.
+  for (i = 0; i < new_file_count; i++) {
+    struct asset_record *record = new_files[i];
+    size_t index = *find_digest_slot(record->digest);
+    while (index != 0 && (old_entries[index - 1].seen || old_entries[index - 1].claimed)) {
+      index = old_entries[index - 1].next_with_digest;
+    }
+    if (index != 0) {
+      old_entries[index - 1].claimed = 1;
+      hand_on(record, "renamed", old_entries[index - 1].path, handler);
+    } else {
+      hand_on(record, "added", NULL, handler);
+    }
+    free(record);
+  }
+
+  // Whatever is left is gone.
+  for (i = 0; i < old_entry_count; i++) {
+    struct old_entry *entry = &old_entries[i];
+    if (entry->seen || entry->claimed) {
+      continue;
+    }
+    size_t length = strlen(entry->block) * 3 + strlen(entry->extension) + strlen(entry->digest)
+      + (entry->mime != NULL ? strlen(entry->mime) : 0) + 128;
+    char *json = malloc(length);
+    if (json == NULL) {
+      puts("malloc failure, wtf");
+      exit(1);
+    }
+    char mime_field[MAX_DIFF_FIELD_LENGTH + 256] = "";
+    if (entry->mime != NULL) {
+      snprintf(mime_field, sizeof(mime_field), "\"mime\":\"%s\",", entry->mime);
+    }
+    snprintf(json, length, "{\"change\":\"removed\",\"key\":\"%s\",\"directory\":\"%s\",\"filename\":\"%s\","
+             "\"extension\":\"%s\",%s\"%s\":\"%s\"}", entry->key, entry->directory, entry->filename,
+             entry->extension, mime_field, old_algorithm, entry->digest);
+
+    struct asset_record removed;
+    memset(&removed, 0, sizeof(removed));
+    removed.path = entry->path;
+    removed.key = entry->key;
+    removed.directory = entry->directory;
+    removed.filename = entry->filename;
+    removed.extension = entry->extension;
+    removed.mime = entry->mime;
+    removed.algorithm = old_algorithm;
+    removed.digest = entry->digest;
+    removed.size = -1;
+    removed.entry = json;
+    handler(&removed);
+    free(json);
+  }
+
+  for (i = 0; i < old_entry_count; i++) {
+    free(old_entries[i].block);
+  }
+  free(old_entries);
+  free(new_files);
+  free(path_slots);
+  free(digest_slots);
+  old_entries = NULL;
+  new_files = NULL;
+  path_slots = NULL;
+  digest_slots = NULL;
+  old_entry_count = 0;
+  old_entry_capacity = 0;
+  new_file_count = 0;
+  new_file_capacity = 0;
+
+}
@@ -0,0 +1,53 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for diff.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef DIFF_H
+#define DIFF_H
+
+// For `struct asset_record`.
+#include "record.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// How much of the old manifest is read at a time.
+#define DIFF_READ_LENGTH 65536
+
+// The longest field name we look at in the old manifest.
+#define MAX_DIFF_FIELD_LENGTH 32
+
+#define INITIAL_DIFF_ENTRIES 1024
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in diff.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void set_diff_file(const char *path);
+int diff_is_enabled(void);
+void load_old_manifest(void);
+void diff_record(const struct asset_record *record, void (*handler)(const struct asset_record *record));
+void finish_diff(void (*handler)(const struct asset_record *record));
+
+#endif
@@ -0,0 +1,247 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides one interface to the hash
+ *    algorithms we support (`--hash md5|sha256|xxh3|blake3`).
+ *
+ *    Each algorithm hashes a whole buffer in one go and
+ *    writes the digest as lowercase hex. The algorithm's
+ *    name is also the key the hash gets in the manifest,
+ *    so consumers can tell what they got.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// For working with strings, e.g., `strcmp()`.
+#include <string.h>
+
+// For fixed width integers, e.g., `uint64_t`.
+#include <stdint.h>
+
+// The algorithms themselves.
+#include "md5.h"
+#include "sha256.h"
+#include "xxh3.h"
+#include "blake3.h"
+
+// We need the header that declares the prototypes for this file.
+#include "digest.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// One hash algorithm: its name, how many hex characters of
+// its digest we keep, and how to compute the raw digest.
+struct digest_algorithm {
+  const char *name;
+  size_t hex_length;
+  void (*hash)(const unsigned char *data, size_t length, int threads, unsigned char *digest);
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  NON-CONSTANT VARIABLES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// Which algorithm are we using?
+int digest_algorithm = DIGEST_MD5;
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in digest.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Hash with md5.
+ *
+ *  @param unsigned char *data The bytes.
+ *  @param size_t length The number of bytes.
+ *  @param int threads Ignored.
+ *  @param unsigned char *digest Where to store the 16 byte digest.
+ *  @return void
+ */
+static void hash_md5(const unsigned char *data, size_t length, int threads, unsigned char *digest) {
+  // Only BLAKE3 splits its work across threads.
+  (void) threads;
+  struct md5_context context;
+  md5_init(&context);
+  md5_update(&context, data, length);
+  md5_final(&context, digest);
+}
+
+/*
+ *  Hash with sha256.
+ *
+ *  @param unsigned char *data The bytes.
+ *  @param size_t length The number of bytes.
+ *  @param int threads Ignored.
+ *  @param unsigned char *digest Where to store the 32 byte digest.
+ *  @return void
+ */
+static void hash_sha256(const unsigned char *data, size_t length, int threads, unsigned char *digest) {
+  // Only BLAKE3 splits its work across threads.
+  (void) threads;
+  struct sha256_context context;
+  sha256_init(&context);
+  sha256_update(&context, data, length);
+  sha256_final(&context, digest);
+}
+
+/*
+ *  Hash with XXH3, big-endian like xxHash's canonical form.
+ *
+ *  @param unsigned char *data The bytes.
+ *  @param size_t length The number of bytes.
+ *  @param int threads Ignored.
+ *  @param unsigned char *digest Where to store the 8 byte digest.
+ *  @return void
+ */
+static void hash_xxh3(const unsigned char *data, size_t length, int threads, unsigned char *digest) {
+  // Only BLAKE3 splits its work across threads.
+  (void) threads;
+  uint64_t hash = xxh3_64(data, length);
+  int i;
+  for (i = 0; i < 8; i++) {
+    digest[i] = (unsigned char) (hash >> (56 - 8 * i));
+  }
+}
+
+/*
+ *  Hash with BLAKE3.
+ *
+ *  @param unsigned char *data The bytes.
+ *  @param size_t length The number of bytes.
+ *  @param int threads How many threads may work on it.
+ *  @param unsigned char *digest Where to store the 32 byte digest.
+ *  @return void
+ */
+static void hash_blake3(const unsigned char *data, size_t length, int threads, unsigned char *digest) {
+  blake3(data, length, threads, digest);
+}
+
+// The algorithms, in the order of the DIGEST_* constants.
+static const struct digest_algorithm digest_algorithms[NUMBER_OF_DIGESTS] = {
+  { "md5", MD5_HEX_LENGTH, hash_md5 },
+  { "sha256", 2 * SHA256_DIGEST_LENGTH, hash_sha256 },
+  { "xxh3", 16, hash_xxh3 },
+  { "blake3", 2 * BLAKE3_DIGEST_LENGTH, hash_blake3 }
+};
+
+/*
+ *  Set the hash algorithm.
+ *
+ *  @param int algorithm One of the DIGEST_* constants.
+ *  @return void
+ */
+void set_digest_algorithm(int algorithm) {
+  digest_algorithm = algorithm;
+}
+
+/*
+ *  Get the hash algorithm.
+ *
+ *  @return int One of the DIGEST_* constants.
+ */
+int get_digest_algorithm(void) {
+  return digest_algorithm;
+}
+
+/*
+ *  Look an algorithm up by name.
+ *
+ *  @param char *name The name, e.g. "xxh3".
+ *  @return int One of the DIGEST_* constants, or -1 if there's no such algorithm.
+ */
+int find_digest_algorithm(const char *name) {
+  int i;
+  for (i = 0; i < NUMBER_OF_DIGESTS; i++) {
+    if (strcmp(name, digest_algorithms[i].name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/*
+ *  Get an algorithm's name.
+ *
+ *  @param int algorithm One of the DIGEST_* constants.
+ *  @return char * The name.
+ */
+const char *digest_name(int algorithm) {
+  return digest_algorithms[algorithm].name;
+}
+
+/*
+ *  Hash some bytes, and store the digest as lowercase hex.
+ *
+ *  @param int algorithm One of the DIGEST_* constants.
+ *  @param int threads How many threads may hash one big file.
+ *  @param unsigned char *data The bytes.
+ *  @param size_t length The number of bytes.
+ *  @param char *variable The variable to store the hex in
+ *                        (room for MAX_DIGEST_HEX_LENGTH + 1 characters).
+ *  @return void
+ */
+void digest_to_hex(int algorithm, int threads, const unsigned char *data, size_t length, char *variable) {
+
+  const struct digest_algorithm *digest = &digest_algorithms[algorithm];
+
+  // Only big files are worth spreading over threads.
+  if (length < DIGEST_PARALLEL_THRESHOLD || threads < 1) {
+    threads = 1;
+  }
+
+  unsigned char raw[MAX_DIGEST_HEX_LENGTH / 2];
+  digest->hash(data, length, threads, raw);
+  raw_digest_to_hex(algorithm, raw, variable);
+
+}
+
+/*
+ *  Store a digest that was already computed as lowercase hex
+ *  (as long as the algorithm's hex digests are).
+ *
+ *  @param int algorithm One of the DIGEST_* constants.
+ *  @param unsigned char *raw The digest.
+ *  @param char *variable The variable to store the hex in
+ *                        (room for MAX_DIGEST_HEX_LENGTH + 1 characters).
+ *  @return void
+ */
+void raw_digest_to_hex(int algorithm, const unsigned char *raw, char *variable) {
+  const struct digest_algorithm *digest = &digest_algorithms[algorithm];
+  static const char hex[] = "0123456789abcdef";
+  size_t i;
+  for (i = 0; i < digest->hex_length; i++) {
+    int nibble = (i % 2 == 0) ? (raw[i / 2] >> 4) : (raw[i / 2] & 0x0f);
+    variable[i] = hex[nibble];
+  }
+  variable[digest->hex_length] = '\0';
+}
@@ -0,0 +1,62 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for digest.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef DIGEST_H
+#define DIGEST_H
+
+// For `size_t`.
+#include <stddef.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The hash algorithms (`--hash`).
+#define DIGEST_MD5 0
+#define DIGEST_SHA256 1
+#define DIGEST_XXH3 2
+#define DIGEST_BLAKE3 3
+#define NUMBER_OF_DIGESTS 4
+
+// The longest hex digest any of them produces.
+#define MAX_DIGEST_HEX_LENGTH 64
+
+// The md5 is truncated to the 31 characters the manifest has always carried.
+#define MD5_HEX_LENGTH 31
+
+// Files at least this big may be hashed on several threads (blake3 only).
+#define DIGEST_PARALLEL_THRESHOLD (4 * 1024 * 1024)
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in digest.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void set_digest_algorithm(int algorithm);
+int get_digest_algorithm(void);
+int find_digest_algorithm(const char *name);
+const char *digest_name(int algorithm);
+void digest_to_hex(int algorithm, int threads, const unsigned char *data, size_t length, char *variable);
+void raw_digest_to_hex(int algorithm, const unsigned char *raw, char *variable);
+
+#endif
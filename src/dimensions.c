@@ -0,0 +1,432 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file works out the width and height of images
+ *    (`--dimensions`) from their headers alone, without
+ *    decoding them:
+ *
+ *      - PNG: the IHDR chunk, which always comes first.
+ *      - GIF: the logical screen descriptor.
+ *      - WebP: the VP8, VP8L or VP8X chunk header.
+ *      - JPEG: the first SOFn segment. Segments before it are
+ *        skipped by their lengths, not read.
+ *      - SVG: the width, height and viewBox of the root
+ *        element, if it's in the first few KB.
+ *
+ *    Reads are bounded: the first DIMENSIONS_HEADER_LENGTH bytes,
+ *    plus (for a JPEG) a few bytes for each of at most
+ *    DIMENSIONS_MAX_JPEG_SEGMENTS segments. When the file has
+ *    already been read (to hash it), nothing is read again.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For `strtod()`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `memcmp()`.
+#include <string.h>
+
+// For `open()`.
+#include <fcntl.h>
+
+// For `pread()` and `close()`.
+#include <unistd.h>
+
+// We need the header that declares the prototypes for this file.
+#include "dimensions.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// Where an image's bytes come from: memory (if the file was
+// already read), or else an open file.
+struct image_source {
+  const unsigned char *data;
+  size_t length;
+  int descriptor;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in dimensions.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Read some bytes of an image, from wherever it is.
+ *
+ *  @param struct image_source *source The image.
+ *  @param uint64_t offset Where the bytes start.
+ *  @param char *into Where to put them.
+ *  @param size_t length How many to read.
+ *  @return int 1 if they were all there, 0 if not.
+ */
+static int read_at(const struct image_source *source, uint64_t offset, unsigned char *into, size_t length) {
+  if (source->data != NULL) {
+    if (offset > source->length || length > source->length - offset) {
+      return 0;
+    }
+    memcpy(into, source->data + offset, length);
+    return 1;
+  }
+  return pread(source->descriptor, into, length, (off_t) offset) == (ssize_t) length;
+}
+
+/*
+ *  Read integers of various widths and byte orders.
+ *
+ *  @param char *bytes Where the integer is.
+ *  @return uint32_t The integer.
+ */
+static uint32_t big_endian_16(const unsigned char *bytes) {
+  return (uint32_t) bytes[0] << 8 | bytes[1];
+}
+
+static uint32_t big_endian_32(const unsigned char *bytes) {
+  return (uint32_t) bytes[0] << 24 | (uint32_t) bytes[1] << 16 | (uint32_t) bytes[2] << 8 | bytes[3];
+}
+
+static uint32_t little_endian_16(const unsigned char *bytes) {
+  return (uint32_t) bytes[1] << 8 | bytes[0];
+}
+
+static uint32_t little_endian_24(const unsigned char *bytes) {
+  return (uint32_t) bytes[2] << 16 | (uint32_t) bytes[1] << 8 | bytes[0];
+}
+
+static uint32_t little_endian_32(const unsigned char *bytes) {
+  return (uint32_t) bytes[3] << 24 | little_endian_24(bytes);
+}
+
+/*
+ *  Find a JPEG's size in its first SOFn segment.
+ *
+ *  @param struct image_source *source The image.
+ *  @param struct image_dimensions *dimensions Where to put the size.
+ *  @return int 1 if it was found, 0 if not.
+ */
+static int jpeg_dimensions(const struct image_source *source, struct image_dimensions *dimensions) {
+
+  // Past the start of image marker, each segment is a marker
+  // (0xFF and a code), then (mostly) a length that counts itself.
+  uint64_t offset = 2;
+  int segments;
+  for (segments = 0; segments < DIMENSIONS_MAX_JPEG_SEGMENTS; segments++) {
+    unsigned char segment[4];
+    if (!read_at(source, offset, segment, sizeof(segment)) || segment[0] != 0xFF) {
+      return 0;
+    }
+    unsigned char marker = segment[1];
+
+    // Fill bytes, and markers that have no segment.
+    if (marker == 0xFF) {
+      offset++;
+      continue;
+    }
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+      offset += 2;
+      continue;
+    }
+
+    // The image data (or its end) comes after the frame header,
+    // so if we get there, there wasn't one.
+    if (marker == 0xD9 || marker == 0xDA) {
+      return 0;
+    }
+
+    uint32_t length = big_endian_16(segment + 2);
+    if (length < 2) {
+      return 0;
+    }
+
+    // SOF0 to SOF15 (but 0xC4, 0xC8 and 0xCC are other things):
+    // the precision, then the height and the width.
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+      unsigned char frame[5];
+      if (!read_at(source, offset + 4, frame, sizeof(frame))) {
+        return 0;
+      }
+      dimensions->height = big_endian_16(frame + 1);
+      dimensions->width = big_endian_16(frame + 3);
+      return 1;
+    }
+
+    offset += 2 + length;
+  }
+
+  return 0;
+
+}
+
+/*
+ *  Find an attribute of an SVG's root element.
+ *
+ *  @param char *tag The element (from "<svg" to its ">").
+ *  @param size_t tag_length Its length.
+ *  @param char *name The attribute's name.
+ *  @param char *value Where to put its value.
+ *  @param size_t room How much room there is there.
+ *  @return int 1 if it's there, 0 if not.
+ */
+static int svg_attribute(const char *tag, size_t tag_length, const char *name, char *value, size_t room) {
+  size_t name_length = strlen(name);
+  size_t i;
+  for (i = 1; i + name_length < tag_length; i++) {
+
+    // The name has to be a whole name (so "width" isn't "stroke-width").
+    char before = tag[i - 1];
+    if ((before != ' ' && before != '\t' && before != '\n' && before != '\r')
+        || memcmp(tag + i, name, name_length) != 0) {
+      continue;
+    }
+
+    size_t at = i + name_length;
+    while (at < tag_length && (tag[at] == ' ' || tag[at] == '\t' || tag[at] == '\n' || tag[at] == '\r')) {
+      at++;
+    }
+    if (at >= tag_length || tag[at] != '=') {
+      continue;
+    }
+    at++;
+    while (at < tag_length && (tag[at] == ' ' || tag[at] == '\t' || tag[at] == '\n' || tag[at] == '\r')) {
+      at++;
+    }
+    if (at >= tag_length || (tag[at] != '"' && tag[at] != '\'')) {
+      continue;
+    }
+
+    char quote = tag[at++];
+    size_t length = 0;
+    while (at < tag_length && tag[at] != quote && length + 1 < room) {
+      value[length++] = tag[at++];
+    }
+    value[length] = '\0';
+    return at < tag_length && tag[at] == quote;
+
+  }
+  return 0;
+}
+
+/*
+ *  Read an SVG length. Only plain numbers and pixels are
+ *  sizes we can use: "100%" or "10em" depend on where it's shown.
+ *
+ *  @param char *value The attribute's value.
+ *  @param double *length Where to put the length.
+ *  @return int 1 if it's a size in pixels, 0 if not.
+ */
+static int svg_length(const char *value, double *length) {
+  char *end;
+  *length = strtod(value, &end);
+  if (end == value || *length <= 0) {
+    return 0;
+  }
+  while (*end == ' ') {
+    end++;
+  }
+  if (strncmp(end, "px", 2) == 0) {
+    end += 2;
+  }
+  while (*end == ' ') {
+    end++;
+  }
+  return *end == '\0';
+}
+
+/*
+ *  Find an SVG's size from its root element: its width and
+ *  height, or what's missing from them, its viewBox.
+ *
+ *  @param char *head The top of the file.
+ *  @param size_t length How much of it there is.
+ *  @param struct image_dimensions *dimensions Where to put the size.
+ *  @return int 1 if it was found, 0 if not.
+ */
+static int svg_dimensions(const unsigned char *head, size_t length, struct image_dimensions *dimensions) {
+
+  // Find the root element.
+  const char *text = (const char *) head;
+  size_t start;
+  for (start = 0; start + 5 <= length; start++) {
+    if (text[start] == '<' && memcmp(text + start, "<svg", 4) == 0
+        && (text[start + 4] == ' ' || text[start + 4] == '\t' || text[start + 4] == '\n' || text[start + 4] == '\r')) {
+      break;
+    }
+  }
+  if (start + 5 > length) {
+    return 0;
+  }
+  size_t end = start;
+  while (end < length && text[end] != '>') {
+    end++;
+  }
+
+  char value[128];
+  double width = 0, height = 0;
+  int has_width = svg_attribute(text + start, end - start, "width", value, sizeof(value))
+    && svg_length(value, &width);
+  int has_height = svg_attribute(text + start, end - start, "height", value, sizeof(value))
+    && svg_length(value, &height);
+
+  // The viewBox is "min-x min-y width height".
+  double box[4] = { 0, 0, 0, 0 };
+  int has_box = 0;
+  if (svg_attribute(text + start, end - start, "viewBox", value, sizeof(value))) {
+    char *cursor = value;
+    int i;
+    for (i = 0; i < 4; i++) {
+      while (*cursor == ' ' || *cursor == ',') {
+        cursor++;
+      }
+      char *next;
+      box[i] = strtod(cursor, &next);
+      if (next == cursor) {
+        break;
+      }
+      cursor = next;
+    }
+    has_box = i == 4 && box[2] > 0 && box[3] > 0;
+  }
+
+  // Fill in what's missing from the viewBox, keeping its aspect ratio.
+  if (!has_width && !has_height && has_box) {
+    width = box[2];
+    height = box[3];
+  } else if (has_width && !has_height && has_box) {
+    height = width * box[3] / box[2];
+  } else if (!has_width && has_height && has_box) {
+    width = height * box[2] / box[3];
+  } else if (!has_width || !has_height) {
+    return 0;
+  }
+
+  if (width >= 4294967295.0 || height >= 4294967295.0) {
+    return 0;
+  }
+  dimensions->width = (uint32_t) (width + 0.5);
+  dimensions->height = (uint32_t) (height + 0.5);
+  return 1;
+
+}
+
+/*
+ *  Work out an image's size from its header.
+ *
+ *  @param struct image_source *source The image.
+ *  @param char *head Its first bytes.
+ *  @param size_t length How many there are (at most DIMENSIONS_HEADER_LENGTH).
+ *  @param struct image_dimensions *dimensions Where to put the size.
+ *  @return int 1 if it was found, 0 if not.
+ */
+static int find_dimensions(const struct image_source *source, const unsigned char *head, size_t length,
+                           struct image_dimensions *dimensions) {
+
+  int found = 0;
+
+  // PNG: the signature, then the IHDR chunk.
+  if (length >= 24 && memcmp(head, "\x89PNG\r\n\x1a\n", 8) == 0 && memcmp(head + 12, "IHDR", 4) == 0) {
+    dimensions->width = big_endian_32(head + 16);
+    dimensions->height = big_endian_32(head + 20);
+    found = 1;
+  }
+
+  // GIF: the signature, then the logical screen's size.
+  else if (length >= 10 && (memcmp(head, "GIF87a", 6) == 0 || memcmp(head, "GIF89a", 6) == 0)) {
+    dimensions->width = little_endian_16(head + 6);
+    dimensions->height = little_endian_16(head + 8);
+    found = 1;
+  }
+
+  // WebP: a RIFF container, then a lossy, lossless or extended chunk.
+  else if (length >= 30 && memcmp(head, "RIFF", 4) == 0 && memcmp(head + 8, "WEBP", 4) == 0) {
+    if (memcmp(head + 12, "VP8 ", 4) == 0 && memcmp(head + 23, "\x9d\x01\x2a", 3) == 0) {
+      dimensions->width = little_endian_16(head + 26) & 0x3FFF;
+      dimensions->height = little_endian_16(head + 28) & 0x3FFF;
+      found = 1;
+    } else if (memcmp(head + 12, "VP8L", 4) == 0 && head[20] == 0x2F) {
+      uint32_t bits = little_endian_32(head + 21);
+      dimensions->width = (bits & 0x3FFF) + 1;
+      dimensions->height = ((bits >> 14) & 0x3FFF) + 1;
+      found = 1;
+    } else if (memcmp(head + 12, "VP8X", 4) == 0) {
+      dimensions->width = little_endian_24(head + 24) + 1;
+      dimensions->height = little_endian_24(head + 27) + 1;
+      found = 1;
+    }
+  }
+
+  // JPEG: the start of image marker, then segments.
+  else if (length >= 3 && memcmp(head, "\xff\xd8\xff", 3) == 0) {
+    found = jpeg_dimensions(source, dimensions);
+  }
+
+  // Otherwise, it may be an SVG.
+  else {
+    found = svg_dimensions(head, length, dimensions);
+  }
+
+  return found && dimensions->width > 0 && dimensions->height > 0;
+
+}
+
+/*
+ *  Work out an image's size from its contents.
+ *
+ *  @param char *data The contents of the file.
+ *  @param size_t length How long it is.
+ *  @param struct image_dimensions *dimensions Where to put the size.
+ *  @return int 1 if it was found, 0 if it isn't an image we can size.
+ */
+int image_dimensions(const unsigned char *data, size_t length, struct image_dimensions *dimensions) {
+  struct image_source source = { data, length, -1 };
+  return find_dimensions(&source, data, length < DIMENSIONS_HEADER_LENGTH ? length : DIMENSIONS_HEADER_LENGTH,
+                         dimensions);
+}
+
+/*
+ *  Work out an image's size, reading only its header.
+ *
+ *  @param char *path The path to the file.
+ *  @param struct image_dimensions *dimensions Where to put the size.
+ *  @return int 1 if it was found, 0 if it isn't an image we can size
+ *              (or it can't be read).
+ */
+int file_image_dimensions(const char *path, struct image_dimensions *dimensions) {
+  int descriptor = open(path, O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0) {
+    return 0;
+  }
+  unsigned char head[DIMENSIONS_HEADER_LENGTH];
+  ssize_t length = pread(descriptor, head, sizeof(head), 0);
+  struct image_source source = { NULL, 0, descriptor };
+  int found = length > 0 && find_dimensions(&source, head, (size_t) length, dimensions);
+  close(descriptor);
+  return found;
+}
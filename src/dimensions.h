@@ -0,0 +1,71 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for dimensions.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef DIMENSIONS_H
+#define DIMENSIONS_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For fixed width integers, e.g., `uint32_t`.
+#include <stdint.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// How much of the top of a file we look at. It's enough for
+// the headers of PNG, GIF and WebP, and for an SVG's root element.
+#define DIMENSIONS_HEADER_LENGTH 4096
+
+// A JPEG's size is in its SOFn segment, which can come after
+// others (EXIF, ICC profiles, etc.). We look at this many
+// segments at most before we give up.
+#define DIMENSIONS_MAX_JPEG_SEGMENTS 64
+
+// Room in an entry for the width and height.
+#define DIMENSIONS_ENTRY_LENGTH 48
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The size of an image, in pixels.
+struct image_dimensions {
+  uint32_t width;
+  uint32_t height;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in dimensions.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+int image_dimensions(const unsigned char *data, size_t length, struct image_dimensions *dimensions);
+int file_image_dimensions(const char *path, struct image_dimensions *dimensions);
+
+#endif
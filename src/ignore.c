@@ -0,0 +1,742 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides the set of patterns to ignore
+ *    (`--ignore`, `--ignore-file`). They work like .gitignore:
+ *    "*", "?" and "[...]" match within a name, "**" matches any
+ *    number of directories, a pattern with a "/" in it is matched
+ *    from the top of the walk, a trailing "/" only matches folders,
+ *    a leading "!" un-ignores, and the last pattern that matches wins.
+ *
+ *    Patterns are compiled once, up front. Most are plain names,
+ *    or a name with a "*" at one end (e.g. "tmp*" or "*.map"):
+ *    those go in an open-addressing hash table, so looking them up
+ *    is a hash and (usually) one comparison, with no copying. The
+ *    rest are compiled into a list of tokens, so matching them
+ *    never has to parse the pattern again.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `memcmp()`.
+#include <string.h>
+
+// For checking character types, e.g., `isspace()`.
+#include <ctype.h>
+
+// We need the header that declares the prototypes for this file.
+#include "ignore.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define INITIAL_IGNORE_CAPACITY 16
+#define INITIAL_PATTERN_CAPACITY 8
+#define MAX_IGNORE_LINE_LENGTH 4096
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in ignore.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Hash some bytes (FNV-1a), seeded with the kind of entry,
+ *  so "foo", "foo*" and "*foo" don't collide.
+ *
+ *  @param char *bytes The bytes to hash.
+ *  @param size_t length The number of bytes.
+ *  @param int kind IGNORE_EXACT, IGNORE_PREFIX or IGNORE_SUFFIX.
+ *  @return uint32_t The hash.
+ */
+static uint32_t hash_name(const char *bytes, size_t length, int kind) {
+  uint32_t hash = 2166136261u ^ (uint32_t) kind;
+  size_t i;
+  for (i = 0; i < length; i++) {
+    hash ^= (unsigned char) bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/*
+ *  Find the slot for a name: either where it is, or the
+ *  empty slot where it would go.
+ *
+ *  @param struct ignore_set *set The set.
+ *  @param char *bytes The name.
+ *  @param size_t length The length of the name.
+ *  @param int kind IGNORE_EXACT, IGNORE_PREFIX or IGNORE_SUFFIX.
+ *  @param uint32_t hash The name's hash.
+ *  @return struct ignore_slot * The slot.
+ */
+static struct ignore_slot *find_slot(const struct ignore_set *set, const char *bytes, size_t length, int kind, uint32_t hash) {
+  size_t mask = set->capacity - 1;
+  size_t index = hash & mask;
+  while (set->slots[index].name != NULL) {
+    struct ignore_slot *slot = &set->slots[index];
+    if (slot->hash == hash && slot->kind == kind && slot->length == length
+        && memcmp(slot->name, bytes, length) == 0) {
+      return slot;
+    }
+    index = (index + 1) & mask;
+  }
+  return &set->slots[index];
+}
+
+/*
+ *  Allocate a table of empty slots.
+ *
+ *  @param size_t capacity The number of slots (a power of two).
+ *  @return struct ignore_slot * The slots.
+ */
+static struct ignore_slot *allocate_slots(size_t capacity) {
+  struct ignore_slot *slots = calloc(capacity, sizeof(struct ignore_slot));
+  if (slots == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  return slots;
+}
+
+/*
+ *  Create an empty set.
+ *
+ *  @param struct ignore_set *set The set to initialize.
+ *  @return void
+ */
+void init_ignore_set(struct ignore_set *set) {
+  set->capacity = INITIAL_IGNORE_CAPACITY;
+  set->count = 0;
+  set->slots = allocate_slots(set->capacity);
+  set->number_of_prefix_lengths = 0;
+  set->number_of_suffix_lengths = 0;
+  set->patterns = NULL;
+  set->number_of_patterns = 0;
+  set->pattern_capacity = 0;
+  set->next_position = 0;
+}
+
+/*
+ *  Is there room to note prefixes (or suffixes) of a given length?
+ *  There is if the length is known already, or there's a free spot.
+ *
+ *  @param size_t lengths[] The known lengths.
+ *  @param int count How many lengths are known.
+ *  @param size_t length The length.
+ *  @return int 1 if yes, 0 if no.
+ */
+static int has_room_for_length(const size_t lengths[], int count, size_t length) {
+  int i;
+  for (i = 0; i < count; i++) {
+    if (lengths[i] == length) {
+      return 1;
+    }
+  }
+  return count < MAX_IGNORE_LENGTHS;
+}
+
+/*
+ *  Note that prefixes (or suffixes) of a given length exist.
+ *  The caller has checked there's room (`has_room_for_length()`).
+ *
+ *  @param size_t lengths[] The known lengths.
+ *  @param int *count How many lengths are known.
+ *  @param size_t length The length to add.
+ *  @return void
+ */
+static void remember_length(size_t lengths[], int *count, size_t length) {
+  int i;
+  for (i = 0; i < *count; i++) {
+    if (lengths[i] == length) {
+      return;
+    }
+  }
+  if (*count < MAX_IGNORE_LENGTHS) {
+    lengths[(*count)++] = length;
+  }
+}
+
+/*
+ *  Add one name to the set, growing the table if need be.
+ *
+ *  @param struct ignore_set *set The set.
+ *  @param char *bytes The name.
+ *  @param size_t length The length of the name.
+ *  @param int kind IGNORE_EXACT, IGNORE_PREFIX or IGNORE_SUFFIX.
+ *  @param int position Where its pattern came in the list.
+ *  @param int negated 1 if it un-ignores, 0 if it ignores.
+ *  @return void
+ */
+static void add_name(struct ignore_set *set, const char *bytes, size_t length, int kind, int position, int negated) {
+
+  // Keep the table at most half full.
+  if ((set->count + 1) * 2 > set->capacity) {
+    struct ignore_slot *old_slots = set->slots;
+    size_t old_capacity = set->capacity;
+    set->capacity *= 2;
+    set->slots = allocate_slots(set->capacity);
+    size_t i;
+    for (i = 0; i < old_capacity; i++) {
+      if (old_slots[i].name != NULL) {
+        *find_slot(set, old_slots[i].name, old_slots[i].length, old_slots[i].kind, old_slots[i].hash) = old_slots[i];
+      }
+    }
+    free(old_slots);
+  }
+
+  uint32_t hash = hash_name(bytes, length, kind);
+  struct ignore_slot *slot = find_slot(set, bytes, length, kind, hash);
+
+  // The same pattern again: the later one wins.
+  if (slot->name != NULL) {
+    slot->position = position;
+    slot->negated = negated;
+    return;
+  }
+
+  slot->name = malloc(length + 1);
+  if (slot->name == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  memcpy(slot->name, bytes, length);
+  slot->name[length] = '\0';
+  slot->length = length;
+  slot->kind = kind;
+  slot->hash = hash;
+  slot->position = position;
+  slot->negated = negated;
+  set->count++;
+
+  if (kind == IGNORE_PREFIX) {
+    remember_length(set->prefix_lengths, &set->number_of_prefix_lengths, length);
+  } else if (kind == IGNORE_SUFFIX) {
+    remember_length(set->suffix_lengths, &set->number_of_suffix_lengths, length);
+  }
+
+}
+
+/*
+ *  Add a piece to a compiled pattern.
+ *
+ *  @param struct ignore_pattern *pattern The pattern.
+ *  @param int type The kind of token.
+ *  @return struct ignore_token* The token (all zeros but its type).
+ */
+static struct ignore_token *add_token(struct ignore_pattern *pattern, int type) {
+  struct ignore_token *grown = realloc(pattern->tokens, (pattern->number_of_tokens + 1) * sizeof(struct ignore_token));
+  if (grown == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  pattern->tokens = grown;
+  struct ignore_token *token = &pattern->tokens[pattern->number_of_tokens++];
+  memset(token, 0, sizeof(struct ignore_token));
+  token->type = type;
+  return token;
+}
+
+/*
+ *  Add a literal byte to a compiled pattern, joining it onto
+ *  the literal before it if there is one.
+ *
+ *  @param struct ignore_pattern *pattern The pattern.
+ *  @param char byte The byte.
+ *  @return void
+ */
+static void add_literal(struct ignore_pattern *pattern, char byte) {
+  struct ignore_token *token = NULL;
+  if (pattern->number_of_tokens > 0 && pattern->tokens[pattern->number_of_tokens - 1].type == IGNORE_LITERAL) {
+    token = &pattern->tokens[pattern->number_of_tokens - 1];
+  } else {
+    token = add_token(pattern, IGNORE_LITERAL);
+  }
+  char *grown = realloc(token->literal, token->length + 2);
+  if (grown == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  token->literal = grown;
+  token->literal[token->length++] = byte;
+  token->literal[token->length] = '\0';
+}
+
+/*
+ *  Compile a "[...]" class into a bitmap of the bytes it matches.
+ *
+ *  @param struct ignore_token *token The token to fill in.
+ *  @param char *start Just after the "[".
+ *  @param char *end The end of the pattern.
+ *  @return char* Just after the "]", or NULL if there isn't one
+ *                (so the "[" is just a "[").
+ */
+static const char *compile_class(struct ignore_token *token, const char *start, const char *end) {
+
+  const char *cursor = start;
+  int negated = 0;
+  if (cursor < end && (*cursor == '!' || *cursor == '^')) {
+    negated = 1;
+    cursor++;
+  }
+
+  // A "]" straight after the "[" (or "[!") is part of the class.
+  int first = 1;
+  while (cursor < end && (*cursor != ']' || first)) {
+    first = 0;
+    unsigned char low = (unsigned char) *cursor;
+    if (low == '\\' && cursor + 1 < end) {
+      low = (unsigned char) *++cursor;
+    }
+    unsigned char high = low;
+    if (cursor + 2 < end && cursor[1] == '-' && cursor[2] != ']') {
+      high = (unsigned char) cursor[2];
+      cursor += 2;
+    }
+    unsigned int byte;
+    for (byte = low; byte <= high; byte++) {
+      token->characters[byte / 32] |= 1u << (byte % 32);
+    }
+    cursor++;
+  }
+  if (cursor >= end) {
+    return NULL;
+  }
+
+  if (negated) {
+    int i;
+    for (i = 0; i < 8; i++) {
+      token->characters[i] = ~token->characters[i];
+    }
+  }
+  return cursor + 1;
+
+}
+
+/*
+ *  Compile a glob into tokens.
+ *
+ *  @param struct ignore_pattern *pattern The pattern to fill in.
+ *  @param char *text The glob (without any "!", leading "/" or trailing "/").
+ *  @param size_t length Its length.
+ *  @return void
+ */
+static void compile_pattern(struct ignore_pattern *pattern, const char *text, size_t length) {
+
+  const char *cursor = text;
+  const char *end = text + length;
+  while (cursor < end) {
+
+    // "**" on its own between slashes (or at either end) spans
+    // directories, in patterns that are matched against paths.
+    int at_start = cursor == text || cursor[-1] == '/';
+    if (pattern->matches_path && at_start && end - cursor >= 2 && cursor[0] == '*' && cursor[1] == '*'
+        && (cursor + 2 == end || cursor[2] == '/')) {
+      if (cursor + 2 == end) {
+        add_token(pattern, IGNORE_EVERYTHING);
+        cursor += 2;
+      } else {
+        add_token(pattern, IGNORE_DIRECTORIES);
+        cursor += 3;
+      }
+      continue;
+    }
+
+    if (*cursor == '*') {
+      // Any other run of stars is one star.
+      if (pattern->number_of_tokens == 0 || pattern->tokens[pattern->number_of_tokens - 1].type != IGNORE_STAR) {
+        add_token(pattern, IGNORE_STAR);
+      }
+      cursor++;
+    } else if (*cursor == '?') {
+      add_token(pattern, IGNORE_ANY_CHARACTER);
+      cursor++;
+    } else if (*cursor == '[') {
+      struct ignore_token class;
+      memset(&class, 0, sizeof(class));
+      const char *after = compile_class(&class, cursor + 1, end);
+      if (after == NULL) {
+        add_literal(pattern, '[');
+        cursor++;
+      } else {
+        class.type = IGNORE_CHARACTER_CLASS;
+        *add_token(pattern, IGNORE_CHARACTER_CLASS) = class;
+        cursor = after;
+      }
+    } else if (*cursor == '\\' && cursor + 1 < end) {
+      add_literal(pattern, cursor[1]);
+      cursor += 2;
+    } else {
+      add_literal(pattern, *cursor);
+      cursor++;
+    }
+
+  }
+
+}
+
+/*
+ *  Is this glob just a name, or a name with a "*" at one end?
+ *
+ *  @param char *text The glob.
+ *  @param size_t length Its length.
+ *  @return int IGNORE_EXACT, IGNORE_PREFIX or IGNORE_SUFFIX, or -1 if it's anything else.
+ */
+static int simple_kind(const char *text, size_t length) {
+  size_t i;
+  for (i = 0; i < length; i++) {
+    int is_star_at_one_end = text[i] == '*' && length > 1
+      && ((i == 0 && text[length - 1] != '*') || (i == length - 1 && text[0] != '*'));
+    if (strchr("*?[\\/", text[i]) != NULL && !is_star_at_one_end) {
+      return -1;
+    }
+  }
+  if (length > 1 && text[0] == '*') {
+    return IGNORE_SUFFIX;
+  } else if (length > 1 && text[length - 1] == '*') {
+    return IGNORE_PREFIX;
+  }
+  return IGNORE_EXACT;
+}
+
+/*
+ *  Add one pattern to the set.
+ *
+ *  @param struct ignore_set *set The set.
+ *  @param char *text The pattern, e.g. "*.map", "!keep.map" or "build/tmp/".
+ *  @param size_t length Its length.
+ *  @return void
+ */
+static void add_pattern(struct ignore_set *set, const char *text, size_t length) {
+
+  int position = set->next_position++;
+
+  // "!" un-ignores (a literal "!" is written "\!").
+  int negated = 0;
+  if (length > 0 && text[0] == '!') {
+    negated = 1;
+    text++;
+    length--;
+  }
+
+  // A trailing "/" only matches folders.
+  int directory_only = 0;
+  if (length > 0 && text[length - 1] == '/') {
+    directory_only = 1;
+    length--;
+  }
+
+  // Any other "/" ties the pattern to the top of the walk
+  // (a leading one only does that).
+  int matches_path = memchr(text, '/', length) != NULL;
+  if (length > 0 && text[0] == '/') {
+    text++;
+    length--;
+  }
+  if (length == 0) {
+    return;
+  }
+
+  // The usual case: a name, a prefix or a suffix. Prefixes and
+  // suffixes only come in MAX_IGNORE_LENGTHS lengths; past that,
+  // they're compiled like any other pattern.
+  int kind = simple_kind(text, length);
+  if (kind == IGNORE_PREFIX && !has_room_for_length(set->prefix_lengths, set->number_of_prefix_lengths, length - 1)) {
+    kind = -1;
+  } else if (kind == IGNORE_SUFFIX && !has_room_for_length(set->suffix_lengths, set->number_of_suffix_lengths, length - 1)) {
+    kind = -1;
+  }
+  if (kind >= 0 && !directory_only && !matches_path) {
+    if (kind == IGNORE_SUFFIX) {
+      add_name(set, text + 1, length - 1, kind, position, negated);
+    } else if (kind == IGNORE_PREFIX) {
+      add_name(set, text, length - 1, kind, position, negated);
+    } else {
+      add_name(set, text, length, kind, position, negated);
+    }
+    return;
+  }
+
+  // Otherwise, compile it.
+  if (set->number_of_patterns == set->pattern_capacity) {
+    int new_capacity = set->pattern_capacity ? set->pattern_capacity * 2 : INITIAL_PATTERN_CAPACITY;
+    struct ignore_pattern *grown = realloc(set->patterns, new_capacity * sizeof(struct ignore_pattern));
+    if (grown == NULL) {
+      puts("malloc failure, wtf");
+      exit(1);
+    }
+    set->patterns = grown;
+    set->pattern_capacity = new_capacity;
+  }
+  struct ignore_pattern *pattern = &set->patterns[set->number_of_patterns++];
+  memset(pattern, 0, sizeof(struct ignore_pattern));
+  pattern->position = position;
+  pattern->negated = negated;
+  pattern->directory_only = directory_only;
+  pattern->matches_path = matches_path;
+  compile_pattern(pattern, text, length);
+
+}
+
+/*
+ *  Add a comma separated list of patterns to the set.
+ *
+ *  @param struct ignore_set *set The set.
+ *  @param char *list The list, e.g. ".git,dist,*.map".
+ *  @return void
+ */
+void add_to_ignore_set(struct ignore_set *set, const char *list) {
+
+  const char *token = list;
+  while (*token != '\0') {
+
+    // Find the end of this pattern.
+    const char *end = strchr(token, ',');
+    if (end == NULL) {
+      end = token + strlen(token);
+    }
+
+    add_pattern(set, token, (size_t) (end - token));
+
+    token = (*end == ',') ? end + 1 : end;
+
+  }
+
+}
+
+/*
+ *  Add the patterns in a .gitignore style file to the set: one
+ *  per line, skipping blank lines and "#" comments.
+ *
+ *  @param struct ignore_set *set The set.
+ *  @param char *path The path to the file.
+ *  @return int 1 if it was read, 0 if it couldn't be.
+ */
+int add_ignore_file(struct ignore_set *set, const char *path) {
+
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    return 0;
+  }
+
+  char line[MAX_IGNORE_LINE_LENGTH];
+  while (fgets(line, sizeof(line), file) != NULL) {
+
+    // Drop the line ending, and trailing spaces (unless they're escaped).
+    size_t length = strcspn(line, "\r\n");
+    while (length > 0 && isspace((unsigned char) line[length - 1])
+           && !(length > 1 && line[length - 2] == '\\')) {
+      length--;
+    }
+
+    if (length == 0 || line[0] == '#') {
+      continue;
+    }
+    add_pattern(set, line, length);
+
+  }
+
+  int failed = ferror(file);
+  fclose(file);
+  return !failed;
+
+}
+
+/*
+ *  Does a compiled pattern match some text, from this token on?
+ *
+ *  @param struct ignore_token *tokens The tokens left.
+ *  @param int count How many there are.
+ *  @param char *text The text left.
+ *  @return int 1 if it matches, 0 if not.
+ */
+static int match_tokens(const struct ignore_token *tokens, int count, const char *text) {
+
+  while (count > 0) {
+    const struct ignore_token *token = tokens;
+    unsigned char byte = (unsigned char) *text;
+    switch (token->type) {
+
+      case IGNORE_LITERAL:
+        if (strncmp(text, token->literal, token->length) != 0) {
+          return 0;
+        }
+        text += token->length;
+        break;
+
+      case IGNORE_ANY_CHARACTER:
+        if (byte == '\0' || byte == '/') {
+          return 0;
+        }
+        text++;
+        break;
+
+      case IGNORE_CHARACTER_CLASS:
+        if (byte == '\0' || byte == '/' || !(token->characters[byte / 32] & (1u << (byte % 32)))) {
+          return 0;
+        }
+        text++;
+        break;
+
+      // Anything up to the next "/": try each length.
+      case IGNORE_STAR:
+        if (count == 1) {
+          return strchr(text, '/') == NULL;
+        }
+        for (;;) {
+          if (match_tokens(tokens + 1, count - 1, text)) {
+            return 1;
+          }
+          if (*text == '\0' || *text == '/') {
+            return 0;
+          }
+          text++;
+        }
+
+      // Any number of whole directories: try after each "/".
+      case IGNORE_DIRECTORIES:
+        for (;;) {
+          if (match_tokens(tokens + 1, count - 1, text)) {
+            return 1;
+          }
+          text = strchr(text, '/');
+          if (text == NULL) {
+            return 0;
+          }
+          text++;
+        }
+
+      case IGNORE_EVERYTHING:
+        return 1;
+
+    }
+    tokens++;
+    count--;
+  }
+
+  return *text == '\0';
+
+}
+
+/*
+ *  Is a file or folder ignored?
+ *
+ *  @param struct ignore_set *set The set.
+ *  @param char *path Its path from the top of the walk (e.g. "src/app.js").
+ *  @param int is_directory 1 if it's a folder, 0 if not.
+ *  @return int 1 if it should be ignored, 0 if not.
+ */
+int is_ignored(const struct ignore_set *set, const char *path, int is_directory) {
+
+  const char *slash = strrchr(path, '/');
+  const char *name = slash != NULL ? slash + 1 : path;
+  size_t length = strlen(name);
+
+  // The last pattern that matches decides.
+  int best_position = -1;
+  int best_negated = 0;
+
+  // The usual case: an exact match.
+  struct ignore_slot *slot = find_slot(set, name, length, IGNORE_EXACT, hash_name(name, length, IGNORE_EXACT));
+  if (slot->name != NULL) {
+    best_position = slot->position;
+    best_negated = slot->negated;
+  }
+
+  // Then any prefixes or suffixes that are short enough to match.
+  int i;
+  for (i = 0; i < set->number_of_prefix_lengths; i++) {
+    size_t prefix_length = set->prefix_lengths[i];
+    if (prefix_length <= length) {
+      slot = find_slot(set, name, prefix_length, IGNORE_PREFIX, hash_name(name, prefix_length, IGNORE_PREFIX));
+      if (slot->name != NULL && slot->position > best_position) {
+        best_position = slot->position;
+        best_negated = slot->negated;
+      }
+    }
+  }
+  for (i = 0; i < set->number_of_suffix_lengths; i++) {
+    size_t suffix_length = set->suffix_lengths[i];
+    if (suffix_length <= length) {
+      const char *suffix = name + length - suffix_length;
+      slot = find_slot(set, suffix, suffix_length, IGNORE_SUFFIX, hash_name(suffix, suffix_length, IGNORE_SUFFIX));
+      if (slot->name != NULL && slot->position > best_position) {
+        best_position = slot->position;
+        best_negated = slot->negated;
+      }
+    }
+  }
+
+  // Then the compiled patterns, latest first, as long as
+  // they could still beat what we've found.
+  for (i = set->number_of_patterns - 1; i >= 0 && set->patterns[i].position > best_position; i--) {
+    const struct ignore_pattern *pattern = &set->patterns[i];
+    if (pattern->directory_only && !is_directory) {
+      continue;
+    }
+    if (match_tokens(pattern->tokens, pattern->number_of_tokens, pattern->matches_path ? path : name)) {
+      best_position = pattern->position;
+      best_negated = pattern->negated;
+      break;
+    }
+  }
+
+  return best_position >= 0 && !best_negated;
+
+}
+
+/*
+ *  Free a set's memory.
+ *
+ *  @param struct ignore_set *set The set.
+ *  @return void
+ */
+void free_ignore_set(struct ignore_set *set) {
+  size_t i;
+  for (i = 0; i < set->capacity; i++) {
+    free(set->slots[i].name);
+  }
+  free(set->slots);
+  set->slots = NULL;
+  set->capacity = 0;
+  set->count = 0;
+  int j, k;
+  for (j = 0; j < set->number_of_patterns; j++) {
+    for (k = 0; k < set->patterns[j].number_of_tokens; k++) {
+      free(set->patterns[j].tokens[k].literal);
+    }
+    free(set->patterns[j].tokens);
+  }
+  free(set->patterns);
+  set->patterns = NULL;
+  set->number_of_patterns = 0;
+  set->pattern_capacity = 0;
+}
@@ -0,0 +1,123 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for ignore.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef IGNORE_H
+#define IGNORE_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For fixed width integers, e.g., `uint32_t`.
+#include <stdint.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define IGNORE_EXACT 0
+#define IGNORE_PREFIX 1
+#define IGNORE_SUFFIX 2
+#define MAX_IGNORE_LENGTHS 64
+
+// The pieces a glob pattern is compiled into.
+#define IGNORE_LITERAL 0
+#define IGNORE_ANY_CHARACTER 1
+#define IGNORE_CHARACTER_CLASS 2
+#define IGNORE_STAR 3
+#define IGNORE_DIRECTORIES 4
+#define IGNORE_EVERYTHING 5
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// One name (or prefix, or suffix) in the set. `position` is where
+// its pattern came in the list: when several patterns match, the
+// last one wins, and a `negated` one ("!name") un-ignores.
+struct ignore_slot {
+  char *name;
+  size_t length;
+  int kind;
+  uint32_t hash;
+  int position;
+  int negated;
+};
+
+// One piece of a compiled glob: a run of literal bytes, "?",
+// a "[...]" class (a bitmap of bytes), "*", "**/" (any number
+// of directories) or a trailing "/**" (everything inside).
+struct ignore_token {
+  int type;
+  char *literal;
+  size_t length;
+  uint32_t characters[8];
+};
+
+// A pattern that isn't a plain name, prefix or suffix, compiled
+// once into tokens. A pattern with a "/" in it (other than at the
+// end) is matched against the path from the top of the walk;
+// any other is matched against the name alone, at any depth.
+struct ignore_pattern {
+  struct ignore_token *tokens;
+  int number_of_tokens;
+  int position;
+  int negated;
+  int directory_only;
+  int matches_path;
+};
+
+// A set of names to ignore, built once and then only read.
+// Prefixes ("name*") and suffixes ("*name") are kept in the same
+// table, and we remember which lengths they come in so a lookup
+// only probes lengths that can match.
+// The rest of the patterns are compiled globs, in the order
+// they came in.
+struct ignore_set {
+  struct ignore_slot *slots;
+  size_t capacity;
+  size_t count;
+  size_t prefix_lengths[MAX_IGNORE_LENGTHS];
+  int number_of_prefix_lengths;
+  size_t suffix_lengths[MAX_IGNORE_LENGTHS];
+  int number_of_suffix_lengths;
+  struct ignore_pattern *patterns;
+  int number_of_patterns;
+  int pattern_capacity;
+  int next_position;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in ignore.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void init_ignore_set(struct ignore_set *set);
+void add_to_ignore_set(struct ignore_set *set, const char *list);
+int add_ignore_file(struct ignore_set *set, const char *path);
+int is_ignored(const struct ignore_set *set, const char *path, int is_directory);
+void free_ignore_set(struct ignore_set *set);
+
+#endif
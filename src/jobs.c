@@ -0,0 +1,376 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file runs the walk on several threads (`--jobs N`).
+ *
+ *    Every worker thread owns a deque of jobs. A job is either
+ *    a directory to read or a file to process. Workers push
+ *    what they find onto the back of their own deque and take
+ *    work from the back too (so they stay deep in the subtree
+ *    they're already in), and when they run dry they steal
+ *    from the front of somebody else's deque (the oldest, and
+ *    usually biggest, piece of work).
+ *
+ *    The deques belong to a pool that lives as long as one
+ *    walk, so separate scans never share workers.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `strdup()`.
+#include <string.h>
+
+// For using the `stat()` function.
+#include <sys/stat.h>
+
+// For threads and mutexes.
+#include <pthread.h>
+
+// For `sched_yield()`.
+#include <sched.h>
+
+// For `nanosleep()`.
+#include <time.h>
+
+// For the shared count of outstanding jobs.
+#include <stdatomic.h>
+
+// We walk directories and process files with these.
+#include "processing.h"
+
+// We need the header that declares the prototypes for this file.
+#include "jobs.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define INITIAL_DEQUE_CAPACITY 256
+#define SPINS_BEFORE_SLEEPING 64
+#define IDLE_SLEEP_NANOSECONDS 100000
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// One piece of work: a directory to read or a file to process.
+struct job {
+  int type;
+  char *path;
+  int has_info;
+  struct stat info;
+};
+
+// A worker's deque. The owner uses the back, thieves use the front.
+struct deque {
+  pthread_mutex_t lock;
+  struct job *jobs;
+  size_t front;
+  size_t back;
+  size_t capacity;
+};
+
+// The workers of one walk.
+struct job_pool {
+  struct scan *scan;
+  int number_of_workers;
+  struct deque deques[MAX_JOBS];
+
+  // Jobs that have been submitted but not yet finished.
+  atomic_long outstanding_jobs;
+};
+
+// What a worker thread starts with.
+struct worker {
+  struct job_pool *pool;
+  int number;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  NON-CONSTANT VARIABLES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// Which worker the current thread is (-1 if it isn't one),
+// and of which pool: a worker's callback can start a scan
+// of its own, whose pool it isn't a worker of.
+__thread int current_worker = -1;
+__thread struct job_pool *current_pool = NULL;
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in jobs.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Push a job onto the back of a deque, growing it if need be.
+ *
+ *  @param struct deque *deque The deque.
+ *  @param struct job *job The job to copy in.
+ *  @return void
+ */
+static void push_back(struct deque *deque, struct job *job) {
+
+  pthread_mutex_lock(&deque->lock);
+
+  // Out of room? Compact to the start, and grow if that's not enough.
+  if (deque->back == deque->capacity) {
+    size_t count = deque->back - deque->front;
+    if (count * 2 >= deque->capacity) {
+      size_t new_capacity = deque->capacity ? deque->capacity * 2 : INITIAL_DEQUE_CAPACITY;
+      struct job *grown = malloc(new_capacity * sizeof(struct job));
+      if (grown == NULL) {
+        puts("malloc failure, wtf");
+        exit(1);
+      }
+      memcpy(grown, deque->jobs + deque->front, count * sizeof(struct job));
+      free(deque->jobs);
+      deque->jobs = grown;
+      deque->capacity = new_capacity;
+    } else {
+      memmove(deque->jobs, deque->jobs + deque->front, count * sizeof(struct job));
+    }
+    deque->front = 0;
+    deque->back = count;
+  }
+
+  deque->jobs[deque->back++] = *job;
+
+  pthread_mutex_unlock(&deque->lock);
+
+}
+
+/*
+ *  Take a job off a deque, from the back (owner) or the front (thief).
+ *
+ *  @param struct deque *deque The deque.
+ *  @param struct job *job Where to store the job.
+ *  @param int from_front 1 to steal from the front, 0 to pop the back.
+ *  @return int 1 if we got a job, 0 if the deque was empty.
+ */
+static int take(struct deque *deque, struct job *job, int from_front) {
+
+  int got_job = 0;
+
+  pthread_mutex_lock(&deque->lock);
+  if (deque->back > deque->front) {
+    if (from_front) {
+      *job = deque->jobs[deque->front++];
+    } else {
+      *job = deque->jobs[--deque->back];
+    }
+    got_job = 1;
+  }
+  pthread_mutex_unlock(&deque->lock);
+
+  return got_job;
+
+}
+
+/*
+ *  Submit a job. Workers push onto their own deque;
+ *  anyone else (including workers of another pool)
+ *  pushes onto the first worker's deque.
+ *
+ *  @param struct job_pool *pool The pool.
+ *  @param int type JOB_DIRECTORY or JOB_FILE.
+ *  @param char *path The path to the directory or file.
+ *  @param struct stat *info Info about the file (or NULL if we didn't stat it).
+ *  @return void
+ */
+void submit_job(struct job_pool *pool, int type, const char *path, struct stat *info) {
+
+  struct job job;
+  job.type = type;
+  job.path = strdup(path);
+  if (job.path == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  job.has_info = info != NULL;
+  if (info != NULL) {
+    job.info = *info;
+  }
+
+  // Count it before it becomes visible, so nobody thinks we're done.
+  atomic_fetch_add(&pool->outstanding_jobs, 1);
+
+  int owner = (current_pool == pool && current_worker >= 0) ? current_worker : 0;
+  push_back(&pool->deques[owner], &job);
+
+}
+
+/*
+ *  Find the next job: our own newest one first,
+ *  otherwise the oldest one from another worker.
+ *
+ *  @param struct job_pool *pool The pool.
+ *  @param int worker Our worker number.
+ *  @param struct job *job Where to store the job.
+ *  @return int 1 if we found one, 0 if not.
+ */
+static int find_job(struct job_pool *pool, int worker, struct job *job) {
+
+  if (take(&pool->deques[worker], job, 0)) {
+    return 1;
+  }
+
+  int i;
+  for (i = 1; i < pool->number_of_workers; i++) {
+    int victim = (worker + i) % pool->number_of_workers;
+    if (take(&pool->deques[victim], job, 1)) {
+      return 1;
+    }
+  }
+
+  return 0;
+
+}
+
+/*
+ *  The main loop of a worker thread.
+ *
+ *  @param void *argument The worker (a `struct worker`).
+ *  @return void * Nothing.
+ */
+static void *worker_loop(void *argument) {
+
+  struct job_pool *pool = ((struct worker *) argument)->pool;
+  struct scan *scan = pool->scan;
+  current_worker = ((struct worker *) argument)->number;
+  current_pool = pool;
+
+  struct job job;
+  int idle_spins = 0;
+
+  // Keep going until every submitted job has been finished.
+  while (atomic_load(&pool->outstanding_jobs) > 0) {
+
+    if (find_job(pool, current_worker, &job)) {
+
+      idle_spins = 0;
+
+      // Do the work (which may submit more jobs). Once the
+      // scan has failed, the rest of the jobs are just dropped.
+      if (job.type == JOB_DIRECTORY) {
+        walk_directory(scan, job.path);
+      } else {
+        process_file(scan, job.path, job.has_info ? &job.info : NULL);
+      }
+      free(job.path);
+
+      // Only now is this job finished.
+      atomic_fetch_sub(&pool->outstanding_jobs, 1);
+
+    }
+
+    // Nothing to do right now, but others are still busy and
+    // may produce more. Spin briefly, then back off.
+    else if (++idle_spins < SPINS_BEFORE_SLEEPING) {
+      sched_yield();
+    } else {
+      struct timespec pause = { 0, IDLE_SLEEP_NANOSECONDS };
+      nanosleep(&pause, NULL);
+    }
+
+  }
+
+  current_worker = -1;
+  current_pool = NULL;
+  return NULL;
+
+}
+
+/*
+ *  Walk a directory tree on the scan's `number_of_jobs` threads,
+ *  and wait until it's done.
+ *
+ *  @param struct scan *scan The scan.
+ *  @param char *path The folder to walk.
+ *  @return void
+ */
+void run_jobs(struct scan *scan, const char *path) {
+
+  struct job_pool *pool = malloc(sizeof(struct job_pool));
+  if (pool == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  pool->scan = scan;
+  pool->number_of_workers = scan->number_of_jobs;
+  atomic_init(&pool->outstanding_jobs, 0);
+
+  int i;
+  for (i = 0; i < pool->number_of_workers; i++) {
+    pthread_mutex_init(&pool->deques[i].lock, NULL);
+    pool->deques[i].jobs = NULL;
+    pool->deques[i].front = 0;
+    pool->deques[i].back = 0;
+    pool->deques[i].capacity = 0;
+  }
+
+  // Seed the first worker's deque with the top directory.
+  submit_job(pool, JOB_DIRECTORY, path, NULL);
+
+  // Start the workers. From here on, the walk hands
+  // what it finds to them.
+  scan->jobs = pool;
+  pthread_t threads[MAX_JOBS];
+  struct worker workers[MAX_JOBS];
+  for (i = 0; i < pool->number_of_workers; i++) {
+    workers[i].pool = pool;
+    workers[i].number = i;
+    if (pthread_create(&threads[i], NULL, worker_loop, &workers[i]) != 0) {
+      puts("Could not start a worker thread.");
+      exit(1);
+    }
+  }
+
+  // Wait for them to run out of work.
+  for (i = 0; i < pool->number_of_workers; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  scan->jobs = NULL;
+
+  for (i = 0; i < pool->number_of_workers; i++) {
+    free(pool->deques[i].jobs);
+    pthread_mutex_destroy(&pool->deques[i].lock);
+  }
+  free(pool);
+
+}
@@ -0,0 +1,48 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for jobs.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef JOBS_H
+#define JOBS_H
+
+// For `struct stat`.
+#include <sys/stat.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define MAX_JOBS 256
+#define JOB_DIRECTORY 0
+#define JOB_FILE 1
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in jobs.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+struct scan;
+struct job_pool;
+
+void submit_job(struct job_pool *pool, int type, const char *path, struct stat *info);
+void run_jobs(struct scan *scan, const char *path);
+
+#endif
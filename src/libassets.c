@@ -0,0 +1,113 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the library interface: it scans a tree and
+ *    hands each file's record to a callback, instead of
+ *    writing a manifest.
+ *
+ *    Everything a scan needs lives in its own `struct scan`,
+ *    so scans can run on several threads at once. (The hash
+ *    cache, `--stats` and the manifest writers belong to the
+ *    command line program, and aren't used here.)
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `malloc()`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `memset()`.
+#include <string.h>
+
+// We walk the tree with these.
+#include "processing.h"
+
+// We need the header that declares the prototypes for this file.
+#include "libassets.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in libassets.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Fill in the default options: md5, no base64, no
+ *  cachebusting, nothing ignored, one thread.
+ *
+ *  @param struct assets_options *options The options.
+ *  @return void
+ */
+void init_assets_options(struct assets_options *options) {
+  memset(options, 0, sizeof(struct assets_options));
+  options->base64_max_size = -1;
+  options->jobs = 1;
+  options->hash_threads = 1;
+}
+
+/*
+ *  Scan a tree, and hand each file's record to `options->on_record`.
+ *
+ *  @param struct assets_options *options What to scan, and how.
+ *  @param char *error Where to put a message if it fails (or NULL).
+ *  @param size_t error_length How much room there is for it
+ *                             (ASSETS_ERROR_LENGTH is always enough).
+ *  @return int 0 if it worked, -1 if not.
+ */
+int assets_scan(const struct assets_options *options, char *error, size_t error_length) {
+
+  char ignored_error[ASSETS_ERROR_LENGTH];
+  if (error == NULL) {
+    error = ignored_error;
+    error_length = sizeof(ignored_error);
+  }
+
+  if (options->folder == NULL) {
+    snprintf(error, error_length, "No folder to scan.");
+    return -1;
+  }
+
+  struct scan *scan = malloc(sizeof(struct scan));
+  if (scan == NULL) {
+    snprintf(error, error_length, "Out of memory.");
+    return -1;
+  }
+  if (!init_scan(scan, options, error, error_length)) {
+    free(scan);
+    return -1;
+  }
+
+  walk(scan, options->folder);
+
+  int status = 0;
+  if (scan_failed(scan)) {
+    snprintf(error, error_length, "%s", scan->error);
+    status = -1;
+  }
+
+  free_scan(scan);
+  free(scan);
+  return status;
+
+}
@@ -0,0 +1,118 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for libassets.c, the library
+ *    interface (`make lib` builds libassets.a and libassets.so).
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef LIBASSETS_H
+#define LIBASSETS_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For `struct asset_record`.
+#include "record.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// Room for the message `assets_scan()` gives back when it fails.
+#define ASSETS_ERROR_LENGTH 1280
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// What to scan, and how. Start from `init_assets_options()`,
+// which gives the same defaults as the command line.
+struct assets_options {
+
+  // The folder to walk.
+  const char *folder;
+
+  // Patterns to skip, like `--ignore` ("a,*.map,build/**/tmp"), or NULL.
+  const char *ignore;
+
+  // A .gitignore style file of patterns to skip, like `--ignore-file`,
+  // or NULL. `ignore` comes after it, so it can override it.
+  const char *ignore_file;
+
+  // Rename files with cachebusting names (like `--cachebust`).
+  int cachebust;
+
+  // Base64 encode images up to this many bytes (like `--base64`), or -1 not to.
+  int base64_max_size;
+
+  // Work out each file's MIME type from its first bytes when they
+  // match a known signature, rather than only from its extension
+  // (like `--sniff`).
+  int sniff;
+
+  // Add the width and height of each image, read from its
+  // header (like `--dimensions`).
+  int dimensions;
+
+  // Write compressed siblings of each file that's worth it
+  // (like `--precompress`): "gzip", "zstd" or "gzip,zstd", or NULL not to.
+  const char *precompress;
+
+  // Add a Subresource Integrity value with these digests
+  // (like `--sri`): any of "sha256,sha384,sha512", or NULL not to.
+  const char *sri;
+
+  // The hash algorithm (like `--hash`), or NULL for md5.
+  const char *hash;
+
+  // How many threads to walk on (like `--jobs`).
+  int jobs;
+
+  // How many threads to process files on, behind a single walker
+  // (like `--pipeline`), or 0 not to. Records still come in the
+  // order of a plain walk. It can't be used with `jobs`.
+  int pipeline_workers;
+
+  // How many threads may hash one big file (blake3 only).
+  int hash_threads;
+
+  // Called with each file's record. The record (and its strings)
+  // is only good until the callback returns. With `jobs` above 1,
+  // it's called from several threads at once.
+  void (*on_record)(const struct asset_record *record, void *context);
+
+  // Handed to `on_record`, untouched.
+  void *context;
+
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in libassets.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void init_assets_options(struct assets_options *options);
+int assets_scan(const struct assets_options *options, char *error, size_t error_length);
+
+#endif
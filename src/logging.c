@@ -30,6 +30,24 @@
 // For working with strings, e.g., `strcat()`.
 #include <string.h>
 
+// For the mutex that keeps entries from different threads apart.
+#include <pthread.h>
+
+// For `getpid()`.
+#include <unistd.h>
+
+// We write through a buffered output sink.
+#include "sink.h"
+
+// We time the output (`--stats`) with these.
+#include "stats.h"
+
+// For writing the binary manifest (`--format bin`).
+#include "manifest.h"
+
+// For compressing the output (`--compress`).
+#include "compress.h"
+
 // We need the header that declares the prototypes for this file.
 #include "logging.h"
 
@@ -49,12 +67,33 @@ int logging_type = 0;
 // The path to a file to write logging to.
 char *log_file_path;
 
+// The format of the manifest (LOG_FORMAT_JSON or LOG_FORMAT_BIN).
+int log_format = LOG_FORMAT_JSON;
+
+// How to compress the output (COMPRESS_AUTO goes by the file's extension).
+int log_compression = COMPRESS_AUTO;
+
 // A delimiter to separate logged records.
 char delimiter[2];
 
+// Where the log goes (a file, or STDOUT). It's opened in
+// `start_logging()` and flushed and closed in `stop_logging()`.
+struct output_sink output;
+
 // A flag to say if we're using delimiters or not.
 int use_delimiter = 0;
 
+// A flag to say if a log file should be written to a temporary
+// file and renamed into place, so readers never see half of it.
+int atomic_logging = 0;
+
+// The temporary file (when `atomic_logging` is on).
+char temporary_log_path[MAX_PATH_LENGTH + 32];
+
+// With `--jobs`, several threads log at once. This makes
+// sure each message (and its delimiter) goes out in one piece.
+pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+
 
 /*  ------------------------------------------------------------
  *
@@ -74,6 +113,15 @@ void set_logging_type(int new_value) {
   logging_type = new_value;
 }
 
+/*
+ *  Get the logging type.
+ *
+ *  @return int 0 for STDOUT, 1 for a file.
+ */
+int get_logging_type(void) {
+  return logging_type;
+}
+
 /*
  *  Set the path to the log file.
  *
@@ -85,21 +133,92 @@ void set_log_file(char *path) {
 }
 
 /*
- *  Start the logging.
+ *  Is this path the log file (or the temporary file it's written to)?
+ *
+ *  @param char *path The path.
+ *  @return int 1 if yes, 0 if no.
+ */
+int is_log_file(const char *path) {
+  if (logging_type != 1) {
+    return 0;
+  }
+  size_t length = strlen(log_file_path);
+  return strncmp(path, log_file_path, length) == 0
+    && (path[length] == '\0' || strncmp(path + length, ".tmp.", 5) == 0);
+}
+
+/*
+ *  Set whether a log file is replaced in one go (with a rename)
+ *  rather than truncated and rewritten in place.
+ *
+ *  @param int flag 1 to replace it in one go, 0 not to.
+ *  @return void
+ */
+void set_atomic_logging(int flag) {
+  atomic_logging = flag;
+}
+
+/*
+ *  Set the format of the manifest.
+ *
+ *  @param int format LOG_FORMAT_JSON or LOG_FORMAT_BIN.
+ *  @return void
+ */
+void set_log_format(int format) {
+  log_format = format;
+}
+
+/*
+ *  Set how to compress the output.
+ *
+ *  @param int method COMPRESS_AUTO, COMPRESS_NONE, COMPRESS_GZIP or COMPRESS_ZSTD.
+ *  @return void
+ */
+void set_log_compression(int method) {
+  log_compression = method;
+}
+
+/*
+ *  Work out how the output will be compressed: as it was set,
+ *  or else by the log file's extension (.gz or .zst).
+ *
+ *  @return int COMPRESS_NONE, COMPRESS_GZIP or COMPRESS_ZSTD.
+ */
+int get_log_compression(void) {
+  if (log_compression != COMPRESS_AUTO) {
+    return log_compression;
+  }
+  return logging_type == 1 ? compression_for_path(log_file_path) : COMPRESS_NONE;
+}
+
+/*
+ *  Start the logging: open the output once, and write the opening bracket.
  *
  *  @return void
  */
 void start_logging(void) {
 
-  // If we're writing to a file,
-  // delete the file first (it will be recreated).
-  if (logging_type == 1) {
-    remove(log_file_path);
+  // If we're writing to a file, open (and truncate) it.
+  // Otherwise, we write to STDOUT.
+  if (logging_type == 1 && atomic_logging) {
+    snprintf(temporary_log_path, sizeof(temporary_log_path), "%s.tmp.%ld", log_file_path, (long) getpid());
+    open_sink(&output, temporary_log_path);
+  } else if (logging_type == 1) {
+    open_sink(&output, log_file_path);
+  } else {
+    open_stdout_sink(&output);
   }
+  compress_sink(&output, get_log_compression());
 
-    // Start with no delimiter.
-    delimiter[0] = '\0';
-    delimiter[1] = '\0';
+  // Start with no delimiter.
+  delimiter[0] = '\0';
+  delimiter[1] = '\0';
+
+  // A binary manifest is written in one go at the end.
+  if (log_format == LOG_FORMAT_BIN) {
+    start_binary_manifest();
+    return;
+  }
 
   // Open with an opening brace.
   put_to_log("[");
@@ -110,13 +229,24 @@ void start_logging(void) {
 }
 
 /*
- *  Stop the logging.
+ *  Stop the logging: write the closing bracket, then flush and close the output.
  *
  *  @return void
  */
 void stop_logging(void) {
   use_delimiter = 0;
-  put_to_log("]");
+  if (log_format == LOG_FORMAT_BIN) {
+    uint64_t started = start_timer();
+    write_binary_manifest(&output);
+    stop_timer(PHASE_OUTPUT, started);
+  } else {
+    put_to_log("]");
+  }
+  close_sink(&output);
+  if (logging_type == 1 && atomic_logging && rename(temporary_log_path, log_file_path) != 0) {
+    fprintf(stderr, "Could not write this file: %s\n", log_file_path);
+    exit(1);
+  }
 }
 
 /*
@@ -127,82 +257,45 @@ void stop_logging(void) {
  */
 void put_to_log(const char *message) {
 
-  // If the logging type is "0", we just print to STDOUT.
-  if (logging_type == 0) {
-    print_to_stdout(message);
-  }
-
-  // If it's "1", we write to a file.
-  else if (logging_type == 1) {
-    print_to_file(message, log_file_path);
-  }
+  // The time spent waiting for the lock counts too.
+  uint64_t started = start_timer();
+  pthread_mutex_lock(&log_lock);
 
-}
-
-/*
- *  Print a message to stdout.
- *
- *  @param char *message The message to print.
- *  @return void
- */
-void print_to_stdout(const char *message) {
+  // Write the delimiter first (there's none before the first entry).
   if (use_delimiter) {
-    printf("%s%s", delimiter, message);
+    write_to_sink(&output, delimiter, strlen(delimiter));
 
     // delimiter needs to be two characters long because it's treated as a cstring (has a '\0' terminator)
-    // Using ',' as a delimiter would read an arbitrary amount of memory after delimiter[0]
-    // until \0 were encountered by chance.
     if (delimiter[0] == '\0') {
       delimiter[0] = ',';
     }
-  } else {
+  }
 
-    // TODO - printf returns failure codes - check this?
+  write_to_sink(&output, message, strlen(message));
+
+  pthread_mutex_unlock(&log_lock);
+  stop_timer(PHASE_OUTPUT, started);
 
-    printf("%s", message);
-  }
 }
 
 /*
- *  Write a message to a file.
+ *  Log a file's record: its JSON entry, or a record
+ *  in the binary manifest.
  *
- *  @param char *message The message to write.
+ *  @param struct asset_record *record The record.
  *  @return void
  */
-void print_to_file(const char *message, const char *path) {
-
-  // We'll store the stream to the file here:
-  FILE *file;
-
-  // Open the file.
-  file = fopen(path, "a");
-
-  // Did it work?
-  if (file != NULL) {
-
-    // TODO - fprintf returns failure codes - report this?
-
-    // Write the message.
-    if (use_delimiter) {
-      fprintf(file, "%s%s", delimiter, message);
-      if (delimiter[0] == '\0') {
-        delimiter[0] = ',';
-      }
-    } else {
-      fprintf(file, "%s", message);
-    }
-
-    // Close the stream.
-    fclose(file);
-
-    // TODO - fclose returns EOF on failure - report this?
+void log_record(const struct asset_record *record) {
 
+  if (log_format != LOG_FORMAT_BIN) {
+    put_to_log(record->entry);
+    return;
   }
 
-  // Otherwise, print a message.
-  else {
-    puts("Could not write to this file:");
-    printf("%s\n", path);
-  }
+  uint64_t started = start_timer();
+  pthread_mutex_lock(&log_lock);
+  add_to_binary_manifest(record);
+  pthread_mutex_unlock(&log_lock);
+  stop_timer(PHASE_OUTPUT, started);
 
 }
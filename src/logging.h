@@ -16,6 +16,9 @@
 #ifndef LOGGING_H
 #define LOGGING_H
 
+// For `struct asset_record`.
+#include "record.h"
+
 
 /*  ------------------------------------------------------------
  *
@@ -24,6 +27,8 @@
  *  ------------------------------------------------------------
  */
 #define MAX_PATH_LENGTH 1024
+#define LOG_FORMAT_JSON 0
+#define LOG_FORMAT_BIN 1
 
 /*  ------------------------------------------------------------
  *
@@ -34,11 +39,16 @@
  */
 
 void set_logging_type(int new_value);
+int get_logging_type(void);
 void set_log_file(char *path);
+void set_atomic_logging(int flag);
+void set_log_format(int format);
+void set_log_compression(int method);
+int get_log_compression(void);
+int is_log_file(const char *path);
 void start_logging(void);
 void stop_logging(void);
 void put_to_log(const char *message);
-void print_to_stdout(const char *message);
-void print_to_file(const char *message, const char *path);
+void log_record(const struct asset_record *record);
 
 #endif
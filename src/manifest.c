@@ -0,0 +1,327 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file writes the binary manifest (`--format bin`).
+ *
+ *    Records are collected in memory as files are processed,
+ *    and their strings are interned, so a directory or extension
+ *    shared by many files is stored once. At the end, the records
+ *    are written out with two sorted indexes (by key and by digest)
+ *    that the reader (manifest_reader.c) binary searches in place.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `strcmp()`.
+#include <string.h>
+
+// For the name of the digest algorithm.
+#include "digest.h"
+
+// For `hash_bytes()`.
+#include "utilities.h"
+
+// We need the header that declares the prototypes for this file.
+#include "manifest.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define INITIAL_MANIFEST_RECORDS 1024
+#define INITIAL_MANIFEST_STRINGS 65536
+#define INITIAL_STRING_SLOTS 4096
+
+
+/*  ------------------------------------------------------------
+ *
+ *  NON-CONSTANT VARIABLES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The records so far.
+struct manifest_record *manifest_records = NULL;
+size_t manifest_record_count = 0;
+size_t manifest_record_capacity = 0;
+
+// The string area so far.
+char *manifest_strings = NULL;
+size_t manifest_strings_length = 0;
+size_t manifest_strings_capacity = 0;
+
+// A hash table of the strings we've stored, so each is only
+// stored once. Empty slots have the offset MANIFEST_NO_STRING.
+struct manifest_string *string_slots = NULL;
+size_t string_slot_capacity = 0;
+size_t string_count = 0;
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in manifest.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Grow an array (if need be) so it has room for `needed` items.
+ *
+ *  @param void **array The array.
+ *  @param size_t *capacity How many items it has room for.
+ *  @param size_t needed How many items it needs room for.
+ *  @param size_t initial How many to make room for the first time.
+ *  @param size_t size The size of an item.
+ *  @return void
+ */
+static void reserve(void **array, size_t *capacity, size_t needed, size_t initial, size_t size) {
+  if (needed <= *capacity) {
+    return;
+  }
+  size_t new_capacity = *capacity ? *capacity : initial;
+  while (new_capacity < needed) {
+    new_capacity *= 2;
+  }
+  void *grown = realloc(*array, new_capacity * size);
+  if (grown == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  *array = grown;
+  *capacity = new_capacity;
+}
+
+/*
+ *  Find the slot for a string: the one holding it, or the empty
+ *  one it would go in.
+ *
+ *  @param char *value The string.
+ *  @param size_t length Its length.
+ *  @return struct manifest_string* The slot.
+ */
+static struct manifest_string *find_string_slot(const char *value, size_t length) {
+  size_t mask = string_slot_capacity - 1;
+  size_t index = hash_bytes(value, length) & mask;
+  while (string_slots[index].offset != MANIFEST_NO_STRING) {
+    struct manifest_string *slot = &string_slots[index];
+    if (slot->length == length && memcmp(manifest_strings + slot->offset, value, length) == 0) {
+      return slot;
+    }
+    index = (index + 1) & mask;
+  }
+  return &string_slots[index];
+}
+
+/*
+ *  Double the hash table of strings, and put everything back in it.
+ *
+ *  @return void
+ */
+static void grow_string_slots(void) {
+  struct manifest_string *old_slots = string_slots;
+  size_t old_capacity = string_slot_capacity;
+  string_slot_capacity = old_capacity ? old_capacity * 2 : INITIAL_STRING_SLOTS;
+  string_slots = malloc(string_slot_capacity * sizeof(struct manifest_string));
+  if (string_slots == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  size_t i;
+  for (i = 0; i < string_slot_capacity; i++) {
+    string_slots[i].offset = MANIFEST_NO_STRING;
+  }
+  for (i = 0; i < old_capacity; i++) {
+    if (old_slots[i].offset != MANIFEST_NO_STRING) {
+      *find_string_slot(manifest_strings + old_slots[i].offset, old_slots[i].length) = old_slots[i];
+    }
+  }
+  free(old_slots);
+}
+
+/*
+ *  Store a string (once), and say where it is.
+ *
+ *  @param char *value The string (NULL if there isn't one).
+ *  @param size_t length Its length.
+ *  @return struct manifest_string Where it is.
+ */
+static struct manifest_string intern_string(const char *value, size_t length) {
+
+  struct manifest_string stored;
+  if (value == NULL) {
+    stored.offset = MANIFEST_NO_STRING;
+    stored.length = 0;
+    return stored;
+  }
+
+  if ((string_count + 1) * 2 > string_slot_capacity) {
+    grow_string_slots();
+  }
+  struct manifest_string *slot = find_string_slot(value, length);
+  if (slot->offset != MANIFEST_NO_STRING) {
+    return *slot;
+  }
+
+  // Offsets are 32 bits, which is plenty for a manifest.
+  if (manifest_strings_length + length + 1 >= MANIFEST_NO_STRING) {
+    puts("The manifest is too big for --format bin.");
+    exit(1);
+  }
+  reserve((void **) &manifest_strings, &manifest_strings_capacity,
+          manifest_strings_length + length + 1, INITIAL_MANIFEST_STRINGS, 1);
+  memcpy(manifest_strings + manifest_strings_length, value, length);
+  manifest_strings[manifest_strings_length + length] = '\0';
+
+  slot->offset = (uint32_t) manifest_strings_length;
+  slot->length = (uint32_t) length;
+  manifest_strings_length += length + 1;
+  string_count++;
+  return *slot;
+
+}
+
+/*
+ *  Start a new binary manifest.
+ *
+ *  @return void
+ */
+void start_binary_manifest(void) {
+  manifest_record_count = 0;
+  manifest_strings_length = 0;
+  string_count = 0;
+  size_t i;
+  for (i = 0; i < string_slot_capacity; i++) {
+    string_slots[i].offset = MANIFEST_NO_STRING;
+  }
+}
+
+/*
+ *  Add a file to the binary manifest. With `--jobs`, the caller
+ *  must make sure only one thread does this at a time.
+ *
+ *  @param struct asset_record *record The file's record.
+ *  @return void
+ */
+void add_to_binary_manifest(const struct asset_record *record) {
+  reserve((void **) &manifest_records, &manifest_record_capacity, manifest_record_count + 1,
+          INITIAL_MANIFEST_RECORDS, sizeof(struct manifest_record));
+  struct manifest_record *stored = &manifest_records[manifest_record_count++];
+  stored->key = intern_string(record->key, strlen(record->key));
+  stored->directory = intern_string(record->directory, strlen(record->directory));
+  stored->filename = intern_string(record->filename, strlen(record->filename));
+  stored->extension = intern_string(record->extension, strlen(record->extension));
+  stored->mime = intern_string(record->mime, strlen(record->mime));
+  stored->digest = intern_string(record->digest, strlen(record->digest));
+  stored->base64 = intern_string(record->base64, record->base64_length);
+  stored->width = record->width;
+  stored->height = record->height;
+  stored->size = record->size;
+}
+
+/*
+ *  Compare two records by (key, directory, filename), for `qsort()`.
+ *
+ *  @param void *a The index of the first record.
+ *  @param void *b The index of the second record.
+ *  @return int <0, 0 or >0.
+ */
+static int compare_keys(const void *a, const void *b) {
+  const struct manifest_record *first = &manifest_records[*(const uint32_t *) a];
+  const struct manifest_record *second = &manifest_records[*(const uint32_t *) b];
+  int order = strcmp(manifest_strings + first->key.offset, manifest_strings + second->key.offset);
+  if (order == 0) {
+    order = strcmp(manifest_strings + first->directory.offset, manifest_strings + second->directory.offset);
+  }
+  if (order == 0) {
+    order = strcmp(manifest_strings + first->filename.offset, manifest_strings + second->filename.offset);
+  }
+  return order;
+}
+
+/*
+ *  Compare two records by digest, for `qsort()`.
+ *
+ *  @param void *a The index of the first record.
+ *  @param void *b The index of the second record.
+ *  @return int <0, 0 or >0.
+ */
+static int compare_digests(const void *a, const void *b) {
+  uint32_t first = *(const uint32_t *) a;
+  uint32_t second = *(const uint32_t *) b;
+  int order = strcmp(manifest_strings + manifest_records[first].digest.offset,
+                     manifest_strings + manifest_records[second].digest.offset);
+  if (order == 0) {
+    order = first < second ? -1 : first > second;
+  }
+  return order;
+}
+
+/*
+ *  Write the binary manifest out.
+ *
+ *  @param struct output_sink *sink Where to write it.
+ *  @return void
+ */
+void write_binary_manifest(struct output_sink *sink) {
+
+  struct manifest_header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MANIFEST_MAGIC, sizeof(header.magic));
+  header.version = MANIFEST_VERSION;
+  header.record_size = sizeof(struct manifest_record);
+  header.record_count = manifest_record_count;
+  header.strings_length = manifest_strings_length;
+  strncpy(header.algorithm, digest_name(get_digest_algorithm()), MANIFEST_ALGORITHM_LENGTH - 1);
+
+  // The header and the records, then each index, then the strings.
+  uint32_t *index = malloc((manifest_record_count + 1) * sizeof(uint32_t));
+  if (index == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  size_t i;
+  write_to_sink(sink, (const char *) &header, sizeof(header));
+  write_to_sink(sink, (const char *) manifest_records, manifest_record_count * sizeof(struct manifest_record));
+
+  for (i = 0; i < manifest_record_count; i++) {
+    index[i] = (uint32_t) i;
+  }
+  qsort(index, manifest_record_count, sizeof(uint32_t), compare_keys);
+  write_to_sink(sink, (const char *) index, manifest_record_count * sizeof(uint32_t));
+
+  for (i = 0; i < manifest_record_count; i++) {
+    index[i] = (uint32_t) i;
+  }
+  qsort(index, manifest_record_count, sizeof(uint32_t), compare_digests);
+  write_to_sink(sink, (const char *) index, manifest_record_count * sizeof(uint32_t));
+
+  write_to_sink(sink, manifest_strings, manifest_strings_length);
+
+  free(index);
+
+}
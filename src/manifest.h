@@ -0,0 +1,111 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for manifest.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For fixed width integers, e.g., `uint64_t`.
+#include <stdint.h>
+
+// For `struct asset_record`.
+#include "record.h"
+
+// For `struct output_sink`.
+#include "sink.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define MANIFEST_MAGIC "ASSETSM1"
+#define MANIFEST_VERSION 3
+#define MANIFEST_ALGORITHM_LENGTH 16
+
+// The offset of a string that isn't there (e.g., no base64).
+#define MANIFEST_NO_STRING 0xFFFFFFFFu
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ *
+ *  A binary manifest (`--format bin`) is laid out like this,
+ *  in the byte order of the machine that wrote it:
+ *
+ *    struct manifest_header
+ *    struct manifest_record    x record_count
+ *    uint32_t key index        x record_count
+ *    uint32_t digest index     x record_count
+ *    strings                   (strings_length bytes)
+ *
+ *  The key index lists the records sorted by (key, directory,
+ *  filename), and the digest index lists them sorted by digest,
+ *  so either can be binary searched. Strings are stored once
+ *  each, NUL-terminated, and records point at them.
+ */
+
+// The header at the start of a binary manifest.
+struct manifest_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint64_t record_count;
+  uint64_t strings_length;
+  char algorithm[MANIFEST_ALGORITHM_LENGTH];
+};
+
+// A string in the string area.
+struct manifest_string {
+  uint32_t offset;
+  uint32_t length;
+};
+
+// One file. `width` and `height` are 0 unless
+// `--dimensions` found them.
+struct manifest_record {
+  struct manifest_string key;
+  struct manifest_string directory;
+  struct manifest_string filename;
+  struct manifest_string extension;
+  struct manifest_string mime;
+  struct manifest_string digest;
+  struct manifest_string base64;
+  uint32_t width;
+  uint32_t height;
+  int64_t size;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in manifest.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void start_binary_manifest(void);
+void add_to_binary_manifest(const struct asset_record *record);
+void write_binary_manifest(struct output_sink *sink);
+
+#endif
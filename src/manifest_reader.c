@@ -0,0 +1,304 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file reads a binary manifest (`--format bin`).
+ *
+ *    The file is memory mapped and used in place: opening it
+ *    only checks the header and the sizes, and looking a key or
+ *    a digest up is a binary search of one of its indexes, so
+ *    it costs O(log n) no matter how big the manifest is. Each
+ *    string is checked against the bounds of the file when it's
+ *    looked at, so a damaged file can't make us read past the end.
+ *
+ *    It doesn't depend on the rest of the program, so it can
+ *    be built into other tools on its own.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// For things like `malloc()`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `strcmp()`.
+#include <string.h>
+
+// For `open()`.
+#include <fcntl.h>
+
+// For `close()`.
+#include <unistd.h>
+
+// For `fstat()`.
+#include <sys/stat.h>
+
+// For `mmap()`.
+#include <sys/mman.h>
+
+// For the layout of the file.
+#include "manifest.h"
+
+// We need the header that declares the prototypes for this file.
+#include "manifest_reader.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// An open binary manifest.
+struct manifest {
+  void *map;
+  size_t map_length;
+  const struct manifest_header *header;
+  const struct manifest_record *records;
+  const uint32_t *indexes[2];
+  const char *strings;
+  char algorithm[MANIFEST_ALGORITHM_LENGTH];
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in manifest_reader.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Open (and map) a binary manifest.
+ *
+ *  @param char *path The path to the file.
+ *  @return struct manifest* The manifest, or NULL if it can't be
+ *                           read or isn't a binary manifest.
+ */
+struct manifest *open_manifest(const char *path) {
+
+  int descriptor = open(path, O_RDONLY);
+  if (descriptor < 0) {
+    return NULL;
+  }
+
+  struct stat info;
+  if (fstat(descriptor, &info) != 0 || info.st_size < (off_t) sizeof(struct manifest_header)) {
+    close(descriptor);
+    return NULL;
+  }
+
+  size_t map_length = (size_t) info.st_size;
+  void *map = mmap(NULL, map_length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  close(descriptor);
+  if (map == MAP_FAILED) {
+    return NULL;
+  }
+
+  // Check it's a manifest we understand, and that the sizes add up.
+  const struct manifest_header *header = map;
+  size_t per_record = sizeof(struct manifest_record) + 2 * sizeof(uint32_t);
+  if (memcmp(header->magic, MANIFEST_MAGIC, sizeof(header->magic)) != 0
+      || header->version != MANIFEST_VERSION
+      || header->record_size != sizeof(struct manifest_record)
+      || header->record_count > map_length / per_record
+      || header->strings_length > map_length
+      || sizeof(struct manifest_header) + header->record_count * per_record + header->strings_length != map_length) {
+    munmap(map, map_length);
+    return NULL;
+  }
+
+  struct manifest *manifest = malloc(sizeof(struct manifest));
+  if (manifest == NULL) {
+    munmap(map, map_length);
+    return NULL;
+  }
+  manifest->map = map;
+  manifest->map_length = map_length;
+  manifest->header = header;
+  manifest->records = (const struct manifest_record *) ((const char *) map + sizeof(struct manifest_header));
+  manifest->indexes[MANIFEST_BY_KEY] = (const uint32_t *) (manifest->records + header->record_count);
+  manifest->indexes[MANIFEST_BY_DIGEST] = manifest->indexes[MANIFEST_BY_KEY] + header->record_count;
+  manifest->strings = (const char *) (manifest->indexes[MANIFEST_BY_DIGEST] + header->record_count);
+  memcpy(manifest->algorithm, header->algorithm, MANIFEST_ALGORITHM_LENGTH);
+  manifest->algorithm[MANIFEST_ALGORITHM_LENGTH - 1] = '\0';
+  return manifest;
+
+}
+
+/*
+ *  Close a manifest.
+ *
+ *  @param struct manifest *manifest The manifest (NULL is fine).
+ *  @return void
+ */
+void close_manifest(struct manifest *manifest) {
+  if (manifest == NULL) {
+    return;
+  }
+  munmap(manifest->map, manifest->map_length);
+  free(manifest);
+}
+
+/*
+ *  How many files are in a manifest?
+ *
+ *  @param struct manifest *manifest The manifest.
+ *  @return size_t The number of files.
+ */
+size_t manifest_count(const struct manifest *manifest) {
+  return (size_t) manifest->header->record_count;
+}
+
+/*
+ *  Which digest algorithm made the manifest's digests?
+ *
+ *  @param struct manifest *manifest The manifest.
+ *  @return char* Its name, e.g., "md5".
+ */
+const char *manifest_algorithm(const struct manifest *manifest) {
+  return manifest->algorithm;
+}
+
+/*
+ *  Get a string from the string area, if it's in bounds.
+ *
+ *  @param struct manifest *manifest The manifest.
+ *  @param struct manifest_string *string Where the string is.
+ *  @return char* The string, or NULL if it's out of bounds.
+ */
+static const char *get_string(const struct manifest *manifest, const struct manifest_string *string) {
+  uint64_t end = (uint64_t) string->offset + string->length;
+  if (string->offset == MANIFEST_NO_STRING
+      || end >= manifest->header->strings_length
+      || manifest->strings[end] != '\0') {
+    return NULL;
+  }
+  return manifest->strings + string->offset;
+}
+
+/*
+ *  Get a file from a manifest, in the order it was written.
+ *
+ *  @param struct manifest *manifest The manifest.
+ *  @param size_t position Which file (0 to `manifest_count() - 1`).
+ *  @param struct manifest_entry *entry Where to store it.
+ *  @return int 1 if it's there, 0 if not (or it's damaged).
+ */
+int manifest_entry(const struct manifest *manifest, size_t position, struct manifest_entry *entry) {
+
+  if (position >= manifest->header->record_count) {
+    return 0;
+  }
+
+  const struct manifest_record *record = &manifest->records[position];
+  entry->key = get_string(manifest, &record->key);
+  entry->directory = get_string(manifest, &record->directory);
+  entry->filename = get_string(manifest, &record->filename);
+  entry->extension = get_string(manifest, &record->extension);
+  entry->mime = get_string(manifest, &record->mime);
+  entry->digest = get_string(manifest, &record->digest);
+  entry->base64 = get_string(manifest, &record->base64);
+  entry->base64_length = entry->base64 != NULL ? record->base64.length : 0;
+  entry->width = record->width;
+  entry->height = record->height;
+  entry->size = record->size;
+
+  // Only the base64 is allowed to be missing.
+  if (entry->base64 == NULL && record->base64.offset != MANIFEST_NO_STRING) {
+    return 0;
+  }
+  return entry->key != NULL && entry->directory != NULL && entry->filename != NULL
+    && entry->extension != NULL && entry->mime != NULL && entry->digest != NULL;
+
+}
+
+/*
+ *  Get the value an index is sorted by, for one of its entries.
+ *
+ *  @param struct manifest *manifest The manifest.
+ *  @param int index MANIFEST_BY_KEY or MANIFEST_BY_DIGEST.
+ *  @param size_t position Where in the index.
+ *  @return char* The key or digest ("" if it's damaged).
+ */
+static const char *indexed_value(const struct manifest *manifest, int index, size_t position) {
+  uint32_t record_number = manifest->indexes[index][position];
+  if (record_number >= manifest->header->record_count) {
+    return "";
+  }
+  const struct manifest_record *record = &manifest->records[record_number];
+  const char *value = get_string(manifest, index == MANIFEST_BY_KEY ? &record->key : &record->digest);
+  return value != NULL ? value : "";
+}
+
+/*
+ *  Look a key or a digest up.
+ *
+ *  @param struct manifest *manifest The manifest.
+ *  @param int index MANIFEST_BY_KEY or MANIFEST_BY_DIGEST.
+ *  @param char *value The key or digest to look for.
+ *  @param size_t *first Where to store the position (in the index)
+ *                       of the first match.
+ *  @return size_t How many files match (they follow `first` in the
+ *                 index: see `manifest_indexed_entry()`).
+ */
+size_t manifest_lookup(const struct manifest *manifest, int index, const char *value, size_t *first) {
+
+  if (index != MANIFEST_BY_KEY && index != MANIFEST_BY_DIGEST) {
+    *first = 0;
+    return 0;
+  }
+
+  // Find the first entry that isn't less than the value.
+  size_t low = 0;
+  size_t high = manifest->header->record_count;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (strcmp(indexed_value(manifest, index, middle), value) < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  *first = low;
+
+  // Then count the matches.
+  size_t end = low;
+  while (end < manifest->header->record_count && strcmp(indexed_value(manifest, index, end), value) == 0) {
+    end++;
+  }
+  return end - low;
+
+}
+
+/*
+ *  Get a file from a manifest, in the order of one of its indexes.
+ *
+ *  @param struct manifest *manifest The manifest.
+ *  @param int index MANIFEST_BY_KEY or MANIFEST_BY_DIGEST.
+ *  @param size_t position Where in the index.
+ *  @param struct manifest_entry *entry Where to store it.
+ *  @return int 1 if it's there, 0 if not (or it's damaged).
+ */
+int manifest_indexed_entry(const struct manifest *manifest, int index, size_t position, struct manifest_entry *entry) {
+  if ((index != MANIFEST_BY_KEY && index != MANIFEST_BY_DIGEST)
+      || position >= manifest->header->record_count) {
+    return 0;
+  }
+  return manifest_entry(manifest, manifest->indexes[index][position], entry);
+}
@@ -0,0 +1,81 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for manifest_reader.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef MANIFEST_READER_H
+#define MANIFEST_READER_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For fixed width integers, e.g., `int64_t`.
+#include <stdint.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define MANIFEST_BY_KEY 0
+#define MANIFEST_BY_DIGEST 1
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// An open binary manifest (see manifest.h for the layout).
+struct manifest;
+
+// One file in a manifest. The strings point into the mapped
+// file, so they're good until the manifest is closed. `base64`
+// is NULL if the file wasn't encoded. `width` and `height` are
+// 0 unless `--dimensions` found them.
+struct manifest_entry {
+  const char *key;
+  const char *directory;
+  const char *filename;
+  const char *extension;
+  const char *mime;
+  const char *digest;
+  const char *base64;
+  size_t base64_length;
+  uint32_t width;
+  uint32_t height;
+  int64_t size;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in manifest_reader.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+struct manifest *open_manifest(const char *path);
+void close_manifest(struct manifest *manifest);
+size_t manifest_count(const struct manifest *manifest);
+const char *manifest_algorithm(const struct manifest *manifest);
+int manifest_entry(const struct manifest *manifest, size_t position, struct manifest_entry *entry);
+size_t manifest_lookup(const struct manifest *manifest, int index, const char *value, size_t *first);
+int manifest_indexed_entry(const struct manifest *manifest, int index, size_t position, struct manifest_entry *entry);
+
+#endif
@@ -0,0 +1,281 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides a streaming md5 implementation
+ *    (RFC 1321), so we don't have to shell out to `md5sum`.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// For working with memory, e.g., `memcpy()`.
+#include <string.h>
+
+// We need the header that declares the prototypes for this file.
+#include "md5.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The four auxiliary functions from the RFC.
+#define MD5_ROUND_F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MD5_ROUND_G(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))
+#define MD5_ROUND_H(x, y, z) ((x) ^ (y) ^ (z))
+#define MD5_ROUND_I(x, y, z) ((y) ^ ((x) | ~(z)))
+
+// One step of a round: add, rotate, add.
+#define MD5_STEP(f, a, b, c, d, x, t, s) \
+  (a) += f((b), (c), (d)) + (x) + (t); \
+  (a) = (((a) << (s)) | ((a) >> (32 - (s)))); \
+  (a) += (b);
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in md5.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Read a little-endian 32 bit word.
+ *
+ *  @param unsigned char *bytes The 4 bytes to read.
+ *  @return uint32_t The word.
+ */
+static uint32_t md5_read_word(const unsigned char *bytes) {
+  return (uint32_t) bytes[0]
+    | ((uint32_t) bytes[1] << 8)
+    | ((uint32_t) bytes[2] << 16)
+    | ((uint32_t) bytes[3] << 24);
+}
+
+/*
+ *  Run the md5 compression function over consecutive 64 byte blocks.
+ *
+ *  @param struct md5_context *context The running state.
+ *  @param unsigned char *data The blocks.
+ *  @param size_t blocks The number of blocks.
+ *  @return void
+ */
+static void md5_transform(struct md5_context *context, const unsigned char *data, size_t blocks) {
+
+  uint32_t a = context->state[0];
+  uint32_t b = context->state[1];
+  uint32_t c = context->state[2];
+  uint32_t d = context->state[3];
+
+  while (blocks--) {
+
+    uint32_t x[16];
+    int i;
+    for (i = 0; i < 16; i++) {
+      x[i] = md5_read_word(data + i * 4);
+    }
+
+    uint32_t saved_a = a;
+    uint32_t saved_b = b;
+    uint32_t saved_c = c;
+    uint32_t saved_d = d;
+
+    // Round 1.
+    MD5_STEP(MD5_ROUND_F, a, b, c, d, x[0], 0xd76aa478, 7)
+    MD5_STEP(MD5_ROUND_F, d, a, b, c, x[1], 0xe8c7b756, 12)
+    MD5_STEP(MD5_ROUND_F, c, d, a, b, x[2], 0x242070db, 17)
+    MD5_STEP(MD5_ROUND_F, b, c, d, a, x[3], 0xc1bdceee, 22)
+    MD5_STEP(MD5_ROUND_F, a, b, c, d, x[4], 0xf57c0faf, 7)
+    MD5_STEP(MD5_ROUND_F, d, a, b, c, x[5], 0x4787c62a, 12)
+    MD5_STEP(MD5_ROUND_F, c, d, a, b, x[6], 0xa8304613, 17)
+    MD5_STEP(MD5_ROUND_F, b, c, d, a, x[7], 0xfd469501, 22)
+    MD5_STEP(MD5_ROUND_F, a, b, c, d, x[8], 0x698098d8, 7)
+    MD5_STEP(MD5_ROUND_F, d, a, b, c, x[9], 0x8b44f7af, 12)
+    MD5_STEP(MD5_ROUND_F, c, d, a, b, x[10], 0xffff5bb1, 17)
+    MD5_STEP(MD5_ROUND_F, b, c, d, a, x[11], 0x895cd7be, 22)
+    MD5_STEP(MD5_ROUND_F, a, b, c, d, x[12], 0x6b901122, 7)
+    MD5_STEP(MD5_ROUND_F, d, a, b, c, x[13], 0xfd987193, 12)
+    MD5_STEP(MD5_ROUND_F, c, d, a, b, x[14], 0xa679438e, 17)
+    MD5_STEP(MD5_ROUND_F, b, c, d, a, x[15], 0x49b40821, 22)
+
+    // Round 2.
+    MD5_STEP(MD5_ROUND_G, a, b, c, d, x[1], 0xf61e2562, 5)
+    MD5_STEP(MD5_ROUND_G, d, a, b, c, x[6], 0xc040b340, 9)
+    MD5_STEP(MD5_ROUND_G, c, d, a, b, x[11], 0x265e5a51, 14)
+    MD5_STEP(MD5_ROUND_G, b, c, d, a, x[0], 0xe9b6c7aa, 20)
+    MD5_STEP(MD5_ROUND_G, a, b, c, d, x[5], 0xd62f105d, 5)
+    MD5_STEP(MD5_ROUND_G, d, a, b, c, x[10], 0x02441453, 9)
+    MD5_STEP(MD5_ROUND_G, c, d, a, b, x[15], 0xd8a1e681, 14)
+    MD5_STEP(MD5_ROUND_G, b, c, d, a, x[4], 0xe7d3fbc8, 20)
+    MD5_STEP(MD5_ROUND_G, a, b, c, d, x[9], 0x21e1cde6, 5)
+    MD5_STEP(MD5_ROUND_G, d, a, b, c, x[14], 0xc33707d6, 9)
+    MD5_STEP(MD5_ROUND_G, c, d, a, b, x[3], 0xf4d50d87, 14)
+    MD5_STEP(MD5_ROUND_G, b, c, d, a, x[8], 0x455a14ed, 20)
+    MD5_STEP(MD5_ROUND_G, a, b, c, d, x[13], 0xa9e3e905, 5)
+    MD5_STEP(MD5_ROUND_G, d, a, b, c, x[2], 0xfcefa3f8, 9)
+    MD5_STEP(MD5_ROUND_G, c, d, a, b, x[7], 0x676f02d9, 14)
+    MD5_STEP(MD5_ROUND_G, b, c, d, a, x[12], 0x8d2a4c8a, 20)
+
+    // Round 3.
+    MD5_STEP(MD5_ROUND_H, a, b, c, d, x[5], 0xfffa3942, 4)
+    MD5_STEP(MD5_ROUND_H, d, a, b, c, x[8], 0x8771f681, 11)
+    MD5_STEP(MD5_ROUND_H, c, d, a, b, x[11], 0x6d9d6122, 16)
+    MD5_STEP(MD5_ROUND_H, b, c, d, a, x[14], 0xfde5380c, 23)
+    MD5_STEP(MD5_ROUND_H, a, b, c, d, x[1], 0xa4beea44, 4)
+    MD5_STEP(MD5_ROUND_H, d, a, b, c, x[4], 0x4bdecfa9, 11)
+    MD5_STEP(MD5_ROUND_H, c, d, a, b, x[7], 0xf6bb4b60, 16)
+    MD5_STEP(MD5_ROUND_H, b, c, d, a, x[10], 0xbebfbc70, 23)
+    MD5_STEP(MD5_ROUND_H, a, b, c, d, x[13], 0x289b7ec6, 4)
+    MD5_STEP(MD5_ROUND_H, d, a, b, c, x[0], 0xeaa127fa, 11)
+    MD5_STEP(MD5_ROUND_H, c, d, a, b, x[3], 0xd4ef3085, 16)
+    MD5_STEP(MD5_ROUND_H, b, c, d, a, x[6], 0x04881d05, 23)
+    MD5_STEP(MD5_ROUND_H, a, b, c, d, x[9], 0xd9d4d039, 4)
+    MD5_STEP(MD5_ROUND_H, d, a, b, c, x[12], 0xe6db99e5, 11)
+    MD5_STEP(MD5_ROUND_H, c, d, a, b, x[15], 0x1fa27cf8, 16)
+    MD5_STEP(MD5_ROUND_H, b, c, d, a, x[2], 0xc4ac5665, 23)
+
+    // Round 4.
+    MD5_STEP(MD5_ROUND_I, a, b, c, d, x[0], 0xf4292244, 6)
+    MD5_STEP(MD5_ROUND_I, d, a, b, c, x[7], 0x432aff97, 10)
+    MD5_STEP(MD5_ROUND_I, c, d, a, b, x[14], 0xab9423a7, 15)
+    MD5_STEP(MD5_ROUND_I, b, c, d, a, x[5], 0xfc93a039, 21)
+    MD5_STEP(MD5_ROUND_I, a, b, c, d, x[12], 0x655b59c3, 6)
+    MD5_STEP(MD5_ROUND_I, d, a, b, c, x[3], 0x8f0ccc92, 10)
+    MD5_STEP(MD5_ROUND_I, c, d, a, b, x[10], 0xffeff47d, 15)
+    MD5_STEP(MD5_ROUND_I, b, c, d, a, x[1], 0x85845dd1, 21)
+    MD5_STEP(MD5_ROUND_I, a, b, c, d, x[8], 0x6fa87e4f, 6)
+    MD5_STEP(MD5_ROUND_I, d, a, b, c, x[15], 0xfe2ce6e0, 10)
+    MD5_STEP(MD5_ROUND_I, c, d, a, b, x[6], 0xa3014314, 15)
+    MD5_STEP(MD5_ROUND_I, b, c, d, a, x[13], 0x4e0811a1, 21)
+    MD5_STEP(MD5_ROUND_I, a, b, c, d, x[4], 0xf7537e82, 6)
+    MD5_STEP(MD5_ROUND_I, d, a, b, c, x[11], 0xbd3af235, 10)
+    MD5_STEP(MD5_ROUND_I, c, d, a, b, x[2], 0x2ad7d2bb, 15)
+    MD5_STEP(MD5_ROUND_I, b, c, d, a, x[9], 0xeb86d391, 21)
+
+    a += saved_a;
+    b += saved_b;
+    c += saved_c;
+    d += saved_d;
+
+    data += MD5_BLOCK_LENGTH;
+
+  }
+
+  context->state[0] = a;
+  context->state[1] = b;
+  context->state[2] = c;
+  context->state[3] = d;
+
+}
+
+/*
+ *  Start a new md5 computation.
+ *
+ *  @param struct md5_context *context The state to initialize.
+ *  @return void
+ */
+void md5_init(struct md5_context *context) {
+  context->state[0] = 0x67452301;
+  context->state[1] = 0xefcdab89;
+  context->state[2] = 0x98badcfe;
+  context->state[3] = 0x10325476;
+  context->length = 0;
+  context->buffered = 0;
+}
+
+/*
+ *  Feed more bytes into an md5 computation.
+ *
+ *  @param struct md5_context *context The running state.
+ *  @param void *data The bytes to add.
+ *  @param size_t length The number of bytes.
+ *  @return void
+ */
+void md5_update(struct md5_context *context, const void *data, size_t length) {
+
+  const unsigned char *bytes = data;
+  context->length += length;
+
+  // Top up a partially filled block first.
+  if (context->buffered > 0) {
+    size_t wanted = MD5_BLOCK_LENGTH - context->buffered;
+    if (length < wanted) {
+      memcpy(context->buffer + context->buffered, bytes, length);
+      context->buffered += length;
+      return;
+    }
+    memcpy(context->buffer + context->buffered, bytes, wanted);
+    md5_transform(context, context->buffer, 1);
+    context->buffered = 0;
+    bytes += wanted;
+    length -= wanted;
+  }
+
+  // Hash whole blocks straight out of the caller's memory.
+  size_t blocks = length / MD5_BLOCK_LENGTH;
+  if (blocks > 0) {
+    md5_transform(context, bytes, blocks);
+    bytes += blocks * MD5_BLOCK_LENGTH;
+    length -= blocks * MD5_BLOCK_LENGTH;
+  }
+
+  // Keep the tail for next time.
+  if (length > 0) {
+    memcpy(context->buffer, bytes, length);
+    context->buffered = length;
+  }
+
+}
+
+/*
+ *  Finish an md5 computation and store the raw digest.
+ *
+ *  @param struct md5_context *context The running state.
+ *  @param unsigned char digest[] The variable to store the 16 byte digest in.
+ *  @return void
+ */
+void md5_final(struct md5_context *context, unsigned char digest[MD5_DIGEST_LENGTH]) {
+
+  // Pad with a single 1 bit, then zeros up to 56 bytes mod 64.
+  uint64_t bits = context->length * 8;
+  static const unsigned char padding[MD5_BLOCK_LENGTH] = { 0x80 };
+  size_t pad_length = (context->buffered < 56)
+    ? 56 - context->buffered
+    : 120 - context->buffered;
+  md5_update(context, padding, pad_length);
+
+  // Then the message length in bits, little-endian.
+  unsigned char length_bytes[8];
+  int i;
+  for (i = 0; i < 8; i++) {
+    length_bytes[i] = (unsigned char) (bits >> (8 * i));
+  }
+  md5_update(context, length_bytes, 8);
+
+  // Write out the state, little-endian.
+  for (i = 0; i < 4; i++) {
+    digest[i * 4] = (unsigned char) context->state[i];
+    digest[i * 4 + 1] = (unsigned char) (context->state[i] >> 8);
+    digest[i * 4 + 2] = (unsigned char) (context->state[i] >> 16);
+    digest[i * 4 + 3] = (unsigned char) (context->state[i] >> 24);
+  }
+
+}
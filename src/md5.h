@@ -0,0 +1,64 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for md5.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef MD5_H
+#define MD5_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For fixed width integers, e.g., `uint32_t`.
+#include <stdint.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define MD5_DIGEST_LENGTH 16
+#define MD5_BLOCK_LENGTH 64
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The running state of an md5 computation.
+struct md5_context {
+  uint32_t state[4];
+  uint64_t length;
+  unsigned char buffer[MD5_BLOCK_LENGTH];
+  size_t buffered;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in md5.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void md5_init(struct md5_context *context);
+void md5_update(struct md5_context *context, const void *data, size_t length);
+void md5_final(struct md5_context *context, unsigned char digest[MD5_DIGEST_LENGTH]);
+
+#endif
@@ -0,0 +1,276 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file works out what type of content a file has:
+ *    from its extension, or (`--sniff`) from its first bytes.
+ *
+ *    The extensions we know are in a perfect hash table, worked
+ *    out ahead of time: with MIME_TABLE_SEED, the top byte of
+ *    each extension's FNV-1a hash is a slot nobody else has. So
+ *    looking one up is a hash and one comparison, whatever the
+ *    extension is. (To add an extension, give it a free slot; if
+ *    the one its hash picks is taken, search for a seed that puts
+ *    every extension in a slot of its own, and renumber them.)
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// For fixed width integers, e.g., `uint32_t`.
+#include <stdint.h>
+
+// For working with strings, e.g., `strcmp()`.
+#include <string.h>
+
+// For checking character types, e.g., `tolower()`.
+#include <ctype.h>
+
+// We need the header that declares the prototypes for this file.
+#include "mime.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  NON-CONSTANT VARIABLES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The table, by slot. Empty slots have no extension.
+static const struct mime_type mime_types[MIME_TABLE_SIZE] = {
+  [5] = { "eot", "application/vnd.ms-fontobject", 0 },
+  [27] = { "ico", "image/x-icon", 0 },
+  [35] = { "wav", "audio/wav", 0 },
+  [43] = { "mp3", "audio/mpeg", MIME_COMPRESSED },
+  [46] = { "mp4", "video/mp4", MIME_COMPRESSED },
+  [48] = { "apng", "image/apng", MIME_COMPRESSED },
+  [50] = { "webm", "video/webm", MIME_COMPRESSED },
+  [53] = { "webp", "image/webp", MIME_COMPRESSED },
+  [60] = { "bmp", "image/bmp", 0 },
+  [75] = { "otf", "font/otf", 0 },
+  [78] = { "gz", "application/gzip", MIME_COMPRESSED },
+  [79] = { "json", "application/json", MIME_TEXT },
+  [86] = { "js", "text/javascript", MIME_TEXT },
+  [90] = { "ogg", "audio/ogg", MIME_COMPRESSED },
+  [107] = { "mjs", "text/javascript", MIME_TEXT },
+  [109] = { "md", "text/markdown", MIME_TEXT },
+  [112] = { "png", "image/png", MIME_IMAGE | MIME_COMPRESSED },
+  [124] = { "wasm", "application/wasm", 0 },
+  [132] = { "map", "application/json", MIME_TEXT },
+  [145] = { "avif", "image/avif", MIME_COMPRESSED },
+  [146] = { "css", "text/css", MIME_TEXT },
+  [149] = { "csv", "text/csv", MIME_TEXT },
+  [159] = { "pdf", "application/pdf", 0 },
+  [169] = { "woff", "font/woff", MIME_COMPRESSED },
+  [173] = { "htm", "text/html", MIME_TEXT },
+  [176] = { "jpg", "image/jpeg", MIME_IMAGE | MIME_COMPRESSED },
+  [181] = { "jpeg", "image/jpeg", MIME_IMAGE | MIME_COMPRESSED },
+  [200] = { "svg", "image/svg+xml", MIME_IMAGE },
+  [203] = { "tar", "application/x-tar", 0 },
+  [205] = { "zip", "application/zip", MIME_COMPRESSED },
+  [207] = { "tif", "image/tiff", 0 },
+  [208] = { "gif", "image/gif", MIME_IMAGE | MIME_COMPRESSED },
+  [214] = { "zst", "application/zstd", MIME_COMPRESSED },
+  [216] = { "woff2", "font/woff2", MIME_COMPRESSED },
+  [219] = { "txt", "text/plain", MIME_TEXT },
+  [225] = { "tiff", "image/tiff", 0 },
+  [226] = { "xml", "application/xml", 0 },
+  [237] = { "ttf", "font/ttf", 0 },
+  [243] = { "html", "text/html", MIME_TEXT },
+  [249] = { "webmanifest", "application/manifest+json", MIME_TEXT },
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in mime.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Find the slot for an extension (FNV-1a, seeded, top byte).
+ *
+ *  @param char *extension The extension, in lower case.
+ *  @param size_t length Its length.
+ *  @return unsigned int The slot.
+ */
+static unsigned int mime_slot(const char *extension, size_t length) {
+  uint32_t hash = 2166136261u ^ MIME_TABLE_SEED;
+  size_t i;
+  for (i = 0; i < length; i++) {
+    hash ^= (unsigned char) extension[i];
+    hash *= 16777619u;
+  }
+  return hash >> 24;
+}
+
+/*
+ *  Look a file's type up by its extension. Case doesn't matter.
+ *
+ *  @param char *extension The extension, e.g., "png" (without the dot).
+ *  @return struct mime_type* The type, or NULL if we don't know it.
+ */
+const struct mime_type *find_mime_type(const char *extension) {
+
+  char lower[MAX_MIME_EXTENSION_LENGTH];
+  size_t length = 0;
+  while (extension[length] != '\0') {
+    if (length == MAX_MIME_EXTENSION_LENGTH - 1) {
+      return NULL;
+    }
+    lower[length] = (char) tolower((unsigned char) extension[length]);
+    length++;
+  }
+  lower[length] = '\0';
+
+  const struct mime_type *type = &mime_types[mime_slot(lower, length)];
+  if (type->extension == NULL || strcmp(type->extension, lower) != 0) {
+    return NULL;
+  }
+  return type;
+
+}
+
+/*
+ *  Does a buffer start with some bytes?
+ *
+ *  @param unsigned char *data The buffer.
+ *  @param size_t length How long it is.
+ *  @param char *signature The bytes.
+ *  @param size_t signature_length How many there are.
+ *  @return int 1 if yes, 0 if no.
+ */
+static int starts_with(const unsigned char *data, size_t length, const char *signature, size_t signature_length) {
+  return length >= signature_length && memcmp(data, signature, signature_length) == 0;
+}
+
+/*
+ *  Skip blanks (and a UTF-8 byte order mark).
+ *
+ *  @param unsigned char *data The buffer.
+ *  @param size_t length How long it is.
+ *  @param size_t i Where to start.
+ *  @return size_t Where the next thing that isn't blank is.
+ */
+static size_t skip_blanks(const unsigned char *data, size_t length, size_t i) {
+  if (i == 0 && starts_with(data, length, "\xef\xbb\xbf", 3)) {
+    i = 3;
+  }
+  while (i < length && isspace(data[i])) {
+    i++;
+  }
+  return i;
+}
+
+/*
+ *  Skip past the end of something, like "?>" or "-->".
+ *
+ *  @param unsigned char *data The buffer.
+ *  @param size_t length How long it is.
+ *  @param size_t i Where to start.
+ *  @param char *end What it ends with.
+ *  @return size_t Where it ends, or `length` if it doesn't.
+ */
+static size_t skip_past(const unsigned char *data, size_t length, size_t i, const char *end) {
+  size_t end_length = strlen(end);
+  for (; i + end_length <= length; i++) {
+    if (memcmp(data + i, end, end_length) == 0) {
+      return i + end_length;
+    }
+  }
+  return length;
+}
+
+/*
+ *  Is a buffer an SVG document? That is, is its first element
+ *  `<svg>`, after nothing but an XML declaration, comments,
+ *  processing instructions and a DOCTYPE?
+ *
+ *  @param unsigned char *data The buffer.
+ *  @param size_t length How long it is.
+ *  @return int 1 if yes, 0 if no.
+ */
+static int starts_with_svg(const unsigned char *data, size_t length) {
+  size_t i = skip_blanks(data, length, 0);
+  while (i < length) {
+    const unsigned char *here = data + i;
+    size_t left = length - i;
+    if (starts_with(here, left, "<?", 2)) {
+      i = skip_past(data, length, i + 2, "?>");
+    } else if (starts_with(here, left, "<!--", 4)) {
+      i = skip_past(data, length, i + 4, "-->");
+    } else if (starts_with(here, left, "<!DOCTYPE", 9)) {
+      size_t name = skip_blanks(data, length, i + 9);
+      return name > i + 9 && starts_with(data + name, length - name, "svg", 3);
+    } else {
+      return starts_with(here, left, "<svg", 4) && left > 4
+        && (isspace(here[4]) || here[4] == '>' || here[4] == '/');
+    }
+    i = skip_blanks(data, length, i);
+  }
+  return 0;
+}
+
+/*
+ *  Work out a file's type from its first bytes.
+ *
+ *  @param unsigned char *data The start of the file.
+ *  @param size_t length How much of it there is
+ *                       (only MIME_SNIFF_LENGTH bytes are looked at).
+ *  @param struct mime_type *known The type its extension says it is (or NULL).
+ *  @return char* The type, or NULL if nothing we know matches.
+ */
+const char *sniff_mime_type(const unsigned char *data, size_t length, const struct mime_type *known) {
+
+  if (length > MIME_SNIFF_LENGTH) {
+    length = MIME_SNIFF_LENGTH;
+  }
+
+  if (starts_with(data, length, "\x89PNG\r\n\x1a\n", 8)) {
+    return "image/png";
+  }
+  if (starts_with(data, length, "GIF87a", 6) || starts_with(data, length, "GIF89a", 6)) {
+    return "image/gif";
+  }
+  if (starts_with(data, length, "\xff\xd8\xff", 3)) {
+    return "image/jpeg";
+  }
+  if (starts_with(data, length, "RIFF", 4) && length >= 12 && memcmp(data + 8, "WEBP", 4) == 0) {
+    return "image/webp";
+  }
+  if (starts_with(data, length, "wOF2", 4)) {
+    return "font/woff2";
+  }
+  if (starts_with(data, length, "wOFF", 4)) {
+    return "font/woff";
+  }
+  if (starts_with(data, length, "\x1f\x8b", 2)) {
+    return "application/gzip";
+  }
+
+  // SVG has no signature, so it's only taken for SVG if its
+  // root element is `<svg>`, and never over a text type we
+  // know (HTML and scripts can have inline SVG in them).
+  if (!(known != NULL && (known->flags & MIME_TEXT)) && starts_with_svg(data, length)) {
+    return "image/svg+xml";
+  }
+
+  return NULL;
+
+}
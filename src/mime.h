@@ -0,0 +1,79 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for mime.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef MIME_H
+#define MIME_H
+
+// For `size_t`.
+#include <stddef.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// What we say about a file we can't classify.
+#define DEFAULT_MIME_TYPE "application/octet-stream"
+
+// Flags for each type: an image we base64 encode,
+// a format that's compressed already, and text
+// (markup, scripts, data) that `--sniff` leaves alone.
+#define MIME_IMAGE 1
+#define MIME_COMPRESSED 2
+#define MIME_TEXT 4
+
+// How much of a file `--sniff` looks at.
+#define MIME_SNIFF_LENGTH 512
+
+// The table: how big it is, and the seed that gives
+// every extension in it a slot of its own.
+#define MIME_TABLE_SIZE 256
+#define MIME_TABLE_SEED 49u
+#define MAX_MIME_EXTENSION_LENGTH 16
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// A type we know, by its extension. `flags` says whether it's
+// an image we base64 encode (MIME_IMAGE), whether it's
+// compressed already (MIME_COMPRESSED), and whether it's
+// text (MIME_TEXT).
+struct mime_type {
+  const char *extension;
+  const char *name;
+  int flags;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in mime.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+const struct mime_type *find_mime_type(const char *extension);
+const char *sniff_mime_type(const unsigned char *data, size_t length, const struct mime_type *known);
+
+#endif
@@ -0,0 +1,336 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file runs the walk as a pipeline (`--pipeline N`).
+ *
+ *    One thread walks the tree, in the same order as a plain
+ *    walk, and numbers each file it finds. N workers take the
+ *    files in that order and read, hash and encode them, and a
+ *    single writer hands the finished records on. A worker can
+ *    finish before one that started earlier, so the writer holds
+ *    finished records back until every one before them is written:
+ *    the output comes out in traversal order, just as it would
+ *    without the pipeline, while the walk, the hashing and the
+ *    writing all overlap.
+ *
+ *    The queue and the reorder buffer are one ring of
+ *    PIPELINE_WINDOW slots, indexed by sequence number. The
+ *    walker waits when the writer falls a whole window behind,
+ *    so memory stays bounded however big the tree is.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `strdup()`.
+#include <string.h>
+
+// For fixed width integers, e.g., `uint64_t`.
+#include <stdint.h>
+
+// For using the `stat()` function.
+#include <sys/stat.h>
+
+// For threads, mutexes and condition variables.
+#include <pthread.h>
+
+// We walk directories and build entries with these.
+#include "processing.h"
+
+// Finished records are copied out of the workers' buffers with this.
+#include "record.h"
+
+// We need the header that declares the prototypes for this file.
+#include "pipeline.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// One file on its way through the pipeline.
+struct pipeline_slot {
+  char *path;
+  int has_info;
+  struct stat info;
+
+  // Set by the worker: the finished record (NULL if there
+  // isn't one), and whether the worker is done with it.
+  struct asset_record *record;
+  int done;
+};
+
+// The threads and the ring of one pipelined walk.
+struct pipeline {
+  struct scan *scan;
+  int number_of_workers;
+
+  pthread_mutex_t lock;
+  pthread_cond_t work_ready;
+  pthread_cond_t result_ready;
+  pthread_cond_t room_ready;
+
+  // The next sequence number the walker gives out, the next one
+  // a worker takes, and the next one the writer writes.
+  uint64_t next_sequence;
+  uint64_t next_claim;
+  uint64_t next_write;
+
+  // Set once the walker has found everything.
+  int walk_finished;
+
+  struct pipeline_slot slots[PIPELINE_WINDOW];
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in pipeline.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Queue a file for the workers. If the writer is a whole
+ *  window behind, wait until it catches up.
+ *
+ *  @param struct pipeline *pipeline The pipeline.
+ *  @param char *path The path to the file.
+ *  @param struct stat *info Info about the file (or NULL if we didn't stat it).
+ *  @return void
+ */
+void submit_to_pipeline(struct pipeline *pipeline, const char *path, struct stat *info) {
+
+  char *copy = strdup(path);
+  if (copy == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+
+  pthread_mutex_lock(&pipeline->lock);
+
+  while (pipeline->next_sequence - pipeline->next_write >= PIPELINE_WINDOW) {
+    pthread_cond_wait(&pipeline->room_ready, &pipeline->lock);
+  }
+
+  struct pipeline_slot *slot = &pipeline->slots[pipeline->next_sequence & (PIPELINE_WINDOW - 1)];
+  slot->path = copy;
+  slot->has_info = info != NULL;
+  if (info != NULL) {
+    slot->info = *info;
+  }
+  slot->record = NULL;
+  slot->done = 0;
+  pipeline->next_sequence++;
+
+  pthread_cond_signal(&pipeline->work_ready);
+  pthread_mutex_unlock(&pipeline->lock);
+
+}
+
+/*
+ *  Build a file's record, and copy it out of the buffers it was built in.
+ *
+ *  @param struct scan *scan The scan.
+ *  @param char *path The path to the file.
+ *  @param struct stat *info Info about the file (or NULL).
+ *  @return struct asset_record* The record (to be freed), or NULL
+ *                               if the scan has failed.
+ */
+static struct asset_record *build_record(struct scan *scan, char *path, struct stat *info) {
+  if (scan_failed(scan)) {
+    return NULL;
+  }
+  char entry_buffer[scan->entry_capacity];
+  struct string_builder entry;
+  init_string_builder(&entry, entry_buffer, scan->entry_capacity);
+  struct record_buffers buffers;
+  struct asset_record record;
+  if (!build_entry(scan, &entry, &buffers, &record, path, info)) {
+    return NULL;
+  }
+  return copy_record(&record);
+}
+
+/*
+ *  The main loop of a worker: take the oldest queued file,
+ *  process it, and put its record back in its slot.
+ *
+ *  @param void *argument The pipeline.
+ *  @return void * Nothing.
+ */
+static void *worker_loop(void *argument) {
+
+  struct pipeline *pipeline = argument;
+
+  pthread_mutex_lock(&pipeline->lock);
+  for (;;) {
+
+    while (pipeline->next_claim == pipeline->next_sequence && !pipeline->walk_finished) {
+      pthread_cond_wait(&pipeline->work_ready, &pipeline->lock);
+    }
+    if (pipeline->next_claim == pipeline->next_sequence) {
+      break;
+    }
+
+    // The slot is ours until we mark it done: the walker
+    // can't reuse it before the writer has been past it.
+    uint64_t sequence = pipeline->next_claim++;
+    struct pipeline_slot *slot = &pipeline->slots[sequence & (PIPELINE_WINDOW - 1)];
+    pthread_mutex_unlock(&pipeline->lock);
+
+    struct asset_record *record = build_record(pipeline->scan, slot->path, slot->has_info ? &slot->info : NULL);
+    free(slot->path);
+
+    pthread_mutex_lock(&pipeline->lock);
+    slot->record = record;
+    slot->done = 1;
+    if (sequence == pipeline->next_write) {
+      pthread_cond_signal(&pipeline->result_ready);
+    }
+
+  }
+  pthread_mutex_unlock(&pipeline->lock);
+
+  return NULL;
+
+}
+
+/*
+ *  The main loop of the writer: hand the records on
+ *  strictly in sequence, waiting for each one's turn.
+ *
+ *  @param void *argument The pipeline.
+ *  @return void * Nothing.
+ */
+static void *writer_loop(void *argument) {
+
+  struct pipeline *pipeline = argument;
+
+  pthread_mutex_lock(&pipeline->lock);
+  for (;;) {
+
+    struct pipeline_slot *slot = &pipeline->slots[pipeline->next_write & (PIPELINE_WINDOW - 1)];
+
+    // The next record is ready: write it (without holding the lock).
+    if (pipeline->next_write < pipeline->next_sequence && slot->done) {
+      struct asset_record *record = slot->record;
+      slot->record = NULL;
+      slot->done = 0;
+      pthread_mutex_unlock(&pipeline->lock);
+
+      if (record != NULL) {
+        emit_record(pipeline->scan, record);
+        free(record);
+      }
+
+      pthread_mutex_lock(&pipeline->lock);
+      pipeline->next_write++;
+      pthread_cond_signal(&pipeline->room_ready);
+    }
+
+    // Everything has been found and written.
+    else if (pipeline->walk_finished && pipeline->next_write == pipeline->next_sequence) {
+      break;
+    }
+
+    // Otherwise, the next record isn't done yet.
+    else {
+      pthread_cond_wait(&pipeline->result_ready, &pipeline->lock);
+    }
+
+  }
+  pthread_mutex_unlock(&pipeline->lock);
+
+  return NULL;
+
+}
+
+/*
+ *  Walk a directory tree on this thread, with the scan's
+ *  `pipeline_workers` threads processing the files and one
+ *  more writing them, and wait until it's done.
+ *
+ *  @param struct scan *scan The scan.
+ *  @param char *path The folder to walk.
+ *  @return void
+ */
+void run_pipeline(struct scan *scan, const char *path) {
+
+  struct pipeline *pipeline = malloc(sizeof(struct pipeline));
+  if (pipeline == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  memset(pipeline, 0, sizeof(struct pipeline));
+  pipeline->scan = scan;
+  pipeline->number_of_workers = scan->pipeline_workers;
+  pthread_mutex_init(&pipeline->lock, NULL);
+  pthread_cond_init(&pipeline->work_ready, NULL);
+  pthread_cond_init(&pipeline->result_ready, NULL);
+  pthread_cond_init(&pipeline->room_ready, NULL);
+
+  // Start the workers and the writer.
+  pthread_t workers[MAX_PIPELINE_WORKERS];
+  pthread_t writer;
+  int i;
+  for (i = 0; i < pipeline->number_of_workers; i++) {
+    if (pthread_create(&workers[i], NULL, worker_loop, pipeline) != 0) {
+      puts("Could not start a worker thread.");
+      exit(1);
+    }
+  }
+  if (pthread_create(&writer, NULL, writer_loop, pipeline) != 0) {
+    puts("Could not start a writer thread.");
+    exit(1);
+  }
+
+  // Walk the tree. From here on, the walk hands the files
+  // it finds to the pipeline.
+  scan->pipeline = pipeline;
+  walk_directory(scan, path);
+  scan->pipeline = NULL;
+
+  // Let everyone know there's no more coming, and wait for them to finish.
+  pthread_mutex_lock(&pipeline->lock);
+  pipeline->walk_finished = 1;
+  pthread_cond_broadcast(&pipeline->work_ready);
+  pthread_cond_broadcast(&pipeline->result_ready);
+  pthread_mutex_unlock(&pipeline->lock);
+
+  for (i = 0; i < pipeline->number_of_workers; i++) {
+    pthread_join(workers[i], NULL);
+  }
+  pthread_join(writer, NULL);
+
+  pthread_cond_destroy(&pipeline->room_ready);
+  pthread_cond_destroy(&pipeline->result_ready);
+  pthread_cond_destroy(&pipeline->work_ready);
+  pthread_mutex_destroy(&pipeline->lock);
+  free(pipeline);
+
+}
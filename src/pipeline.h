@@ -0,0 +1,51 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for pipeline.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+// For `struct stat`.
+#include <sys/stat.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define MAX_PIPELINE_WORKERS 256
+
+// How many files can be between the walker and the writer at once
+// (queued, being processed, or done and waiting for their turn).
+// It has to be a power of 2.
+#define PIPELINE_WINDOW 1024
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in pipeline.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+struct scan;
+struct pipeline;
+
+void submit_to_pipeline(struct pipeline *pipeline, const char *path, struct stat *info);
+void run_pipeline(struct scan *scan, const char *path);
+
+#endif
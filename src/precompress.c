@@ -0,0 +1,378 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file writes precompressed siblings of files
+ *    (`--precompress gzip,zstd`): `style.css.gz` and
+ *    `style.css.zst` next to `style.css`, for a static server
+ *    to send to clients that accept them.
+ *
+ *    Each file is compressed from the bytes that were already
+ *    read to hash it, so it isn't read twice. A sibling that
+ *    doesn't save at least a tenth of the size isn't worth
+ *    serving, so it isn't written.
+ *
+ *    A sibling is written to a temporary file and renamed into
+ *    place, so a server never sees half of one. Each is marked
+ *    (PRECOMPRESS_MARK), so that when a file stops being worth
+ *    compressing, only a sibling we wrote is removed.
+ *
+ *    gzip uses zlib. zstd needs libzstd, and is only built in
+ *    with `make ZSTD=1` (which defines ASSETS_ZSTD).
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `malloc()`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `strncmp()`.
+#include <string.h>
+
+// For fixed width integers, e.g., `uint32_t`.
+#include <stdint.h>
+
+// For `errno`.
+#include <errno.h>
+
+// For `open()`.
+#include <fcntl.h>
+
+// For `write()`, `close()`, `pread()`, `access()` and `unlink()`.
+#include <unistd.h>
+
+// For gzip.
+#include <zlib.h>
+
+// For zstd (if it's built in).
+#ifdef ASSETS_ZSTD
+#include <zstd.h>
+#endif
+
+// For MAX_PATH_LENGTH.
+#include "processing.h"
+
+// We need the header that declares the prototypes for this file.
+#include "precompress.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in precompress.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Get the name of a variant.
+ *
+ *  @param int variant PRECOMPRESS_GZIP or PRECOMPRESS_ZSTD.
+ *  @return char* Its name ("gzip" or "zstd").
+ */
+const char *precompress_name(int variant) {
+  return variant == PRECOMPRESS_ZSTD ? "zstd" : "gzip";
+}
+
+/*
+ *  Get the ending of a variant's siblings.
+ *
+ *  @param int variant PRECOMPRESS_GZIP or PRECOMPRESS_ZSTD.
+ *  @return char* The ending (".gz" or ".zst").
+ */
+static const char *sibling_ending(int variant) {
+  return variant == PRECOMPRESS_ZSTD ? ".zst" : ".gz";
+}
+
+/*
+ *  Work out which variants a list (like "gzip,zstd") asks for.
+ *
+ *  @param char *list The names, separated by commas.
+ *  @return int The variants (PRECOMPRESS_GZIP, PRECOMPRESS_ZSTD or both),
+ *              or -1 if a name isn't one of them.
+ */
+int find_precompress_variants(const char *list) {
+  int variants = 0;
+  while (*list != '\0') {
+    size_t length = strcspn(list, ",");
+    if (length == 4 && strncmp(list, "gzip", 4) == 0) {
+      variants |= PRECOMPRESS_GZIP;
+    } else if (length == 4 && strncmp(list, "zstd", 4) == 0) {
+      variants |= PRECOMPRESS_ZSTD;
+    } else {
+      return -1;
+    }
+    list += length;
+    if (*list == ',') {
+      list++;
+    }
+  }
+  return variants != 0 ? variants : -1;
+}
+
+/*
+ *  Are these variants built in?
+ *
+ *  @param int variants The variants.
+ *  @return int 1 if yes, 0 if no.
+ */
+int precompress_is_available(int variants) {
+#ifndef ASSETS_ZSTD
+  if (variants & PRECOMPRESS_ZSTD) {
+    return 0;
+  }
+#endif
+  return 1;
+}
+
+/*
+ *  Is this file a sibling we (may have) written? That is, does
+ *  it end in .gz or .zst, with the file it was made from next to it?
+ *  (Or is it one we're writing right now?)
+ *  Siblings aren't assets of their own, so the walk skips them.
+ *
+ *  @param char *path The path to the file.
+ *  @return int 1 if yes, 0 if no.
+ */
+int is_precompressed_sibling(const char *path) {
+  size_t length = strlen(path);
+  size_t ending_length = strlen(PRECOMPRESS_TEMPORARY_ENDING);
+  if (length > ending_length && strcmp(path + length - ending_length, PRECOMPRESS_TEMPORARY_ENDING) == 0) {
+    return 1;
+  }
+  if (length > 3 && strcmp(path + length - 3, ".gz") == 0) {
+    ending_length = 3;
+  } else if (length > 4 && strcmp(path + length - 4, ".zst") == 0) {
+    ending_length = 4;
+  } else {
+    return 0;
+  }
+  if (length - ending_length >= MAX_PATH_LENGTH) {
+    return 0;
+  }
+  char original[MAX_PATH_LENGTH];
+  memcpy(original, path, length - ending_length);
+  original[length - ending_length] = '\0';
+  return access(original, F_OK) == 0;
+}
+
+/*
+ *  Compress some bytes with gzip.
+ *
+ *  @param char *data The bytes.
+ *  @param size_t length How many there are.
+ *  @param char *output Where to put the compressed bytes.
+ *  @param size_t room How much room there is there.
+ *  @return size_t How many compressed bytes there are (0 if they didn't fit).
+ */
+static size_t gzip_bytes(const unsigned char *data, size_t length, unsigned char *output, size_t room) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+
+  // A window of 15 bits, plus 16 for a gzip header and trailer.
+  if (deflateInit2(&stream, PRECOMPRESS_GZIP_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return 0;
+  }
+
+  // The header's comment marks it as ours (3 is Unix).
+  gz_header header;
+  memset(&header, 0, sizeof(header));
+  header.comment = (Bytef *) PRECOMPRESS_MARK;
+  header.os = 3;
+  deflateSetHeader(&stream, &header);
+
+  // zlib wants a non-const pointer, but doesn't write through it.
+  stream.next_in = (Bytef *) data;
+  stream.avail_in = (uInt) length;
+  stream.next_out = output;
+  stream.avail_out = (uInt) room;
+  int result = deflate(&stream, Z_FINISH);
+  size_t compressed = stream.total_out;
+  deflateEnd(&stream);
+  return result == Z_STREAM_END ? compressed : 0;
+}
+
+/*
+ *  Compress a file's bytes as one of the variants. If it doesn't
+ *  come out at most PRECOMPRESS_MAX_PERCENT of the size, it isn't
+ *  worth keeping.
+ *
+ *  @param int variant PRECOMPRESS_GZIP or PRECOMPRESS_ZSTD.
+ *  @param char *data The bytes.
+ *  @param size_t length How many there are.
+ *  @param char **output Set to the compressed bytes (to be freed), if they're worth keeping.
+ *  @return size_t How many compressed bytes there are, or 0 if they aren't worth keeping.
+ */
+size_t precompress_bytes(int variant, const unsigned char *data, size_t length, unsigned char **output) {
+
+  // Files too big for zlib's counters aren't served as one response anyway.
+  if (length == 0 || length > (size_t) UINT32_MAX / 2) {
+    return 0;
+  }
+
+  // There's only room for a result that's small enough to keep.
+  size_t most = length / 100 * PRECOMPRESS_MAX_PERCENT + length % 100 * PRECOMPRESS_MAX_PERCENT / 100;
+  unsigned char *compressed = malloc(most + 1);
+  if (compressed == NULL) {
+    return 0;
+  }
+
+  size_t compressed_length = 0;
+#ifdef ASSETS_ZSTD
+  if (variant == PRECOMPRESS_ZSTD) {
+
+    // The skippable frame that marks it as ours goes first.
+    if (most + 1 > PRECOMPRESS_ZSTD_MARK_LENGTH) {
+      memcpy(compressed, PRECOMPRESS_ZSTD_MARK, PRECOMPRESS_ZSTD_MARK_LENGTH);
+      compressed_length = ZSTD_compress(compressed + PRECOMPRESS_ZSTD_MARK_LENGTH,
+                                        most + 1 - PRECOMPRESS_ZSTD_MARK_LENGTH,
+                                        data, length, PRECOMPRESS_ZSTD_LEVEL);
+      compressed_length = ZSTD_isError(compressed_length) ? 0 : compressed_length + PRECOMPRESS_ZSTD_MARK_LENGTH;
+    }
+
+  } else
+#endif
+  compressed_length = gzip_bytes(data, length, compressed, most + 1);
+
+  if (compressed_length == 0 || compressed_length > most) {
+    free(compressed);
+    return 0;
+  }
+  *output = compressed;
+  return compressed_length;
+
+}
+
+/*
+ *  Put a variant's ending on a file's path.
+ *
+ *  @param char *sibling Where to put the sibling's path (MAX_PATH_LENGTH + 8 long).
+ *  @param char *path The path to the file.
+ *  @param int variant PRECOMPRESS_GZIP or PRECOMPRESS_ZSTD.
+ *  @return int 1 if it fit, 0 if not.
+ */
+static int sibling_path(char *sibling, const char *path, int variant) {
+  return snprintf(sibling, MAX_PATH_LENGTH + 8, "%s%s", path, sibling_ending(variant)) < MAX_PATH_LENGTH + 8;
+}
+
+/*
+ *  Write all of some bytes to a file.
+ *
+ *  @param int descriptor The file.
+ *  @param char *data The bytes.
+ *  @param size_t length How many there are.
+ *  @return int 1 if they were written, 0 if not.
+ */
+static int write_all(int descriptor, const unsigned char *data, size_t length) {
+  while (length > 0) {
+    ssize_t written = write(descriptor, data, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return 0;
+    }
+    data += written;
+    length -= (size_t) written;
+  }
+  return 1;
+}
+
+/*
+ *  Write a file's sibling (replacing any that's there). It's written
+ *  to a temporary file first, then renamed over the sibling, so the
+ *  old one stays whole until the new one is.
+ *
+ *  @param char *path The path to the file.
+ *  @param int variant PRECOMPRESS_GZIP or PRECOMPRESS_ZSTD.
+ *  @param char *data The compressed bytes.
+ *  @param size_t length How many there are.
+ *  @return int 1 if it was written, 0 if not.
+ */
+int write_sibling(const char *path, int variant, const unsigned char *data, size_t length) {
+
+  char sibling[MAX_PATH_LENGTH + 8];
+  char temporary[MAX_PATH_LENGTH + 8 + sizeof(PRECOMPRESS_TEMPORARY_ENDING)];
+  if (!sibling_path(sibling, path, variant)) {
+    return 0;
+  }
+  snprintf(temporary, sizeof(temporary), "%s%s", sibling, PRECOMPRESS_TEMPORARY_ENDING);
+
+  int descriptor = open(temporary, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (descriptor < 0) {
+    return 0;
+  }
+  int written = write_all(descriptor, data, length);
+  if (close(descriptor) != 0) {
+    written = 0;
+  }
+  if (!written || rename(temporary, sibling) != 0) {
+    (void) unlink(temporary);
+    return 0;
+  }
+  return 1;
+
+}
+
+/*
+ *  Is a sibling one we wrote? That is, does it start with our mark?
+ *
+ *  @param char *sibling The path to the sibling.
+ *  @param int variant PRECOMPRESS_GZIP or PRECOMPRESS_ZSTD.
+ *  @return int 1 if yes, 0 if no (or it can't be read).
+ */
+static int is_own_sibling(const char *sibling, int variant) {
+
+  int descriptor = open(sibling, O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0) {
+    return 0;
+  }
+  unsigned char head[PRECOMPRESS_ZSTD_MARK_LENGTH + 4];
+  ssize_t length = pread(descriptor, head, sizeof(head), 0);
+  close(descriptor);
+
+  // A gzip header with only a comment (FCOMMENT), which comes
+  // straight after its first 10 bytes.
+  if (variant == PRECOMPRESS_GZIP) {
+    size_t mark_length = sizeof(PRECOMPRESS_MARK);
+    return length >= (ssize_t) (10 + mark_length)
+      && memcmp(head, "\x1f\x8b\x08\x10", 4) == 0
+      && memcmp(head + 10, PRECOMPRESS_MARK, mark_length) == 0;
+  }
+  return length >= PRECOMPRESS_ZSTD_MARK_LENGTH
+    && memcmp(head, PRECOMPRESS_ZSTD_MARK, PRECOMPRESS_ZSTD_MARK_LENGTH) == 0;
+
+}
+
+/*
+ *  Remove a file's sibling, if it has one we wrote: one made from
+ *  an earlier version of the file would be wrong now. A sibling
+ *  someone else made is left alone.
+ *
+ *  @param char *path The path to the file.
+ *  @param int variant PRECOMPRESS_GZIP or PRECOMPRESS_ZSTD.
+ *  @return void
+ */
+void remove_sibling(const char *path, int variant) {
+  char sibling[MAX_PATH_LENGTH + 8];
+  if (sibling_path(sibling, path, variant) && is_own_sibling(sibling, variant)) {
+    (void) unlink(sibling);
+  }
+}
@@ -0,0 +1,77 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for precompress.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef PRECOMPRESS_H
+#define PRECOMPRESS_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For MAX_DIGEST_HEX_LENGTH.
+#include "digest.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The compressed siblings we can write (a set of flags).
+#define PRECOMPRESS_GZIP 1
+#define PRECOMPRESS_ZSTD 2
+#define PRECOMPRESS_VARIANTS 2
+
+// A sibling is only kept if it's at most this many percent
+// of the size of the file.
+#define PRECOMPRESS_MAX_PERCENT 90
+
+// Siblings are written once and served many times, so
+// they're worth compressing hard.
+#define PRECOMPRESS_GZIP_LEVEL 9
+#define PRECOMPRESS_ZSTD_LEVEL 19
+
+// What our siblings are marked with, so we only ever remove our own:
+// the comment in a gzip header, or the contents of a zstd skippable
+// frame (magic number, then length, both little-endian) at the start.
+#define PRECOMPRESS_MARK "assets"
+#define PRECOMPRESS_ZSTD_MARK "\x50\x2a\x4d\x18\x06\x00\x00\x00" PRECOMPRESS_MARK
+#define PRECOMPRESS_ZSTD_MARK_LENGTH 14
+
+// A sibling is written under this ending first, then renamed into place.
+#define PRECOMPRESS_TEMPORARY_ENDING ".assets-tmp"
+
+// Room in an entry for one variant: its name, size and digest.
+#define PRECOMPRESS_ENTRY_LENGTH (64 + MAX_DIGEST_HEX_LENGTH)
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in precompress.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+int find_precompress_variants(const char *list);
+int precompress_is_available(int variants);
+const char *precompress_name(int variant);
+int is_precompressed_sibling(const char *path);
+size_t precompress_bytes(int variant, const unsigned char *data, size_t length, unsigned char **output);
+int write_sibling(const char *path, int variant, const unsigned char *data, size_t length);
+void remove_sibling(const char *path, int variant);
+
+#endif
@@ -37,6 +37,12 @@
 // For working with directory entities (on POSIX systems).
 #include <dirent.h>
 
+// For `openat()` and the `AT_*` flags.
+#include <fcntl.h>
+
+// For `close()`.
+#include <unistd.h>
+
 // For functions like `basename()`.
 #include <libgen.h>
 
@@ -46,8 +52,42 @@
 // We want to use our utilities.
 #include "utilities.h"
 
-// We want to use our logging/writing tools.
-#include "logging.h"
+// We skip ignored names with these.
+#include "ignore.h"
+
+// We build entries and paths with these.
+#include "string_builder.h"
+
+// We read each file once, for everything that needs it, with these.
+#include "content.h"
+
+// We hash files with whichever algorithm `--hash` picked.
+#include "digest.h"
+
+// We want to use our base64 encoder.
+#include "base64.h"
+
+// We work out what type of content a file has with these.
+#include "mime.h"
+
+// We hand work to other threads with these.
+#include "jobs.h"
+#include "pipeline.h"
+
+// We reuse hashes from earlier runs with these.
+#include "cache.h"
+
+// We size images (`--dimensions`) with these.
+#include "dimensions.h"
+
+// We write compressed siblings (`--precompress`) with these.
+#include "precompress.h"
+
+// We make integrity values (`--sri`) with these.
+#include "sri.h"
+
+// We time each phase (`--stats`) with these.
+#include "stats.h"
 
 // We need the header that declares the prototypes for this file.
 #include "processing.h"
@@ -55,15 +95,13 @@
 
 /*  ------------------------------------------------------------
  *
- *  NON-CONSTANT VARIABLES
+ *  DEF/CONSTANTS
  *
  *  ------------------------------------------------------------
  */
-int max_entry_length = 1024;
-int cachebust = 0;
-int max_base64_size = 0;
-int max_filesize_to_base64_encode = 0;
-int max_chars_in_base64_strings = 0;
+
+// The usual max size of an entry (before base64 content).
+#define BASE_ENTRY_LENGTH 1024
 
 
 /*  ------------------------------------------------------------
@@ -75,67 +113,206 @@ int max_chars_in_base64_strings = 0;
  */
 
 /*
- *  Set the max size of each entry.
+ *  Set up a scan from a set of options.
  *
- *  @param int size The size.
+ *  @param struct scan *scan The scan to set up.
+ *  @param struct assets_options *options The options.
+ *  @param char *error Where to put a message if the options are no good.
+ *  @param size_t error_length How much room there is for it.
+ *  @return int 1 if it's ready, 0 if the options are no good.
+ */
+int init_scan(struct scan *scan, const struct assets_options *options, char *error, size_t error_length) {
+
+  memset(scan, 0, sizeof(struct scan));
+
+  scan->algorithm = DIGEST_MD5;
+  if (options->hash != NULL) {
+    scan->algorithm = find_digest_algorithm(options->hash);
+    if (scan->algorithm < 0) {
+      snprintf(error, error_length, "--hash must be one of: md5, sha256, xxh3, blake3");
+      return 0;
+    }
+  }
+
+  scan->cachebust = options->cachebust;
+  scan->sniff = options->sniff;
+  scan->dimensions = options->dimensions;
+  if (options->sri != NULL) {
+    scan->sri = find_sri_algorithms(options->sri);
+    if (scan->sri < 0) {
+      snprintf(error, error_length, "--sri must be a list of: sha256, sha384, sha512");
+      return 0;
+    }
+  }
+  if (options->precompress != NULL) {
+    scan->precompress = find_precompress_variants(options->precompress);
+    if (scan->precompress < 0) {
+      snprintf(error, error_length, "--precompress must be a list of: gzip, zstd");
+      return 0;
+    }
+    if (!precompress_is_available(scan->precompress)) {
+      snprintf(error, error_length, "This build can't write zstd. Rebuild with `make ZSTD=1` (it needs libzstd).");
+      return 0;
+    }
+  }
+  scan->digest_threads = options->hash_threads > 0 ? options->hash_threads : 1;
+  scan->number_of_jobs = options->jobs > 0 ? options->jobs : 1;
+  if (scan->number_of_jobs > MAX_JOBS) {
+    scan->number_of_jobs = MAX_JOBS;
+  }
+  scan->pipeline_workers = options->pipeline_workers > 0 ? options->pipeline_workers : 0;
+  if (scan->pipeline_workers > MAX_PIPELINE_WORKERS) {
+    scan->pipeline_workers = MAX_PIPELINE_WORKERS;
+  }
+  if (scan->pipeline_workers > 0 && scan->number_of_jobs > 1) {
+    snprintf(error, error_length, "--pipeline can't be used with --jobs.");
+    return 0;
+  }
+
+  // Leave room in each entry for the longest path and names,
+  // and for the base64 content, if there is any.
+  scan->entry_capacity = BASE_ENTRY_LENGTH + MAX_PATH_LENGTH + 3 * MAX_FILENAME_LENGTH;
+  if (options->base64_max_size >= 0) {
+    scan->base64_enabled = 1;
+    scan->max_filesize_to_base64_encode = options->base64_max_size;
+    // 1.37 is the factor by-which we multiple the file size
+    // to (roughly) determine what the base64 encoded size will be
+    // 820 is the additional header bytes of data that base64 encoding adds
+    // to encode binary data
+    // see: http://en.wikipedia.org/wiki/Base64#MIME
+    scan->entry_capacity += (size_t) ((options->base64_max_size * 1.37) + 820);
+  }
+  if (scan->dimensions) {
+    scan->entry_capacity += DIMENSIONS_ENTRY_LENGTH;
+  }
+  if (scan->sri) {
+    scan->entry_capacity += MAX_SRI_LENGTH + 16;
+  }
+  if (scan->precompress) {
+    scan->entry_capacity += PRECOMPRESS_VARIANTS * PRECOMPRESS_ENTRY_LENGTH;
+  }
+
+  // Compile the patterns to ignore: the file's first, so
+  // `ignore` can override them.
+  init_ignore_set(&scan->ignored);
+  if (options->ignore_file != NULL && !add_ignore_file(&scan->ignored, options->ignore_file)) {
+    snprintf(error, error_length, "Could not read the ignore file:\n%s", options->ignore_file);
+    free_ignore_set(&scan->ignored);
+    return 0;
+  }
+  if (options->ignore != NULL) {
+    add_to_ignore_set(&scan->ignored, options->ignore);
+  }
+
+  scan->record_handler = options->on_record;
+  scan->context = options->context;
+  atomic_init(&scan->failed, 0);
+  pthread_mutex_init(&scan->error_lock, NULL);
+  return 1;
+
+}
+
+/*
+ *  Let go of everything a scan holds.
+ *
+ *  @param struct scan *scan The scan.
  *  @return void
  */
-void set_max_entry_length(int size) {
-  max_entry_length += size;
+void free_scan(struct scan *scan) {
+  free_ignore_set(&scan->ignored);
+  pthread_mutex_destroy(&scan->error_lock);
 }
 
 /*
- *  Set the cachebust flag.
+ *  Note that a scan went wrong. Only the first message is kept.
  *
- *  @param int flag 1 to turn cachebust naming on, 0 to turn it off.
+ *  @param struct scan *scan The scan.
+ *  @param char *message What went wrong.
+ *  @param char *path The path it went wrong with.
  *  @return void
  */
-void set_cachebust(int flag) {
-  cachebust = flag;
+void fail_scan(struct scan *scan, const char *message, const char *path) {
+  pthread_mutex_lock(&scan->error_lock);
+  if (!atomic_load(&scan->failed)) {
+    snprintf(scan->error, sizeof(scan->error), "%s\n%s", message, path);
+    atomic_store(&scan->failed, 1);
+  }
+  pthread_mutex_unlock(&scan->error_lock);
+}
+
+/*
+ *  Has a scan gone wrong?
+ *
+ *  @param struct scan *scan The scan.
+ *  @return int 1 if yes, 0 if no.
+ */
+int scan_failed(struct scan *scan) {
+  return atomic_load(&scan->failed);
 }
 
 /*
- *  Set the max size of base64 content.
+ *  Forget that a scan went wrong, so it can go on (`--watch`
+ *  does this after reporting a path it couldn't handle).
  *
- *  @param int size The max number of characters.
+ *  @param struct scan *scan The scan.
  *  @return void
  */
-void set_max_filesize_to_base64_encode(int size) {
-  max_filesize_to_base64_encode = size;
-  // 1.37 is the factor by-which we multiple the file size
-  // to (roughly) determine what the base64 encoded size will be
-  // 820 is the additional header bytes of data that base64 encoding adds
-  // to encode binary data
-  // see: http://en.wikipedia.org/wiki/Base64#MIME
-  max_chars_in_base64_strings = (int) ((size * 1.37) + 820);
-  set_max_entry_length(max_chars_in_base64_strings);
+void clear_scan_failure(struct scan *scan) {
+  pthread_mutex_lock(&scan->error_lock);
+  scan->error[0] = '\0';
+  atomic_store(&scan->failed, 0);
+  pthread_mutex_unlock(&scan->error_lock);
+}
+
+/*
+ *  Is a path under the walk ignored?
+ *
+ *  @param struct scan *scan The scan.
+ *  @param char *path The full path.
+ *  @param int is_directory 1 if it's a folder, 0 if not.
+ *  @return int 1 if yes, 0 if no.
+ */
+int path_is_ignored(const struct scan *scan, const char *path, int is_directory) {
+
+  // Patterns are matched against the path from the top of the walk.
+  const char *relative = path;
+  if (strncmp(path, scan->root, scan->root_length) == 0) {
+    relative += scan->root_length;
+  }
+  while (*relative == '/') {
+    relative++;
+  }
+  if (is_ignored(&scan->ignored, relative, is_directory)) {
+    return 1;
+  }
+
+  // The compressed siblings we write aren't assets of their own.
+  return scan->precompress && !is_directory && is_precompressed_sibling(path);
+
 }
 
 /*
  *  Find the path of a directory (everything up to its filename).
  *
- *  @param char *variable The variable to store the path in.
+ *  @param struct string_builder *variable The builder to store the path in.
  *  @param char *full_path The full path.
  *  @return void
  */
-void base_path(char *variable, const char *full_path) {
+void base_path(struct string_builder *variable, const char *full_path) {
 
-  // We'll need to find the index of the last "/".
-  int index;
-  int needle = '/';
+  reset_string_builder(variable);
 
-  // Find the position of that last "/".
-  last_char_pos(&index, full_path, needle);
+  // Find the position of the last "/".
+  const char *slash = strrchr(full_path, '/');
 
   // If there's no slash in the path, then we can just use the full path.
-  if (index == 0) {
-    initialize_string(variable);
-    add_to_string(variable, full_path);
+  if (slash == NULL || slash == full_path) {
+    append_to_builder(variable, full_path);
   }
 
   // Otherwise, we want everything up through the last slash.
   else {
-    substr(variable, full_path, index + 1);
+    append_bytes_to_builder(variable, full_path, (size_t) (slash - full_path) + 1);
   }
 
 }
@@ -143,136 +320,102 @@ void base_path(char *variable, const char *full_path) {
 /*
  *  Strip the extension off the filename.
  *
- *  @param char *variable The variable to store the result in.
+ *  @param struct string_builder *variable The builder to store the result in.
  *  @param char *filename The filename to examine.
  *  @return void
  */
-void filename_without_extension(char *variable, const char *filename) {
+void filename_without_extension(struct string_builder *variable, const char *filename) {
 
-  // We'll need to find the index of the last dot.
-  int index;
+  reset_string_builder(variable);
 
-  // Find the position of that last dot.
-  last_char_pos(&index, filename, '.');
+  // Find the position of the last dot.
+  const char *dot = strrchr(filename, '.');
 
-  // If there's no dot in the filename, then we want the full filename.
-  if (index == 0) {
-    initialize_string(variable);
-    add_to_string(variable, filename);
+  // If there's no dot in the filename (or it's a dotfile),
+  // then we want the full filename.
+  if (dot == NULL || dot == filename) {
+    append_to_builder(variable, filename);
   }
 
-  // Otherwise, we want to get everything up to dot's index.
+  // Otherwise, we want to get everything up to the dot.
   else {
-    substr(variable, filename, index);
+    append_bytes_to_builder(variable, filename, (size_t) (dot - filename));
   }
 
 }
 
 /*
  *  Store the specified filename's extension ("png", "svg", etc.) 
- *  in the specified variable.
+ *  in the specified builder.
  *
- *  @param char *variable The variable to store the extension in.
+ *  @param struct string_builder *variable The builder to store the extension in.
  *  @param char *filename The filename to extract the extension from.
  *  @return void
  */
-void extension(char *variable, const char *filename) {
+void extension(struct string_builder *variable, const char *filename) {
 
-  // Make sure the variable is initialized (reset to nothing).
-  initialize_string(variable);
+  reset_string_builder(variable);
 
   // Where is everything after the last dot?
-  char *dot = strrchr(filename, '.');
-
-  // In some cases, we have no extension.
-  if (!dot || dot == filename) {
-    add_to_string(variable, "");
-  }
+  const char *dot = strrchr(filename, '.');
 
-  // Otherwise, add the extension (starting 1 character after the dot).
-  else {
-    add_to_string(variable, dot + 1);
+  // In some cases, we have no extension. Otherwise, add the
+  // extension (starting 1 character after the dot).
+  if (dot != NULL && dot != filename) {
+    append_to_builder(variable, dot + 1);
   }
 
 }
 
 /*
- *  Get the md5 hash of a file.
+ *  Get the hash of a file's contents, with the scan's
+ *  algorithm (md5 by default).
  *
- *  @param char *variable The variable to store the hash in.
- *  @param char *path The path to the file.
+ *  @param struct scan *scan The scan.
+ *  @param char *variable The variable to store the hex hash in.
+ *  @param struct file_content *content The file's contents,
+ *                                      or NULL if it couldn't be read.
  */
-void md5(char *variable, const char *path) {
-
-  // Make sure md5sum is installed on the system.
-  int status_code = system("which md5sum >/dev/null 2>&1");
-  if (status_code == 0) {
-
-    // Build a command to get the md5 sum for the file.
-
-    // Command length is the command, plus space plus path
-    // plus null terminator
-    char command[MAX_COMMAND_LENGTH + MAX_PATH_LENGTH + 2];
-    initialize_string(command);
-    add_to_string(command, "md5sum ");
-    add_to_string(command, path);
-
-    // Open a stream that runs the command.
-    FILE *stream = popen(command, "r");
-    if (stream != NULL) {
-
-      // Get the first 32 characters.
-      fgets(variable, 32, stream);
-
-      // Close the stream.
-      pclose(stream);
-
-    }
+void hash_content(const struct scan *scan, char *variable, const struct file_content *content) {
 
+  // Start with an empty hash, in case we couldn't read the file.
+  initialize_string(variable);
+  if (content == NULL) {
+    return;
   }
 
+  digest_to_hex(scan->algorithm, scan->digest_threads, content->data, content->length, variable);
+
 }
 
 /*
- *  Get the base64 encoded string of a file's contents.
+ *  Get the base64 encoded string of a file's contents,
+ *  and append it to a builder.
  *
- *  @param char *variable The variable to store the encoded string in.
- *  @param char *path The path to the file.
+ *  At most the scan's `max_filesize_to_base64_encode` bytes are encoded.
+ *
+ *  @param struct scan *scan The scan.
+ *  @param struct string_builder *variable The builder to append the encoded string to.
+ *  @param struct file_content *content The file's contents,
+ *                                      or NULL if it couldn't be read.
+ *  @return void
  */
-void base64(char *variable, const char *path) {
-
-  // Make sure base64 is installed on the system.
-  int status_code = system("which base64 >/dev/null 2>&1");
-  if (status_code == 0) {
-
-    // Build a command to get the base64 string of the file's contents.
-    // Command length is the command, plus space plus path
-    // plus null terminator
-    char command[MAX_COMMAND_LENGTH + MAX_PATH_LENGTH + 2];
-    initialize_string(command);
-    add_to_string(command, "base64 --wrap=0 ");
-    add_to_string(command, path);
-
-    // Open a stream that runs the command.
-    FILE *stream = popen(command, "r");
-    if (stream != NULL) {
-
-      // Read the response, character by character.
-      char character;
-      int i = 0;
-      while ((character = fgetc(stream)) != EOF) {
-        variable[i++] = character;
-      }
-
-      // Hard-terminate the string at the next character, because there
-      // might be all sorts of scary shit in the stream buffer
-      variable[i++] = '\0';
+void base64(const struct scan *scan, struct string_builder *variable, const struct file_content *content) {
 
-      // Close the stream.
-      pclose(stream);
+  if (content == NULL) {
+    return;
+  }
 
-    }
+  size_t length = content->length;
+  if (length > (size_t) scan->max_filesize_to_base64_encode) {
+    length = (size_t) scan->max_filesize_to_base64_encode;
+  }
 
+  // Encode the contents straight into the builder, if there's room.
+  if (BASE64_ENCODED_LENGTH(length) <= builder_room(variable)) {
+    extend_builder(variable, base64_encode(builder_end(variable), content->data, length));
+  } else {
+    variable->overflowed = 1;
   }
 
 }
@@ -281,149 +424,549 @@ void base64(char *variable, const char *path) {
  *  Create a cachebusted filename of the form: 
  *  key.hash.ending
  *
- *  @param char *var The variable to store the cachebusted filename in.
+ *  @param struct string_builder *var The builder to store the cachebusted filename in.
  *  @param char *key The key/name of the file.
  *  @param char *hash The hash to add to the filename. 
  *  @param char *ending The extension to add to the ending.
  */
-void cachebust_filename(char *var, const char *key, const char *hash, const char *ending) {
-    initialize_string(var);
-    add_to_string(var, key);
-    add_to_string(var, ".");
-    add_to_string(var, hash);
-    if (strlen(ending) > 0) {
-      add_to_string(var, ".");
-      add_to_string(var, ending);
+void cachebust_filename(struct string_builder *var, const char *key, const char *hash, const char *ending) {
+    reset_string_builder(var);
+    append_to_builder(var, key);
+    append_to_builder(var, ".");
+    append_to_builder(var, hash);
+    if (ending[0] != '\0') {
+      append_to_builder(var, ".");
+      append_to_builder(var, ending);
     }
 }
 
 /*
- *  Process a file and gather information about it.
+ *  Work out a file's type from its first bytes, without reading the rest.
  *
  *  @param char *path The path to the file.
- *  @param struct stat *info Info about the file returned by `stat()`.
- *  @return void
+ *  @param struct mime_type *known The type its extension says it is (or NULL).
+ *  @return char* The type, or NULL if it can't be read or nothing we know matches.
  */
-void process_file(char *path, struct stat *info) {
+static const char *sniff_file(const char *path, const struct mime_type *known) {
+  int descriptor = open(path, O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0) {
+    return NULL;
+  }
+  unsigned char head[MIME_SNIFF_LENGTH];
+  ssize_t length = pread(descriptor, head, sizeof(head), 0);
+  close(descriptor);
+  return length > 0 ? sniff_mime_type(head, (size_t) length, known) : NULL;
+}
+
+/*
+ *  Write a file's compressed siblings (`--precompress`), and add
+ *  the size and digest of each to its entry, like this:
+ *  "precompressed":{"gzip":{"size":1234,"md5":"..."}},
+ *  A variant that isn't worth keeping is left out (and any
+ *  sibling we wrote for an earlier version of the file is removed).
+ *
+ *  @param struct scan *scan The scan.
+ *  @param struct string_builder *entry The builder to append to.
+ *  @param struct file_content *content The file's contents.
+ *  @param char *path The path to the file (where it is now, if it was cachebusted).
+ *  @return int 1 if it worked, 0 if a sibling couldn't be written.
+ */
+static int add_siblings(const struct scan *scan, struct string_builder *entry,
+                        const struct file_content *content, const char *path) {
+
+  int listed = 0;
+  int variant;
+  for (variant = PRECOMPRESS_GZIP; variant <= PRECOMPRESS_ZSTD; variant <<= 1) {
+    if (!(scan->precompress & variant)) {
+      continue;
+    }
+
+    unsigned char *compressed;
+    size_t length = precompress_bytes(variant, content->data, content->length, &compressed);
+    if (length == 0) {
+      remove_sibling(path, variant);
+      continue;
+    }
+
+    // The digest is of the sibling's bytes, so it can be checked as served.
+    char digest[MAX_DIGEST_HEX_LENGTH + 1];
+    int written = write_sibling(path, variant, compressed, length);
+    if (written) {
+      digest_to_hex(scan->algorithm, scan->digest_threads, compressed, length, digest);
+    }
+    free(compressed);
+    if (!written) {
+      return 0;
+    }
+
+    char size[32];
+    snprintf(size, sizeof(size), "%zu", length);
+    append_to_builder(entry, listed ? ",\"" : "\"precompressed\":{\"");
+    append_to_builder(entry, precompress_name(variant));
+    append_to_builder(entry, "\":{\"size\":");
+    append_to_builder(entry, size);
+    append_to_builder(entry, ",\"");
+    append_to_builder(entry, digest_name(scan->algorithm));
+    append_to_builder(entry, "\":\"");
+    append_to_builder(entry, digest);
+    append_to_builder(entry, "\"}");
+    listed = 1;
+  }
+  if (listed) {
+    append_to_builder(entry, "},");
+  }
+  return 1;
+
+}
+
+/*
+ *  Gather information about a file, and build its entry and record.
+ *
+ *  @param struct scan *scan The scan.
+ *  @param struct string_builder *entry The builder to build the entry in
+ *                                      (`scan->entry_capacity` long).
+ *  @param struct record_buffers *buffers Where to keep the record's strings.
+ *  @param struct asset_record *record The record to fill in. Its strings point
+ *                                     into `entry`, `buffers` and `path`.
+ *  @param char *path The path to the file.
+ *  @param struct stat *info Info about the file returned by `stat()`,
+ *                           or NULL if `file_needs_info()` said we could skip it.
+ *  @return int 1 if it's built, 0 if the scan failed.
+ */
+int build_entry(struct scan *scan, struct string_builder *entry, struct record_buffers *buffers,
+                struct asset_record *record, char *path, struct stat *info) {
 
   // Get the filename from this path.
   char *filename = basename(path);
 
   // Get the extension for this file.
-  char file_extension[MAX_EXTENSION_LENGTH];
-  extension(file_extension, filename);
+  struct string_builder file_extension;
+  init_string_builder(&file_extension, buffers->extension, sizeof(buffers->extension));
+  extension(&file_extension, filename);
 
   // Get the filename without the extension.
-  char key[MAX_FILENAME_LENGTH];
-  filename_without_extension(key, filename);
+  struct string_builder key;
+  init_string_builder(&key, buffers->key, sizeof(buffers->key));
+  filename_without_extension(&key, filename);
 
   // Get the base path for this file.
-  char file_path[MAX_PATH_LENGTH];
-  base_path(file_path, path);
-
-  // Get the md5 of this file.
-  char hash[32];
-  md5(hash, path);
-
-  // Get the base64 encoded contents of this file,
-  // only when file type is gif,jpg,jpeg,png,svg
-  char base64_content[max_chars_in_base64_strings];
-  if (is_image(file_extension) == 1) {
-    initialize_string(base64_content);
-    if (info->st_size <= max_filesize_to_base64_encode) {
-      base64(base64_content, path);
+  struct string_builder file_path;
+  init_string_builder(&file_path, buffers->directory, sizeof(buffers->directory));
+  base_path(&file_path, path);
+
+  // Names that don't fit our buffers can't be handled.
+  if (file_extension.overflowed || key.overflowed || file_path.overflowed) {
+    fail_scan(scan, "This path is too long:", path);
+    return 0;
+  }
+
+  // What type of file is it? One lookup tells us its MIME
+  // type, and whether it's an image.
+  const struct mime_type *type = find_mime_type(file_extension.data);
+  const char *mime = type != NULL ? type->name : DEFAULT_MIME_TYPE;
+
+  // Do we want the base64 encoded contents of this file?
+  // Only when file type is gif,jpg,jpeg,png,svg and it's small enough.
+  // (If we weren't given `info`, the walk already knew we don't.)
+  int wants_base64 = info != NULL
+    && scan->base64_enabled
+    && type != NULL && (type->flags & MIME_IMAGE)
+    && info->st_size <= scan->max_filesize_to_base64_encode;
+
+  // Do we want compressed siblings of it? Not if it's compressed already.
+  int wants_siblings = scan->precompress && !(type != NULL && (type->flags & MIME_COMPRESSED));
+
+  // Is this file in the cache, unchanged since the last run?
+  // A cached entry is only good if it has everything we need
+  // (and siblings and integrity values are made from the bytes,
+  // so they need a read).
+  struct cache_hit cached;
+  int is_cached = info != NULL && scan->use_cache && !wants_siblings && !scan->sri
+    && cache_lookup(info, &cached);
+  if (is_cached && wants_base64) {
+    if (!cached.has_base64 || cached.base64_length != BASE64_ENCODED_LENGTH((size_t) info->st_size)) {
+      is_cached = 0;
+    }
+  }
+
+  // If it isn't, read it once: the same bytes are hashed
+  // and (if need be) base64 encoded.
+  struct file_content content;
+  const struct file_content *readable = NULL;
+  if (!is_cached) {
+    uint64_t started = start_timer();
+    if (load_file_content(&content, path, !scan->never_map)) {
+      readable = &content;
+    }
+    stop_timer(PHASE_READ, started);
+  }
+
+  // With `--sniff`, the file's first bytes say what type it is
+  // (if they match a signature we know), whatever its extension.
+  if (scan->sniff) {
+    const char *sniffed = readable != NULL
+      ? sniff_mime_type(readable->data, readable->length, type)
+      : sniff_file(path, type);
+    if (sniffed != NULL) {
+      mime = sniffed;
     }
   }
 
+  // With `--dimensions`, an image's header says how big it is
+  // (read from the bytes we have, or else just the header).
+  struct image_dimensions dimensions;
+  int has_dimensions = 0;
+  if (scan->dimensions && strncmp(mime, "image/", 6) == 0) {
+    if (readable != NULL) {
+      has_dimensions = image_dimensions(readable->data, readable->length, &dimensions);
+    } else {
+      uint64_t started = start_timer();
+      has_dimensions = file_image_dimensions(path, &dimensions);
+      stop_timer(PHASE_READ, started);
+    }
+  }
+
+  // Get the hash of this file. With `--sri`, the integrity value's
+  // digests are computed too, in the same pass over the bytes
+  // (the hash as well, if it can be fed a piece at a time).
+  char *hash = buffers->digest;
+  char integrity[MAX_SRI_LENGTH + 1];
+  int has_integrity = scan->sri && readable != NULL;
+  if (is_cached) {
+    memcpy(hash, cached.hash, sizeof(buffers->digest));
+    count(COUNT_CACHE_HITS, 1);
+  } else if (has_integrity && sri_shares_pass(scan->algorithm)) {
+    uint64_t started = start_timer();
+    sri_integrity(scan->sri, readable->data, readable->length, integrity, scan->algorithm, hash);
+    stop_timer(PHASE_HASH, started);
+  } else {
+    uint64_t started = start_timer();
+    hash_content(scan, hash, readable);
+    if (has_integrity) {
+      sri_integrity(scan->sri, readable->data, readable->length, integrity, -1, NULL);
+    }
+    stop_timer(PHASE_HASH, started);
+  }
+
   // We'll store the cachebusted filename here:
-  char cachebusted_filename[MAX_FILENAME_LENGTH];
+  struct string_builder cachebusted_filename;
+  init_string_builder(&cachebusted_filename, buffers->filename, sizeof(buffers->filename));
+
+  // And the path to it here (it's where the file is from then on):
+  char new_path_buffer[MAX_PATH_LENGTH];
+  struct string_builder new_path;
+  init_string_builder(&new_path, new_path_buffer, sizeof(new_path_buffer));
 
   // Are we going to cache bust the filename? 
-  if (cachebust) {
+  if (scan->cachebust) {
 
     // Construct the cache busted filename.
-    cachebust_filename(cachebusted_filename, key, hash, file_extension);
+    cachebust_filename(&cachebusted_filename, key.data, hash, file_extension.data);
 
     // Construct a full path to the new cache-busted filename
-    char new_path[MAX_PATH_LENGTH];
-    initialize_string(new_path);
-    add_to_string(new_path, file_path);
-    add_to_string(new_path, cachebusted_filename);
+    append_bytes_to_builder(&new_path, file_path.data, file_path.length);
+    append_bytes_to_builder(&new_path, cachebusted_filename.data, cachebusted_filename.length);
 
     // Rename the file.
-    int rename_success;
-    rename_success = rename(path, new_path);
+    int rename_success = -1;
+    if (!cachebusted_filename.overflowed && !new_path.overflowed) {
+      uint64_t started = start_timer();
+      rename_success = rename(path, new_path.data);
+      stop_timer(PHASE_RENAME, started);
+    }
     if (rename_success != 0) {
-      puts("Could not rename this file:");
-      printf("%s\n", filename);
-      exit(1);
+      if (readable != NULL) {
+        release_file_content(&content);
+      }
+      fail_scan(scan, "Could not rename this file:", filename);
+      return 0;
     }
 
   }
 
   // Start building the entry for this file.
-  char entry[max_entry_length];
-  initialize_string(entry);
-  add_to_string(entry, "{");
+  append_to_builder(entry, "{");
 
   // Add the key.
-  add_to_string(entry, "\"key\":\"");
-  add_to_string(entry, key);
-  add_to_string(entry, "\",");
+  append_to_builder(entry, "\"key\":\"");
+  append_bytes_to_builder(entry, key.data, key.length);
+  append_to_builder(entry, "\",");
 
   // Add the directory.
-  add_to_string(entry, "\"directory\":\"");
-  add_to_string(entry, file_path);
-  add_to_string(entry, "\",");
+  append_to_builder(entry, "\"directory\":\"");
+  append_bytes_to_builder(entry, file_path.data, file_path.length);
+  append_to_builder(entry, "\",");
 
   // Add the filename.
-  add_to_string(entry, "\"filename\":\"");
-  if (cachebust) {
-    add_to_string(entry, cachebusted_filename);
+  append_to_builder(entry, "\"filename\":\"");
+  if (scan->cachebust) {
+    append_bytes_to_builder(entry, cachebusted_filename.data, cachebusted_filename.length);
   } else {
-    add_to_string(entry, filename);
+    append_to_builder(entry, filename);
   }
-  add_to_string(entry, "\",");
+  append_to_builder(entry, "\",");
 
   // Add the extension.
-  add_to_string(entry, "\"extension\":\"");
-  add_to_string(entry, file_extension);
-  add_to_string(entry, "\",");
-
-  // Add the base64 content,
-  // only when file type is gif,jpg,jpeg,png,svg
-  if (is_image(file_extension) == 1) {
-    if (info->st_size <= max_filesize_to_base64_encode) {
-      add_to_string(entry, "\"base64\":\"");
-      add_to_string(entry, base64_content);
-      add_to_string(entry, "\",");
+  append_to_builder(entry, "\"extension\":\"");
+  append_bytes_to_builder(entry, file_extension.data, file_extension.length);
+  append_to_builder(entry, "\",");
+
+  // Add the MIME type.
+  append_to_builder(entry, "\"mime\":\"");
+  append_to_builder(entry, mime);
+  append_to_builder(entry, "\",");
+
+  // Add the width and height.
+  if (has_dimensions) {
+    char size[DIMENSIONS_ENTRY_LENGTH];
+    snprintf(size, sizeof(size), "\"width\":%u,\"height\":%u,",
+             (unsigned int) dimensions.width, (unsigned int) dimensions.height);
+    append_to_builder(entry, size);
+  }
+
+  // Add the base64 content, encoded straight into the entry
+  // (or copied from the cache).
+  char *base64_content = NULL;
+  size_t base64_length = 0;
+  if (wants_base64) {
+    append_to_builder(entry, "\"base64\":\"");
+    size_t base64_start = entry->length;
+    if (is_cached) {
+      append_bytes_to_builder(entry, cached.base64, cached.base64_length);
+    } else {
+      uint64_t started = start_timer();
+      base64(scan, entry, readable);
+      stop_timer(PHASE_BASE64, started);
     }
+    base64_content = entry->data + base64_start;
+    base64_length = entry->length - base64_start;
+    append_to_builder(entry, "\",");
   }
 
-  // Add the md5.
-  add_to_string(entry, "\"md5\":\"");
-  add_to_string(entry, hash);
-  add_to_string(entry, "\"");
+  // Write its compressed siblings, from the same bytes.
+  if (wants_siblings && readable != NULL) {
+    uint64_t started = start_timer();
+    int written = add_siblings(scan, entry, readable, scan->cachebust ? new_path.data : path);
+    stop_timer(PHASE_PRECOMPRESS, started);
+    if (!written) {
+      release_file_content(&content);
+      fail_scan(scan, "Could not write a compressed copy of this file:", path);
+      return 0;
+    }
+  }
+
+  // Add the integrity value (worked out with the hash).
+  if (has_integrity) {
+    append_to_builder(entry, "\"integrity\":\"");
+    append_to_builder(entry, integrity);
+    append_to_builder(entry, "\",");
+  }
+
+  // That's everything that needs the file's contents. Note
+  // its size, if we didn't already know it.
+  int64_t size = info != NULL ? (int64_t) info->st_size : -1;
+  if (readable != NULL) {
+    size = (int64_t) content.length;
+    release_file_content(&content);
+  }
+
+  // Add the hash, under the name of its algorithm.
+  append_to_builder(entry, "\"");
+  append_to_builder(entry, digest_name(scan->algorithm));
+  append_to_builder(entry, "\":\"");
+  append_to_builder(entry, hash);
+  append_to_builder(entry, "\"");
 
   // Finish building the entry.
-  add_to_string(entry, "}");
+  append_to_builder(entry, "}");
+
+  // If anything didn't fit, the entry is broken.
+  if (entry->overflowed) {
+    fail_scan(scan, "The entry for this file is too long:", path);
+    return 0;
+  }
+
+  // Remember what we found for the next run (but not if the file
+  // couldn't be read: its hash is empty, and making it readable
+  // again doesn't change its modification time).
+  if (info != NULL && scan->use_cache && (is_cached || readable != NULL)) {
+    cache_remember(info, hash, base64_content, base64_length, wants_base64);
+  }
 
-  // Now log it.
-  put_to_log(entry);
+  // The same information, field by field.
+  record->path = path;
+  record->key = key.data;
+  record->directory = file_path.data;
+  record->filename = scan->cachebust ? cachebusted_filename.data : filename;
+  record->extension = file_extension.data;
+  record->mime = mime;
+  record->algorithm = digest_name(scan->algorithm);
+  record->digest = hash;
+  record->base64 = base64_content;
+  record->base64_length = base64_length;
+  record->size = size;
+  record->width = has_dimensions ? dimensions.width : 0;
+  record->height = has_dimensions ? dimensions.height : 0;
+  record->entry = entry->data;
+  return 1;
 
 }
 
 /*
- *  Walk a directory tree.
+ *  Hand a finished record to the scan's record handler.
  *
- *  @char *path The folder to walk.
- *  @char *blacklist A comma separated list of files to ignore.
+ *  @param struct scan *scan The scan.
+ *  @param struct asset_record *record The record.
  *  @return void
  */
-void walk(char *path, const char *blacklist) {
+void emit_record(struct scan *scan, const struct asset_record *record) {
+  if (scan->record_handler != NULL) {
+    scan->record_handler(record, scan->context);
+  }
+  count(COUNT_FILES, 1);
+}
+
+/*
+ *  Process a file: build its entry, and emit it.
+ *
+ *  @param struct scan *scan The scan.
+ *  @param char *path The path to the file.
+ *  @param struct stat *info Info about the file returned by `stat()`,
+ *                           or NULL if `file_needs_info()` said we could skip it.
+ *  @return void
+ */
+void process_file(struct scan *scan, char *path, struct stat *info) {
+  if (scan_failed(scan)) {
+    return;
+  }
+  char entry_buffer[scan->entry_capacity];
+  struct string_builder entry;
+  init_string_builder(&entry, entry_buffer, scan->entry_capacity);
+  struct record_buffers buffers;
+  struct asset_record record;
+  if (build_entry(scan, &entry, &buffers, &record, path, info)) {
+    emit_record(scan, &record);
+  }
+}
+
+/*
+ *  Does processing this file need its `stat()` info (size, mtime, etc.)?
+ *  If not, the walk can go by the directory entry's type alone.
+ *
+ *  @param struct scan *scan The scan.
+ *  @param char *filename The name of the file.
+ *  @return int 1 if yes, 0 if no.
+ */
+int file_needs_info(const struct scan *scan, const char *filename) {
+
+  // The cache is keyed by (and checked against) the stat info.
+  if (scan->use_cache) {
+    return 1;
+  }
+
+  // Base64 encoding depends on the file's size.
+  if (scan->base64_enabled) {
+    char extension_buffer[MAX_EXTENSION_LENGTH];
+    struct string_builder file_extension;
+    init_string_builder(&file_extension, extension_buffer, sizeof(extension_buffer));
+    extension(&file_extension, filename);
+    if (is_image(file_extension.data) == 1) {
+      return 1;
+    }
+  }
+
+  return 0;
+
+}
+
+/*
+ *  Get the `stat()` info of an item in a directory we're reading.
+ *
+ *  @param struct scan *scan The scan.
+ *  @param int descriptor An open descriptor for the directory.
+ *  @param char *name The name of the item.
+ *  @param char *path The full path to the item (for the error).
+ *  @param struct stat *info Where to store the info.
+ *  @return int 1 if we got it, 0 if not (and the scan failed).
+ */
+static int stat_item(struct scan *scan, int descriptor, const char *name, const char *path, struct stat *info) {
+
+  // `fstatat()` returns `0` on success, so reverse it to get a boolean.
+  uint64_t started = start_timer();
+  int success = !fstatat(descriptor, name, info, 0);
+  stop_timer(PHASE_STAT, started);
+
+  // If we didn't get any information about the file,
+  // print a message saying so.
+  if (!success) {
+    fail_scan(scan, "Could not get any information on this file:", path);
+  }
+  return success;
+
+}
+
+/*
+ *  Deal with a directory found during the walk: look in it
+ *  now, or hand it to the workers if we're running `--jobs`.
+ *
+ *  @param struct scan *scan The scan.
+ *  @param int parent An open descriptor for the directory it's in.
+ *  @param char *name The name of the directory.
+ *  @param char *path The full path to the directory.
+ *  @return void
+ */
+static void found_directory(struct scan *scan, int parent, const char *name, char *path) {
+  if (scan->jobs != NULL) {
+    submit_job(scan->jobs, JOB_DIRECTORY, path, NULL);
+  } else {
+    walk_directory_at(scan, parent, name, path);
+  }
+}
+
+/*
+ *  Deal with a file found during the walk: process it now, or
+ *  hand it to the workers if we're running `--jobs` or `--pipeline`.
+ *
+ *  @param struct scan *scan The scan.
+ *  @param char *path The path to the file.
+ *  @param struct stat *info Info about the file returned by `stat()` (or NULL).
+ *  @return void
+ */
+static void found_file(struct scan *scan, char *path, struct stat *info) {
+  if (scan->jobs != NULL) {
+    submit_job(scan->jobs, JOB_FILE, path, info);
+  } else if (scan->pipeline != NULL) {
+    submit_to_pipeline(scan->pipeline, path, info);
+  } else {
+    process_file(scan, path, info);
+  }
+}
+
+/*
+ *  Read one directory, and deal with each item in it.
+ *
+ *  The directory is opened relative to its parent's descriptor,
+ *  and items are `fstatat()`ed relative to this one, so the kernel
+ *  never has to resolve a full path. Items are only stat'ed at all
+ *  when `readdir()` can't tell us their type (or they're symlinks),
+ *  or when processing needs their size/mtime.
+ *
+ *  @param struct scan *scan The scan.
+ *  @param int parent An open descriptor for the directory it's in
+ *                    (or AT_FDCWD if `name` is a full path).
+ *  @param char *name The name of the folder, relative to `parent`.
+ *  @param char *path The full path to the folder.
+ *  @return void
+ */
+void walk_directory_at(struct scan *scan, int parent, const char *name, const char *path) {
+
+  // Once something has gone wrong, there's no point going on.
+  if (scan_failed(scan)) {
+    return;
+  }
 
   // When we open a stream to the path, we'll store it here:
-  DIR *stream;
+  DIR *stream = NULL;
 
   // When we read a list of items from the directory, 
   // we'll store each item here:
@@ -433,68 +976,139 @@ void walk(char *path, const char *blacklist) {
   // it returns here:
   struct stat info;
 
-  // Open a stream to the path/directory.
-  stream = opendir(path);
+  // Open a stream to the path/directory. Opening and reading
+  // the directory count as the walk; `fstatat()` has its own phase.
+  uint64_t started = start_timer();
+  int descriptor = openat(parent, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (descriptor >= 0) {
+    stream = fdopendir(descriptor);
+    if (stream == NULL) {
+      close(descriptor);
+    }
+  }
+
+  stop_timer(PHASE_WALK, started);
 
   // Did we get a valid stream? 
   if (stream != NULL) {
 
-    // Read the stream one item at a time.
-    while ((item = readdir(stream))) {
-
-      // If the item is not in the blacklist, we can proceed.
-      if (!string_is_in_list(blacklist, item->d_name)) {
+    count(COUNT_DIRECTORIES, 1);
+    if (scan->directory_handler != NULL) {
+      scan->directory_handler(path, scan->context);
+    }
 
-        // Construct the path to this file/folder item.
-        char full_path[MAX_PATH_LENGTH];
-        build_path(full_path, path, item->d_name);
+    // Read the stream one item at a time.
+    while (!scan_failed(scan)) {
 
-        // Try to get some info on this item.
-        int got_info = stat(full_path, &info);
+      started = start_timer();
+      item = readdir(stream);
+      stop_timer(PHASE_WALK, started);
+      if (item == NULL) {
+        break;
+      }
 
-        // If got_info is 0, that means we got information about the file.
-        // I know, it's weird, but in C, `stat()` returns a status code, 
-        // not a boolean. So `0` = success, and `1` = fail. To make it
-        // a boolean, let's reverse it's value.
-        int success = !got_info;
+      // Every folder has these.
+      if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0) {
+        continue;
+      }
 
-        // Now we can check if we were successful in a truthy sort of way.
-        if (success) {
+      // Construct the path to this file/folder item.
+      char full_path_buffer[MAX_PATH_LENGTH];
+      struct string_builder full_path;
+      init_string_builder(&full_path, full_path_buffer, sizeof(full_path_buffer));
+      if (!build_path(&full_path, path, item->d_name)) {
+        char too_long[MAX_PATH_LENGTH + MAX_FILENAME_LENGTH + 2];
+        snprintf(too_long, sizeof(too_long), "%s/%s", path, item->d_name);
+        fail_scan(scan, "This path is too long:", too_long);
+        break;
+      }
 
-          // Is it a directory? If so, look in it (recursively).
-          if (is_dir(&info)) {
-            walk(full_path, blacklist);
-          }
+      // The directory entry usually tells us what the item is.
+      // If it doesn't, or it's a symlink (which we follow),
+      // we have to ask `fstatat()`.
+      // (Unless it's ignored either way: then we needn't know.)
+      int type = item->d_type;
+      int have_info = 0;
+      if ((type == DT_UNKNOWN || type == DT_LNK)
+          && path_is_ignored(scan, full_path.data, 0) && path_is_ignored(scan, full_path.data, 1)) {
+        count(COUNT_SKIPPED, 1);
+        continue;
+      }
+      if (type == DT_UNKNOWN || type == DT_LNK) {
+        if (!stat_item(scan, descriptor, item->d_name, full_path.data, &info)) {
+          break;
+        }
+        have_info = 1;
+        type = is_dir(&info) ? DT_DIR : is_file(&info) ? DT_REG : DT_UNKNOWN;
+      }
 
-          // Is it a file? If so, process it.
-          else if (is_file(&info)) {
-            process_file(full_path, &info);
-          }
+      // Skip what we're ignoring (and, for a folder,
+      // everything in it), and note that we did.
+      if (path_is_ignored(scan, full_path.data, type == DT_DIR)) {
+        count(COUNT_SKIPPED, 1);
+        continue;
+      }
 
+      // Processing some files needs their size or mtime.
+      if (type == DT_REG && !have_info && file_needs_info(scan, item->d_name)) {
+        if (!stat_item(scan, descriptor, item->d_name, full_path.data, &info)) {
+          break;
         }
+        have_info = 1;
+      }
 
-        // If we didn't get any information about the file,
-        // print a message saying so.
-        else {
-          puts("Could not get any information on this file:");
-          printf("%s\n", full_path);
-          exit(1);
-        }
+      // Is it a directory? If so, look in it (recursively).
+      if (type == DT_DIR) {
+        found_directory(scan, descriptor, item->d_name, full_path.data);
+      }
 
+      // Is it a file? If so, process it.
+      else if (type == DT_REG) {
+        found_file(scan, full_path.data, have_info ? &info : NULL);
       }
 
     }
 
-    // Close the stream to the directory.
-    //(void) closedir(stream);
+    // Close the stream (and its descriptor). With `--jobs` there
+    // can be many directories in flight, so don't leak these.
+    (void) closedir(stream);
 
   }
 
-  // If we couldn't open the directory, exit with a message.
+  // If we couldn't open the directory, that's the end of the scan.
   else {
-    puts("Could not open the following path:");
-    printf("%s\n", path);
-    exit(1);
+    fail_scan(scan, "Could not open the following path:", path);
   }
 
 }
+
+/*
+ *  Read one directory (by its full path), and deal with each item in it.
+ *
+ *  @struct scan *scan The scan.
+ *  @char *path The folder to read.
+ *  @return void
+ */
+void walk_directory(struct scan *scan, const char *path) {
+  walk_directory_at(scan, AT_FDCWD, path, path);
+}
+
+/*
+ *  Walk a directory tree, on one thread or (with `--jobs`) several,
+ *  or (with `--pipeline`) on one thread that feeds several others.
+ *
+ *  @struct scan *scan The scan.
+ *  @char *path The folder to walk.
+ *  @return void
+ */
+void walk(struct scan *scan, const char *path) {
+  scan->root = path;
+  scan->root_length = strlen(path);
+  if (scan->number_of_jobs > 1) {
+    run_jobs(scan, path);
+  } else if (scan->pipeline_workers > 0) {
+    run_pipeline(scan, path);
+  } else {
+    walk_directory(scan, path);
+  }
+}
@@ -16,6 +16,33 @@
 #ifndef PROCESSING_H
 #define PROCESSING_H
 
+// For `struct ignore_set`.
+#include "ignore.h"
+
+// For `struct string_builder`.
+#include "string_builder.h"
+
+// For `struct file_content`.
+#include "content.h"
+
+// For `struct asset_record`.
+#include "record.h"
+
+// For MAX_DIGEST_HEX_LENGTH.
+#include "digest.h"
+
+// For `struct assets_options`.
+#include "libassets.h"
+
+// For `struct stat`.
+#include <sys/stat.h>
+
+// For the scan's error lock.
+#include <pthread.h>
+
+// For the scan's failure flag.
+#include <stdatomic.h>
+
 
 /*  ------------------------------------------------------------
  *
@@ -24,9 +51,78 @@
  *  ------------------------------------------------------------
  */
 #define MAX_PATH_LENGTH 1024
-#define MAX_EXTENSION_LENGTH 32
-#define MAX_FILENAME_LENGTH 100
-#define MAX_COMMAND_LENGTH 1024
+#define MAX_EXTENSION_LENGTH 256
+#define MAX_FILENAME_LENGTH 256
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The worker threads of a `--jobs` walk (see jobs.c).
+struct job_pool;
+
+// The threads of a `--pipeline` walk (see pipeline.c).
+struct pipeline;
+
+// One walk over a tree: its settings, and what the threads
+// working on it share. None of it is global, so several scans
+// can run in one process at once.
+struct scan {
+  int cachebust;
+  int base64_enabled;
+  int max_filesize_to_base64_encode;
+  size_t entry_capacity;
+  int algorithm;
+  int digest_threads;
+  int number_of_jobs;
+  int pipeline_workers;
+  int sniff;
+  int dimensions;
+  int precompress;
+  int sri;
+  int use_cache;
+
+  // Read files, never map them: a mapped file that's truncated
+  // (as editors and build tools do while `--watch` runs) raises
+  // SIGBUS when its missing pages are touched.
+  int never_map;
+
+  // The patterns to skip, and the top of the walk they're matched from.
+  struct ignore_set ignored;
+  const char *root;
+  size_t root_length;
+
+  // Who gets each finished record, and who hears about
+  // each directory the walk opens (NULL for nobody).
+  void (*record_handler)(const struct asset_record *record, void *context);
+  void (*directory_handler)(const char *path, void *context);
+  void *context;
+
+  // The workers, while a `--jobs` walk is running.
+  struct job_pool *jobs;
+
+  // The pipeline, while a `--pipeline` walk is running.
+  struct pipeline *pipeline;
+
+  // The first thing that went wrong. Once it's set,
+  // the walk winds down without doing any more work.
+  atomic_int failed;
+  pthread_mutex_t error_lock;
+  char error[ASSETS_ERROR_LENGTH];
+};
+
+// Room for the strings of a record while it's being built.
+struct record_buffers {
+  char key[MAX_FILENAME_LENGTH];
+  char directory[MAX_PATH_LENGTH];
+  char filename[MAX_FILENAME_LENGTH];
+  char extension[MAX_EXTENSION_LENGTH];
+  char digest[MAX_DIGEST_HEX_LENGTH + 1];
+};
 
 
 /*  ------------------------------------------------------------
@@ -37,17 +133,26 @@
  *  ------------------------------------------------------------
  */
 
-void set_max_entry_length(int size);
-void set_cachebust(int flag);
-void set_max_filesize_to_base64_encode(int size);
-void base_path(char *variable, const char *full_path);
-void filename_without_extension(char *variable, const char *filename);
-void extension(char *variable, const char *filename);
-void md5(char *variable, const char *path);
-void base64(char *variable, const char *path);
-void cachebust_filename(char *var, const char *key, const char *hash, const char *ending);
-void process_file(char *path, struct stat *info);
-void walk(char *path, const char *blacklist);
+int init_scan(struct scan *scan, const struct assets_options *options, char *error, size_t error_length);
+void free_scan(struct scan *scan);
+void fail_scan(struct scan *scan, const char *message, const char *path);
+int scan_failed(struct scan *scan);
+void clear_scan_failure(struct scan *scan);
+int path_is_ignored(const struct scan *scan, const char *path, int is_directory);
+void base_path(struct string_builder *variable, const char *full_path);
+void filename_without_extension(struct string_builder *variable, const char *filename);
+void extension(struct string_builder *variable, const char *filename);
+void hash_content(const struct scan *scan, char *variable, const struct file_content *content);
+void base64(const struct scan *scan, struct string_builder *variable, const struct file_content *content);
+void cachebust_filename(struct string_builder *var, const char *key, const char *hash, const char *ending);
+int build_entry(struct scan *scan, struct string_builder *entry, struct record_buffers *buffers,
+                struct asset_record *record, char *path, struct stat *info);
+void emit_record(struct scan *scan, const struct asset_record *record);
+void process_file(struct scan *scan, char *path, struct stat *info);
+int file_needs_info(const struct scan *scan, const char *filename);
+void walk_directory_at(struct scan *scan, int parent, const char *name, const char *path);
+void walk_directory(struct scan *scan, const char *path);
+void walk(struct scan *scan, const char *path);
 
 
 #endif
@@ -0,0 +1,256 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides utilities for the records we
+ *    make of each file.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `strlen()`.
+#include <string.h>
+
+// We need the header that declares the prototypes for this file.
+#include "record.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in record.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Find how long each of a record's strings is.
+ *
+ *  @param struct asset_record *record The record.
+ *  @param char *strings[] Where to put its strings (RECORD_STRINGS of them).
+ *  @param size_t lengths[] Where to put their lengths (0 for NULL).
+ *  @return size_t How big a copy of the record is, all in one block.
+ */
+static size_t measure_record(const struct asset_record *record, const char *strings[], size_t lengths[]) {
+
+  strings[0] = record->path;
+  strings[1] = record->key;
+  strings[2] = record->directory;
+  strings[3] = record->filename;
+  strings[4] = record->extension;
+  strings[5] = record->mime;
+  strings[6] = record->algorithm;
+  strings[7] = record->digest;
+  strings[8] = record->entry;
+
+  size_t total = sizeof(struct asset_record) + record->base64_length + 1;
+  size_t i;
+  for (i = 0; i < RECORD_STRINGS; i++) {
+    lengths[i] = strings[i] != NULL ? strlen(strings[i]) : 0;
+    total += lengths[i] + 1;
+  }
+  return total;
+
+}
+
+/*
+ *  How much memory does a copy of a record take?
+ *
+ *  @param struct asset_record *record The record.
+ *  @return size_t The size of its copy (see `copy_record()`).
+ */
+size_t record_length(const struct asset_record *record) {
+  const char *strings[RECORD_STRINGS];
+  size_t lengths[RECORD_STRINGS];
+  return measure_record(record, strings, lengths);
+}
+
+/*
+ *  Point a copy's strings at the strings that follow it in its block.
+ *
+ *  @param struct asset_record *copy The copy (its other fields already set).
+ *  @param char *strings[] The strings to copy in (NULL stays NULL), or
+ *                         NULL if they're already in place.
+ *  @param size_t lengths[] Their lengths.
+ *  @param uint32_t present Which strings aren't NULL (bit 9 is the base64).
+ *  @return void
+ */
+static void place_strings(struct asset_record *copy, const char *strings[], const size_t lengths[], uint32_t present) {
+  const char **fields[RECORD_STRINGS] = {
+    &copy->path, &copy->key, &copy->directory, &copy->filename,
+    &copy->extension, &copy->mime, &copy->algorithm, &copy->digest, &copy->entry
+  };
+  char *cursor = (char *) (copy + 1);
+  size_t i;
+  for (i = 0; i <= RECORD_STRINGS; i++) {
+    const char **field = i < RECORD_STRINGS ? fields[i] : &copy->base64;
+    size_t length = i < RECORD_STRINGS ? lengths[i] : copy->base64_length;
+    if (!(present & (1u << i))) {
+      *field = NULL;
+      continue;
+    }
+    if (strings != NULL) {
+      memcpy(cursor, i < RECORD_STRINGS ? strings[i] : copy->base64, length);
+    }
+    cursor[length] = '\0';
+    *field = cursor;
+    cursor += length + 1;
+  }
+}
+
+/*
+ *  Which of a record's strings aren't NULL, as bits (bit 9 is the base64).
+ *
+ *  @param struct asset_record *record The record.
+ *  @param char *strings[] Its strings, from `measure_record()`.
+ *  @return uint32_t The bits.
+ */
+static uint32_t present_strings(const struct asset_record *record, const char *strings[]) {
+  uint32_t present = record->base64 != NULL ? 1u << RECORD_STRINGS : 0;
+  size_t i;
+  for (i = 0; i < RECORD_STRINGS; i++) {
+    if (strings[i] != NULL) {
+      present |= 1u << i;
+    }
+  }
+  return present;
+}
+
+/*
+ *  Copy a record (and all of its strings) into one block of
+ *  memory, so it can be kept after the file is done with.
+ *
+ *  @param struct asset_record *record The record.
+ *  @return struct asset_record* The copy (free it with `free()`).
+ */
+struct asset_record *copy_record(const struct asset_record *record) {
+
+  const char *strings[RECORD_STRINGS];
+  size_t lengths[RECORD_STRINGS];
+  size_t total = measure_record(record, strings, lengths);
+
+  struct asset_record *copy = malloc(total);
+  if (copy == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+
+  *copy = *record;
+  place_strings(copy, strings, lengths, present_strings(record, strings));
+  return copy;
+
+}
+
+/*
+ *  Write a record (and all of its strings) to a file,
+ *  so `read_record()` can read it back.
+ *
+ *  @param FILE *file The file.
+ *  @param struct asset_record *record The record.
+ *  @return int 1 if it was written, 0 if not.
+ */
+int write_record(FILE *file, const struct asset_record *record) {
+
+  const char *strings[RECORD_STRINGS];
+  size_t lengths[RECORD_STRINGS];
+  measure_record(record, strings, lengths);
+
+  struct stored_record stored;
+  memset(&stored, 0, sizeof(stored));
+  stored.present = present_strings(record, strings);
+  stored.base64_length = record->base64_length;
+  stored.size = record->size;
+  stored.width = record->width;
+  stored.height = record->height;
+  size_t i;
+  for (i = 0; i < RECORD_STRINGS; i++) {
+    stored.lengths[i] = lengths[i];
+  }
+
+  if (fwrite(&stored, sizeof(stored), 1, file) != 1) {
+    return 0;
+  }
+  for (i = 0; i < RECORD_STRINGS; i++) {
+    if (lengths[i] > 0 && fwrite(strings[i], lengths[i], 1, file) != 1) {
+      return 0;
+    }
+  }
+  if (record->base64_length > 0 && fwrite(record->base64, record->base64_length, 1, file) != 1) {
+    return 0;
+  }
+  return 1;
+
+}
+
+/*
+ *  Read a record written by `write_record()`.
+ *
+ *  @param FILE *file The file.
+ *  @return struct asset_record* The record, in one block (free it with
+ *                               `free()`), or NULL at the end of the file
+ *                               or if it can't be read (see `ferror()`).
+ */
+struct asset_record *read_record(FILE *file) {
+
+  struct stored_record stored;
+  if (fread(&stored, sizeof(stored), 1, file) != 1) {
+    return NULL;
+  }
+
+  size_t lengths[RECORD_STRINGS];
+  size_t total = sizeof(struct asset_record) + stored.base64_length + 1;
+  size_t i;
+  for (i = 0; i < RECORD_STRINGS; i++) {
+    lengths[i] = stored.lengths[i];
+    total += lengths[i] + 1;
+  }
+
+  struct asset_record *copy = malloc(total);
+  if (copy == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  memset(copy, 0, sizeof(struct asset_record));
+  copy->base64_length = stored.base64_length;
+  copy->size = stored.size;
+  copy->width = stored.width;
+  copy->height = stored.height;
+
+  // The strings are stored one after another, without their
+  // terminators: read each into place, then terminate them all.
+  char *cursor = (char *) (copy + 1);
+  for (i = 0; i <= RECORD_STRINGS; i++) {
+    size_t length = i < RECORD_STRINGS ? lengths[i] : copy->base64_length;
+    if (!(stored.present & (1u << i))) {
+      continue;
+    }
+    if (length > 0 && fread(cursor, length, 1, file) != 1) {
+      free(copy);
+      return NULL;
+    }
+    cursor += length + 1;
+  }
+  place_strings(copy, NULL, lengths, stored.present);
+  return copy;
+
+}
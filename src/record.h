@@ -0,0 +1,94 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for record.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef RECORD_H
+#define RECORD_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For fixed width integers, e.g., `int64_t`.
+#include <stdint.h>
+
+// For `FILE`.
+#include <stdio.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// How many strings a record has, not counting the base64.
+#define RECORD_STRINGS 9
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// What we found out about one file, field by field. The JSON
+// entry for the file is `entry`. The base64 string (NULL if
+// there isn't one) is not NUL-terminated: use `base64_length`.
+// `size` is -1 if we never needed to look at the file.
+// `width` and `height` are 0 unless `--dimensions` found them.
+struct asset_record {
+  const char *path;
+  const char *key;
+  const char *directory;
+  const char *filename;
+  const char *extension;
+  const char *mime;
+  const char *algorithm;
+  const char *digest;
+  const char *base64;
+  size_t base64_length;
+  int64_t size;
+  uint32_t width;
+  uint32_t height;
+  const char *entry;
+};
+
+// What `write_record()` writes before a record's strings: which of
+// them there are (bit 9 is the base64), and how long each one is.
+struct stored_record {
+  uint32_t present;
+  uint32_t lengths[RECORD_STRINGS];
+  uint64_t base64_length;
+  int64_t size;
+  uint32_t width;
+  uint32_t height;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in record.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+size_t record_length(const struct asset_record *record);
+struct asset_record *copy_record(const struct asset_record *record);
+int write_record(FILE *file, const struct asset_record *record);
+struct asset_record *read_record(FILE *file);
+
+#endif
@@ -0,0 +1,238 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides a streaming sha256 implementation
+ *    (FIPS 180-4).
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// For working with memory, e.g., `memcpy()`.
+#include <string.h>
+
+// We need the header that declares the prototypes for this file.
+#include "sha256.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// Rotate a 32 bit word right.
+#define SHA256_ROTATE(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+// The round constants: the first 32 bits of the fractional
+// parts of the cube roots of the first 64 primes.
+static const uint32_t sha256_constants[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in sha256.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Read a big-endian 32 bit word.
+ *
+ *  @param unsigned char *bytes The 4 bytes to read.
+ *  @return uint32_t The word.
+ */
+static uint32_t sha256_read_word(const unsigned char *bytes) {
+  return ((uint32_t) bytes[0] << 24)
+    | ((uint32_t) bytes[1] << 16)
+    | ((uint32_t) bytes[2] << 8)
+    | (uint32_t) bytes[3];
+}
+
+/*
+ *  Run the sha256 compression function over consecutive 64 byte blocks.
+ *
+ *  @param struct sha256_context *context The running state.
+ *  @param unsigned char *data The blocks.
+ *  @param size_t blocks The number of blocks.
+ *  @return void
+ */
+static void sha256_transform(struct sha256_context *context, const unsigned char *data, size_t blocks) {
+
+  while (blocks--) {
+
+    // Expand the block into the message schedule.
+    uint32_t w[64];
+    int i;
+    for (i = 0; i < 16; i++) {
+      w[i] = sha256_read_word(data + i * 4);
+    }
+    for (i = 16; i < 64; i++) {
+      uint32_t s0 = SHA256_ROTATE(w[i - 15], 7) ^ SHA256_ROTATE(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      uint32_t s1 = SHA256_ROTATE(w[i - 2], 17) ^ SHA256_ROTATE(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = context->state[0];
+    uint32_t b = context->state[1];
+    uint32_t c = context->state[2];
+    uint32_t d = context->state[3];
+    uint32_t e = context->state[4];
+    uint32_t f = context->state[5];
+    uint32_t g = context->state[6];
+    uint32_t h = context->state[7];
+
+    for (i = 0; i < 64; i++) {
+      uint32_t s1 = SHA256_ROTATE(e, 6) ^ SHA256_ROTATE(e, 11) ^ SHA256_ROTATE(e, 25);
+      uint32_t choose = (e & f) ^ (~e & g);
+      uint32_t t1 = h + s1 + choose + sha256_constants[i] + w[i];
+      uint32_t s0 = SHA256_ROTATE(a, 2) ^ SHA256_ROTATE(a, 13) ^ SHA256_ROTATE(a, 22);
+      uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+      uint32_t t2 = s0 + majority;
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+    context->state[0] += a;
+    context->state[1] += b;
+    context->state[2] += c;
+    context->state[3] += d;
+    context->state[4] += e;
+    context->state[5] += f;
+    context->state[6] += g;
+    context->state[7] += h;
+
+    data += SHA256_BLOCK_LENGTH;
+
+  }
+
+}
+
+/*
+ *  Start a new sha256 computation.
+ *
+ *  @param struct sha256_context *context The state to initialize.
+ *  @return void
+ */
+void sha256_init(struct sha256_context *context) {
+  context->state[0] = 0x6a09e667;
+  context->state[1] = 0xbb67ae85;
+  context->state[2] = 0x3c6ef372;
+  context->state[3] = 0xa54ff53a;
+  context->state[4] = 0x510e527f;
+  context->state[5] = 0x9b05688c;
+  context->state[6] = 0x1f83d9ab;
+  context->state[7] = 0x5be0cd19;
+  context->length = 0;
+  context->buffered = 0;
+}
+
+/*
+ *  Feed more bytes into a sha256 computation.
+ *
+ *  @param struct sha256_context *context The running state.
+ *  @param void *data The bytes to add.
+ *  @param size_t length The number of bytes.
+ *  @return void
+ */
+void sha256_update(struct sha256_context *context, const void *data, size_t length) {
+
+  const unsigned char *bytes = data;
+  context->length += length;
+
+  // Top up a partially filled block first.
+  if (context->buffered > 0) {
+    size_t wanted = SHA256_BLOCK_LENGTH - context->buffered;
+    if (length < wanted) {
+      memcpy(context->buffer + context->buffered, bytes, length);
+      context->buffered += length;
+      return;
+    }
+    memcpy(context->buffer + context->buffered, bytes, wanted);
+    sha256_transform(context, context->buffer, 1);
+    context->buffered = 0;
+    bytes += wanted;
+    length -= wanted;
+  }
+
+  // Hash whole blocks straight out of the caller's memory.
+  size_t blocks = length / SHA256_BLOCK_LENGTH;
+  if (blocks > 0) {
+    sha256_transform(context, bytes, blocks);
+    bytes += blocks * SHA256_BLOCK_LENGTH;
+    length -= blocks * SHA256_BLOCK_LENGTH;
+  }
+
+  // Keep the tail for next time.
+  if (length > 0) {
+    memcpy(context->buffer, bytes, length);
+    context->buffered = length;
+  }
+
+}
+
+/*
+ *  Finish a sha256 computation and store the raw digest.
+ *
+ *  @param struct sha256_context *context The running state.
+ *  @param unsigned char digest[] The variable to store the 32 byte digest in.
+ *  @return void
+ */
+void sha256_final(struct sha256_context *context, unsigned char digest[SHA256_DIGEST_LENGTH]) {
+
+  // Pad with a single 1 bit, then zeros up to 56 bytes mod 64.
+  uint64_t bits = context->length * 8;
+  static const unsigned char padding[SHA256_BLOCK_LENGTH] = { 0x80 };
+  size_t pad_length = (context->buffered < 56)
+    ? 56 - context->buffered
+    : 120 - context->buffered;
+  sha256_update(context, padding, pad_length);
+
+  // Then the message length in bits, big-endian.
+  unsigned char length_bytes[8];
+  int i;
+  for (i = 0; i < 8; i++) {
+    length_bytes[i] = (unsigned char) (bits >> (56 - 8 * i));
+  }
+  sha256_update(context, length_bytes, 8);
+
+  // Write out the state, big-endian.
+  for (i = 0; i < 8; i++) {
+    digest[i * 4] = (unsigned char) (context->state[i] >> 24);
+    digest[i * 4 + 1] = (unsigned char) (context->state[i] >> 16);
+    digest[i * 4 + 2] = (unsigned char) (context->state[i] >> 8);
+    digest[i * 4 + 3] = (unsigned char) context->state[i];
+  }
+
+}
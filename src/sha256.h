@@ -0,0 +1,64 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for sha256.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef SHA256_H
+#define SHA256_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For fixed width integers, e.g., `uint32_t`.
+#include <stdint.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define SHA256_DIGEST_LENGTH 32
+#define SHA256_BLOCK_LENGTH 64
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The running state of a sha256 computation.
+struct sha256_context {
+  uint32_t state[8];
+  uint64_t length;
+  unsigned char buffer[SHA256_BLOCK_LENGTH];
+  size_t buffered;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in sha256.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void sha256_init(struct sha256_context *context);
+void sha256_update(struct sha256_context *context, const void *data, size_t length);
+void sha256_final(struct sha256_context *context, unsigned char digest[SHA256_DIGEST_LENGTH]);
+
+#endif
@@ -0,0 +1,278 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides a streaming sha512 implementation
+ *    (FIPS 180-4), and sha384, which is sha512 with a
+ *    different start and a shorter digest.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// For working with memory, e.g., `memcpy()`.
+#include <string.h>
+
+// We need the header that declares the prototypes for this file.
+#include "sha512.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// Rotate a 64 bit word right.
+#define SHA512_ROTATE(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+// The round constants: the first 64 bits of the fractional
+// parts of the cube roots of the first 80 primes.
+static const uint64_t sha512_constants[80] = {
+  0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+  0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+  0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+  0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+  0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+  0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+  0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+  0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+  0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+  0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+  0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+  0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+  0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+  0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+  0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+  0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+  0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+  0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+  0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+  0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in sha512.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Read a big-endian 64 bit word.
+ *
+ *  @param unsigned char *bytes The 8 bytes to read.
+ *  @return uint64_t The word.
+ */
+static uint64_t sha512_read_word(const unsigned char *bytes) {
+  uint64_t word = 0;
+  int i;
+  for (i = 0; i < 8; i++) {
+    word = (word << 8) | bytes[i];
+  }
+  return word;
+}
+
+/*
+ *  Run the sha512 compression function over consecutive 128 byte blocks.
+ *
+ *  @param struct sha512_context *context The running state.
+ *  @param unsigned char *data The blocks.
+ *  @param size_t blocks The number of blocks.
+ *  @return void
+ */
+static void sha512_transform(struct sha512_context *context, const unsigned char *data, size_t blocks) {
+
+  while (blocks--) {
+
+    // Expand the block into the message schedule.
+    uint64_t w[80];
+    int i;
+    for (i = 0; i < 16; i++) {
+      w[i] = sha512_read_word(data + i * 8);
+    }
+    for (i = 16; i < 80; i++) {
+      uint64_t s0 = SHA512_ROTATE(w[i - 15], 1) ^ SHA512_ROTATE(w[i - 15], 8) ^ (w[i - 15] >> 7);
+      uint64_t s1 = SHA512_ROTATE(w[i - 2], 19) ^ SHA512_ROTATE(w[i - 2], 61) ^ (w[i - 2] >> 6);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint64_t a = context->state[0];
+    uint64_t b = context->state[1];
+    uint64_t c = context->state[2];
+    uint64_t d = context->state[3];
+    uint64_t e = context->state[4];
+    uint64_t f = context->state[5];
+    uint64_t g = context->state[6];
+    uint64_t h = context->state[7];
+
+    for (i = 0; i < 80; i++) {
+      uint64_t s1 = SHA512_ROTATE(e, 14) ^ SHA512_ROTATE(e, 18) ^ SHA512_ROTATE(e, 41);
+      uint64_t choose = (e & f) ^ (~e & g);
+      uint64_t t1 = h + s1 + choose + sha512_constants[i] + w[i];
+      uint64_t s0 = SHA512_ROTATE(a, 28) ^ SHA512_ROTATE(a, 34) ^ SHA512_ROTATE(a, 39);
+      uint64_t majority = (a & b) ^ (a & c) ^ (b & c);
+      uint64_t t2 = s0 + majority;
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+    context->state[0] += a;
+    context->state[1] += b;
+    context->state[2] += c;
+    context->state[3] += d;
+    context->state[4] += e;
+    context->state[5] += f;
+    context->state[6] += g;
+    context->state[7] += h;
+
+    data += SHA512_BLOCK_LENGTH;
+
+  }
+
+}
+
+/*
+ *  Start a new sha512 computation.
+ *
+ *  @param struct sha512_context *context The state to initialize.
+ *  @return void
+ */
+void sha512_init(struct sha512_context *context) {
+  context->state[0] = 0x6a09e667f3bcc908ULL;
+  context->state[1] = 0xbb67ae8584caa73bULL;
+  context->state[2] = 0x3c6ef372fe94f82bULL;
+  context->state[3] = 0xa54ff53a5f1d36f1ULL;
+  context->state[4] = 0x510e527fade682d1ULL;
+  context->state[5] = 0x9b05688c2b3e6c1fULL;
+  context->state[6] = 0x1f83d9abfb41bd6bULL;
+  context->state[7] = 0x5be0cd19137e2179ULL;
+  context->length = 0;
+  context->buffered = 0;
+}
+
+/*
+ *  Start a new sha384 computation. It's finished with
+ *  `sha512_final()`, and its digest is the first
+ *  SHA384_DIGEST_LENGTH bytes.
+ *
+ *  @param struct sha512_context *context The state to initialize.
+ *  @return void
+ */
+void sha384_init(struct sha512_context *context) {
+  context->state[0] = 0xcbbb9d5dc1059ed8ULL;
+  context->state[1] = 0x629a292a367cd507ULL;
+  context->state[2] = 0x9159015a3070dd17ULL;
+  context->state[3] = 0x152fecd8f70e5939ULL;
+  context->state[4] = 0x67332667ffc00b31ULL;
+  context->state[5] = 0x8eb44a8768581511ULL;
+  context->state[6] = 0xdb0c2e0d64f98fa7ULL;
+  context->state[7] = 0x47b5481dbefa4fa4ULL;
+  context->length = 0;
+  context->buffered = 0;
+}
+
+/*
+ *  Feed more bytes into a sha512 (or sha384) computation.
+ *
+ *  @param struct sha512_context *context The running state.
+ *  @param void *data The bytes to add.
+ *  @param size_t length The number of bytes.
+ *  @return void
+ */
+void sha512_update(struct sha512_context *context, const void *data, size_t length) {
+
+  const unsigned char *bytes = data;
+  context->length += length;
+
+  // Top up a partially filled block first.
+  if (context->buffered > 0) {
+    size_t wanted = SHA512_BLOCK_LENGTH - context->buffered;
+    if (length < wanted) {
+      memcpy(context->buffer + context->buffered, bytes, length);
+      context->buffered += length;
+      return;
+    }
+    memcpy(context->buffer + context->buffered, bytes, wanted);
+    sha512_transform(context, context->buffer, 1);
+    context->buffered = 0;
+    bytes += wanted;
+    length -= wanted;
+  }
+
+  // Hash whole blocks straight out of the caller's memory.
+  size_t blocks = length / SHA512_BLOCK_LENGTH;
+  if (blocks > 0) {
+    sha512_transform(context, bytes, blocks);
+    bytes += blocks * SHA512_BLOCK_LENGTH;
+    length -= blocks * SHA512_BLOCK_LENGTH;
+  }
+
+  // Keep the tail for next time.
+  if (length > 0) {
+    memcpy(context->buffer, bytes, length);
+    context->buffered = length;
+  }
+
+}
+
+/*
+ *  Finish a sha512 (or sha384) computation and store the raw digest.
+ *
+ *  @param struct sha512_context *context The running state.
+ *  @param unsigned char digest[] The variable to store the 64 byte digest in
+ *                                (for sha384, only the first 48 bytes are the digest).
+ *  @return void
+ */
+void sha512_final(struct sha512_context *context, unsigned char digest[SHA512_DIGEST_LENGTH]) {
+
+  // Pad with a single 1 bit, then zeros up to 112 bytes mod 128.
+  uint64_t length = context->length;
+  static const unsigned char padding[SHA512_BLOCK_LENGTH] = { 0x80 };
+  size_t pad_length = (context->buffered < 112)
+    ? 112 - context->buffered
+    : 240 - context->buffered;
+  sha512_update(context, padding, pad_length);
+
+  // Then the message length in bits, as a big-endian 128 bit number.
+  unsigned char length_bytes[16];
+  uint64_t high = length >> 61;
+  uint64_t low = length << 3;
+  int i;
+  for (i = 0; i < 8; i++) {
+    length_bytes[i] = (unsigned char) (high >> (56 - 8 * i));
+    length_bytes[i + 8] = (unsigned char) (low >> (56 - 8 * i));
+  }
+  sha512_update(context, length_bytes, 16);
+
+  // Write out the state, big-endian.
+  for (i = 0; i < 8; i++) {
+    int j;
+    for (j = 0; j < 8; j++) {
+      digest[i * 8 + j] = (unsigned char) (context->state[i] >> (56 - 8 * j));
+    }
+  }
+
+}
@@ -0,0 +1,66 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for sha512.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef SHA512_H
+#define SHA512_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For fixed width integers, e.g., `uint64_t`.
+#include <stdint.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define SHA512_DIGEST_LENGTH 64
+#define SHA384_DIGEST_LENGTH 48
+#define SHA512_BLOCK_LENGTH 128
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The running state of a sha512 (or sha384) computation.
+struct sha512_context {
+  uint64_t state[8];
+  uint64_t length;
+  unsigned char buffer[SHA512_BLOCK_LENGTH];
+  size_t buffered;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in sha512.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void sha512_init(struct sha512_context *context);
+void sha384_init(struct sha512_context *context);
+void sha512_update(struct sha512_context *context, const void *data, size_t length);
+void sha512_final(struct sha512_context *context, unsigned char digest[SHA512_DIGEST_LENGTH]);
+
+#endif
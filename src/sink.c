@@ -0,0 +1,229 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides output sinks: a file (or stdout)
+ *    that is opened once, with a large buffer in front of it,
+ *    so each entry costs a `memcpy()` rather than a syscall.
+ *    A sink can also compress what's written to it (see
+ *    compress.c), in which case full buffers go to the
+ *    compressing thread instead of straight to the file.
+ *
+ *    Any failure to open, write or close the output is
+ *    reported on stderr, and the program exits.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `memcpy()`.
+#include <string.h>
+
+// For `errno` and `strerror()`.
+#include <errno.h>
+
+// For `open()`.
+#include <fcntl.h>
+
+// For `write()` and `close()`.
+#include <unistd.h>
+
+// We need the header that declares the prototypes for this file.
+#include "sink.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in sink.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Report a failed operation on a sink, and exit.
+ *
+ *  @param struct output_sink *sink The sink.
+ *  @param char *what What we were trying to do.
+ *  @return void
+ */
+static void sink_failed(struct output_sink *sink, const char *what) {
+  fprintf(stderr, "Could not %s this file: %s (%s)\n", what, sink->name, strerror(errno));
+  exit(1);
+}
+
+/*
+ *  Give a sink its buffer.
+ *
+ *  @param struct output_sink *sink The sink.
+ *  @return void
+ */
+static void allocate_buffer(struct output_sink *sink) {
+  sink->compressor = NULL;
+  sink->used = 0;
+  sink->capacity = SINK_BUFFER_LENGTH;
+  sink->buffer = malloc(sink->capacity);
+  if (sink->buffer == NULL) {
+    fprintf(stderr, "malloc failure, wtf\n");
+    exit(1);
+  }
+}
+
+/*
+ *  Write bytes straight to the descriptor, retrying short writes.
+ *
+ *  @param struct output_sink *sink The sink.
+ *  @param char *data The bytes.
+ *  @param size_t length The number of bytes.
+ *  @return void
+ */
+static void write_all(struct output_sink *sink, const char *data, size_t length) {
+  while (length > 0) {
+    ssize_t written = write(sink->descriptor, data, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      sink_failed(sink, "write to");
+    }
+    data += written;
+    length -= (size_t) written;
+  }
+}
+
+/*
+ *  Open (create or truncate) a file as a sink.
+ *
+ *  @param struct output_sink *sink The sink to set up.
+ *  @param char *path The path to the file.
+ *  @return void
+ */
+void open_sink(struct output_sink *sink, const char *path) {
+  sink->name = path;
+  sink->owns_descriptor = 1;
+  sink->descriptor = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (sink->descriptor < 0) {
+    sink_failed(sink, "open");
+  }
+  allocate_buffer(sink);
+}
+
+/*
+ *  Use stdout as a sink.
+ *
+ *  @param struct output_sink *sink The sink to set up.
+ *  @return void
+ */
+void open_stdout_sink(struct output_sink *sink) {
+
+  // Anything already printed through stdio has to come out first.
+  fflush(stdout);
+
+  sink->name = "<stdout>";
+  sink->owns_descriptor = 0;
+  sink->descriptor = STDOUT_FILENO;
+  allocate_buffer(sink);
+
+}
+
+/*
+ *  Compress everything written to a sink from here on.
+ *
+ *  @param struct output_sink *sink The sink (nothing written to it yet).
+ *  @param int method COMPRESS_NONE, COMPRESS_GZIP or COMPRESS_ZSTD.
+ *  @return void
+ */
+void compress_sink(struct output_sink *sink, int method) {
+  if (method != COMPRESS_NONE) {
+    sink->compressor = start_compressor(method, sink->descriptor, sink->name, sink->capacity);
+  }
+}
+
+/*
+ *  Write bytes to a sink.
+ *
+ *  @param struct output_sink *sink The sink.
+ *  @param char *data The bytes.
+ *  @param size_t length The number of bytes.
+ *  @return void
+ */
+void write_to_sink(struct output_sink *sink, const char *data, size_t length) {
+
+  // Make room if this won't fit.
+  if (sink->used + length > sink->capacity) {
+    flush_sink(sink);
+  }
+
+  // Something bigger than the whole buffer goes straight out
+  // (or, if we're compressing, through the buffer a piece at a time).
+  if (length >= sink->capacity && sink->compressor == NULL) {
+    write_all(sink, data, length);
+    return;
+  }
+  while (length >= sink->capacity) {
+    memcpy(sink->buffer, data, sink->capacity);
+    sink->used = sink->capacity;
+    flush_sink(sink);
+    data += sink->capacity;
+    length -= sink->capacity;
+  }
+
+  memcpy(sink->buffer + sink->used, data, length);
+  sink->used += length;
+
+}
+
+/*
+ *  Write out whatever is in a sink's buffer.
+ *
+ *  @param struct output_sink *sink The sink.
+ *  @return void
+ */
+void flush_sink(struct output_sink *sink) {
+  if (sink->compressor != NULL) {
+    if (sink->used > 0) {
+      sink->buffer = compress_buffer(sink->compressor, sink->buffer, sink->used);
+    }
+  } else {
+    write_all(sink, sink->buffer, sink->used);
+  }
+  sink->used = 0;
+}
+
+/*
+ *  Flush and close a sink.
+ *
+ *  @param struct output_sink *sink The sink.
+ *  @return void
+ */
+void close_sink(struct output_sink *sink) {
+  flush_sink(sink);
+  if (sink->compressor != NULL) {
+    finish_compressor(sink->compressor);
+    sink->compressor = NULL;
+  }
+  free(sink->buffer);
+  sink->buffer = NULL;
+  if (sink->owns_descriptor && close(sink->descriptor) != 0) {
+    sink_failed(sink, "close");
+  }
+}
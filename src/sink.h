@@ -0,0 +1,70 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for sink.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef SINK_H
+#define SINK_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For `struct compressor`.
+#include "compress.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define SINK_BUFFER_LENGTH (1024 * 1024)
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// An open output (a file or stdout) with a user-space buffer in front of it.
+// If `compressor` is set, full buffers are handed to it instead of written.
+struct output_sink {
+  int descriptor;
+  int owns_descriptor;
+  const char *name;
+  char *buffer;
+  size_t used;
+  size_t capacity;
+  struct compressor *compressor;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in sink.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void open_sink(struct output_sink *sink, const char *path);
+void open_stdout_sink(struct output_sink *sink);
+void compress_sink(struct output_sink *sink, int method);
+void write_to_sink(struct output_sink *sink, const char *data, size_t length);
+void flush_sink(struct output_sink *sink);
+void close_sink(struct output_sink *sink);
+
+#endif
@@ -0,0 +1,456 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file sorts the manifest (`--sort path|key|size`),
+ *    so its order doesn't depend on the order `readdir()`
+ *    happens to give us.
+ *
+ *    Records are kept in memory until they take up more than
+ *    the budget (`--sort-memory`). Then they're sorted and
+ *    spilled to a temporary file as a sorted run, and we start
+ *    again. At the end, the runs (and whatever is still in
+ *    memory) are merged, k ways at once, with a heap. If there
+ *    are ever more than SORT_MERGE_WIDTH runs, they're merged
+ *    into one run first, so we never hold more than that many
+ *    files open. However big the tree is, memory stays near
+ *    the budget.
+ *
+ *    Every order ends with the full path, so the result is
+ *    the same however the walk went (even with `--jobs`).
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `strcmp()`.
+#include <string.h>
+
+// For the mutex that guards the records during a `--jobs` walk.
+#include <pthread.h>
+
+// We time the sort, and count its runs (`--stats`).
+#include "stats.h"
+
+// We need the header that declares the prototypes for this file.
+#include "sort.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// Somewhere sorted records come from during a merge: a run
+// on disk, or the records still in memory.
+struct sort_source {
+  FILE *run;
+  struct asset_record **records;
+  size_t next;
+  size_t count;
+  struct asset_record *head;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  NON-CONSTANT VARIABLES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// What we sort by (SORT_NONE means we don't).
+int sort_order = SORT_NONE;
+
+// How much memory records can take before they're spilled.
+size_t sort_memory_budget = DEFAULT_SORT_MEMORY;
+
+// The records in memory, and how much memory they take.
+struct asset_record **sort_records = NULL;
+size_t sort_record_count = 0;
+size_t sort_record_capacity = 0;
+size_t sort_memory_used = 0;
+pthread_mutex_t sort_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// The runs spilled so far.
+FILE *sort_runs[SORT_MERGE_WIDTH];
+int sort_run_count = 0;
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in sort.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Find an order by its name.
+ *
+ *  @param char *name The name ("path", "key" or "size").
+ *  @return int SORT_PATH, SORT_KEY or SORT_SIZE, or -1 if there's none by that name.
+ */
+int find_sort_order(const char *name) {
+  if (strcmp(name, "path") == 0) {
+    return SORT_PATH;
+  } else if (strcmp(name, "key") == 0) {
+    return SORT_KEY;
+  } else if (strcmp(name, "size") == 0) {
+    return SORT_SIZE;
+  }
+  return -1;
+}
+
+/*
+ *  Set what to sort the manifest by.
+ *
+ *  @param int order SORT_NONE, SORT_PATH, SORT_KEY or SORT_SIZE.
+ *  @return void
+ */
+void set_sort_order(int order) {
+  sort_order = order;
+}
+
+/*
+ *  Set how much memory records can take before they're spilled to disk.
+ *
+ *  @param size_t bytes The budget.
+ *  @return void
+ */
+void set_sort_memory(size_t bytes) {
+  sort_memory_budget = bytes;
+}
+
+/*
+ *  Are we sorting the manifest?
+ *
+ *  @return int 1 if yes, 0 if no.
+ */
+int sort_is_enabled(void) {
+  return sort_order != SORT_NONE;
+}
+
+/*
+ *  Compare the full paths (directory and filename) of two records.
+ *
+ *  @param struct asset_record *a The first record.
+ *  @param struct asset_record *b The second record.
+ *  @return int <0, 0 or >0.
+ */
+static int compare_paths(const struct asset_record *a, const struct asset_record *b) {
+
+  // Walk both paths a byte at a time, moving from the
+  // directory on to the filename as each one runs out.
+  const unsigned char *x = (const unsigned char *) a->directory;
+  const unsigned char *y = (const unsigned char *) b->directory;
+  int x_in_filename = 0;
+  int y_in_filename = 0;
+  for (;;) {
+    if (*x == '\0' && !x_in_filename) {
+      x = (const unsigned char *) a->filename;
+      x_in_filename = 1;
+      continue;
+    }
+    if (*y == '\0' && !y_in_filename) {
+      y = (const unsigned char *) b->filename;
+      y_in_filename = 1;
+      continue;
+    }
+    if (*x != *y || *x == '\0') {
+      return (int) *x - (int) *y;
+    }
+    x++;
+    y++;
+  }
+
+}
+
+/*
+ *  Compare two records in the order we're sorting by.
+ *
+ *  @param struct asset_record *a The first record.
+ *  @param struct asset_record *b The second record.
+ *  @return int <0, 0 or >0.
+ */
+static int compare_records(const struct asset_record *a, const struct asset_record *b) {
+  if (sort_order == SORT_KEY) {
+    int order = strcmp(a->key, b->key);
+    if (order != 0) {
+      return order;
+    }
+  } else if (sort_order == SORT_SIZE) {
+    if (a->size != b->size) {
+      return a->size < b->size ? -1 : 1;
+    }
+  }
+  return compare_paths(a, b);
+}
+
+/*
+ *  Compare two records, for `qsort()`.
+ *
+ *  @param void *a A pointer to the first record.
+ *  @param void *b A pointer to the second record.
+ *  @return int <0, 0 or >0.
+ */
+static int compare_sorted(const void *a, const void *b) {
+  return compare_records(*(struct asset_record * const *) a, *(struct asset_record * const *) b);
+}
+
+/*
+ *  Make a temporary file for a run. It's deleted as soon as it's closed.
+ *
+ *  @return FILE* The file.
+ */
+static FILE *open_run(void) {
+  FILE *run = tmpfile();
+  if (run == NULL) {
+    puts("Could not make a temporary file for --sort.");
+    exit(1);
+  }
+  return run;
+}
+
+/*
+ *  Move a source on to its next record.
+ *
+ *  @param struct sort_source *source The source.
+ *  @return void
+ */
+static void advance(struct sort_source *source) {
+  if (source->run != NULL) {
+    source->head = read_record(source->run);
+    if (source->head == NULL && ferror(source->run)) {
+      puts("Could not read a temporary file for --sort.");
+      exit(1);
+    }
+  } else {
+    source->head = source->next < source->count ? source->records[source->next++] : NULL;
+  }
+}
+
+/*
+ *  Move a source down the heap until it's no bigger than its children.
+ *
+ *  @param struct sort_source **heap The heap (smallest head first).
+ *  @param int size How many sources are in it.
+ *  @param int position Where the source is.
+ *  @return void
+ */
+static void sift_down(struct sort_source **heap, int size, int position) {
+  for (;;) {
+    int smallest = position;
+    int left = 2 * position + 1;
+    int right = left + 1;
+    if (left < size && compare_records(heap[left]->head, heap[smallest]->head) < 0) {
+      smallest = left;
+    }
+    if (right < size && compare_records(heap[right]->head, heap[smallest]->head) < 0) {
+      smallest = right;
+    }
+    if (smallest == position) {
+      return;
+    }
+    struct sort_source *swap = heap[position];
+    heap[position] = heap[smallest];
+    heap[smallest] = swap;
+    position = smallest;
+  }
+}
+
+/*
+ *  Merge sorted sources, handing each record (in order) to a handler,
+ *  or writing it to a run. Each record is freed once it's been handled.
+ *
+ *  @param struct sort_source *sources The sources.
+ *  @param int count How many there are.
+ *  @param FILE *into The run to write to, or NULL to use `handler`.
+ *  @param void (*handler)(const struct asset_record*) Who gets the records.
+ *  @return void
+ */
+static void merge(struct sort_source *sources, int count, FILE *into,
+                  void (*handler)(const struct asset_record *record)) {
+
+  struct sort_source *heap[SORT_MERGE_WIDTH + 1];
+  int size = 0;
+  int i;
+  for (i = 0; i < count; i++) {
+    advance(&sources[i]);
+    if (sources[i].head != NULL) {
+      heap[size++] = &sources[i];
+    }
+  }
+  for (i = size / 2 - 1; i >= 0; i--) {
+    sift_down(heap, size, i);
+  }
+
+  // Take the smallest head, and put its source back where it belongs.
+  while (size > 0) {
+    struct asset_record *record = heap[0]->head;
+    if (into != NULL) {
+      if (!write_record(into, record)) {
+        puts("Could not write a temporary file for --sort.");
+        exit(1);
+      }
+    } else {
+      handler(record);
+    }
+    free(record);
+
+    advance(heap[0]);
+    if (heap[0]->head == NULL) {
+      heap[0] = heap[--size];
+    }
+    sift_down(heap, size, 0);
+  }
+
+}
+
+/*
+ *  Merge every run so far into one.
+ *
+ *  @return void
+ */
+static void merge_runs(void) {
+  struct sort_source sources[SORT_MERGE_WIDTH];
+  int i;
+  memset(sources, 0, sizeof(sources));
+  for (i = 0; i < sort_run_count; i++) {
+    rewind(sort_runs[i]);
+    sources[i].run = sort_runs[i];
+  }
+  FILE *merged = open_run();
+  merge(sources, sort_run_count, merged, NULL);
+  for (i = 0; i < sort_run_count; i++) {
+    fclose(sort_runs[i]);
+  }
+  sort_runs[0] = merged;
+  sort_run_count = 1;
+  count(COUNT_SORT_RUNS, 1);
+}
+
+/*
+ *  Sort the records in memory, and spill them to a new run.
+ *
+ *  @return void
+ */
+static void spill(void) {
+
+  uint64_t started = start_timer();
+
+  // Make room for the new run.
+  if (sort_run_count == SORT_MERGE_WIDTH) {
+    merge_runs();
+  }
+
+  qsort(sort_records, sort_record_count, sizeof(struct asset_record *), compare_sorted);
+  FILE *run = open_run();
+  size_t i;
+  for (i = 0; i < sort_record_count; i++) {
+    if (!write_record(run, sort_records[i])) {
+      puts("Could not write a temporary file for --sort.");
+      exit(1);
+    }
+    free(sort_records[i]);
+  }
+  sort_runs[sort_run_count++] = run;
+  sort_record_count = 0;
+  sort_memory_used = 0;
+  count(COUNT_SORT_RUNS, 1);
+
+  stop_timer(PHASE_SORT, started);
+
+}
+
+/*
+ *  Hold on to a record until the manifest is sorted.
+ *
+ *  @param struct asset_record *record The record.
+ *  @return void
+ */
+void sort_remember(const struct asset_record *record) {
+
+  struct asset_record *copy = copy_record(record);
+  size_t length = record_length(record) + sizeof(struct asset_record *);
+
+  pthread_mutex_lock(&sort_lock);
+
+  if (sort_record_count == sort_record_capacity) {
+    size_t new_capacity = sort_record_capacity ? sort_record_capacity * 2 : INITIAL_SORT_RECORDS;
+    struct asset_record **grown = realloc(sort_records, new_capacity * sizeof(struct asset_record *));
+    if (grown == NULL) {
+      puts("malloc failure, wtf");
+      exit(1);
+    }
+    sort_records = grown;
+    sort_record_capacity = new_capacity;
+  }
+  sort_records[sort_record_count++] = copy;
+  sort_memory_used += length;
+
+  if (sort_memory_used > sort_memory_budget) {
+    spill();
+  }
+
+  pthread_mutex_unlock(&sort_lock);
+
+}
+
+/*
+ *  Hand every record we've held on to to a handler, in order,
+ *  and let go of them.
+ *
+ *  @param void (*handler)(const struct asset_record*) Who gets the records.
+ *  @return void
+ */
+void finish_sort(void (*handler)(const struct asset_record *record)) {
+
+  uint64_t started = start_timer();
+
+  // The records in memory are one more source for the merge.
+  qsort(sort_records, sort_record_count, sizeof(struct asset_record *), compare_sorted);
+  struct sort_source sources[SORT_MERGE_WIDTH + 1];
+  memset(sources, 0, sizeof(sources));
+  int i;
+  for (i = 0; i < sort_run_count; i++) {
+    rewind(sort_runs[i]);
+    sources[i].run = sort_runs[i];
+  }
+  sources[sort_run_count].records = sort_records;
+  sources[sort_run_count].count = sort_record_count;
+
+  stop_timer(PHASE_SORT, started);
+
+  // The handler times itself (it's usually the output).
+  merge(sources, sort_run_count + 1, NULL, handler);
+
+  for (i = 0; i < sort_run_count; i++) {
+    fclose(sort_runs[i]);
+  }
+  sort_run_count = 0;
+  sort_record_count = 0;
+  sort_memory_used = 0;
+
+}
@@ -0,0 +1,64 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for sort.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef SORT_H
+#define SORT_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For `struct asset_record`.
+#include "record.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// What to sort by.
+#define SORT_NONE 0
+#define SORT_PATH 1
+#define SORT_KEY 2
+#define SORT_SIZE 3
+
+// How much memory records can take before they're spilled to disk.
+#define DEFAULT_SORT_MEMORY (64 * 1024 * 1024)
+
+// How many runs are merged at once. When there are more,
+// they're merged into one run first.
+#define SORT_MERGE_WIDTH 32
+
+#define INITIAL_SORT_RECORDS 1024
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in sort.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+int find_sort_order(const char *name);
+void set_sort_order(int order);
+void set_sort_memory(size_t bytes);
+int sort_is_enabled(void);
+void sort_remember(const struct asset_record *record);
+void finish_sort(void (*handler)(const struct asset_record *record));
+
+#endif
@@ -0,0 +1,193 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file makes Subresource Integrity values
+ *    (`--sri sha256,sha384,sha512`): the digests a browser
+ *    checks a script or stylesheet against, in the form
+ *    the `integrity` attribute takes, e.g.
+ *    "sha384-oqVuAfXRKap7fdgcCY5uykM6+R9GqQ8K/uxy9rx7HNQlGYl1kPzQho1wx4JwY8wC".
+ *
+ *    All the digests asked for are computed in one pass over
+ *    the bytes that were read for the file's hash.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// For working with strings, e.g., `strncmp()`.
+#include <string.h>
+
+// For md5 and sha256, the main digests that can share the pass.
+#include "md5.h"
+#include "sha256.h"
+#include "digest.h"
+
+// For sha384 and sha512.
+#include "sha512.h"
+
+// For encoding the digests.
+#include "base64.h"
+
+// We need the header that declares the prototypes for this file.
+#include "sri.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in sri.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Work out which digests a list (like "sha256,sha384") asks for.
+ *
+ *  @param char *list The names, separated by commas.
+ *  @return int The digests (SRI_SHA256, SRI_SHA384 and/or SRI_SHA512),
+ *              or -1 if a name isn't one of them.
+ */
+int find_sri_algorithms(const char *list) {
+  int algorithms = 0;
+  while (*list != '\0') {
+    size_t length = strcspn(list, ",");
+    if (length == 6 && strncmp(list, "sha256", 6) == 0) {
+      algorithms |= SRI_SHA256;
+    } else if (length == 6 && strncmp(list, "sha384", 6) == 0) {
+      algorithms |= SRI_SHA384;
+    } else if (length == 6 && strncmp(list, "sha512", 6) == 0) {
+      algorithms |= SRI_SHA512;
+    } else {
+      return -1;
+    }
+    list += length;
+    if (*list == ',') {
+      list++;
+    }
+  }
+  return algorithms != 0 ? algorithms : -1;
+}
+
+/*
+ *  Can a file's main digest (`--hash`) be computed in the same
+ *  pass as its integrity value? Only md5 and sha256 are fed a
+ *  piece at a time; xxh3 and blake3 (which may be spread over
+ *  threads) want the whole buffer at once.
+ *
+ *  @param int digest One of the DIGEST_* constants.
+ *  @return int 1 if yes, 0 if no.
+ */
+int sri_shares_pass(int digest) {
+  return digest == DIGEST_MD5 || digest == DIGEST_SHA256;
+}
+
+/*
+ *  Add one digest to an integrity value.
+ *
+ *  @param char *variable The value so far (it's added to the end).
+ *  @param char *prefix The digest's name and a dash, e.g. "sha384-".
+ *  @param unsigned char *digest The raw digest.
+ *  @param size_t length How long it is.
+ *  @return void
+ */
+static void add_to_integrity(char *variable, const char *prefix, const unsigned char *digest, size_t length) {
+  char *end = variable + strlen(variable);
+  if (end != variable) {
+    *end++ = ' ';
+  }
+  memcpy(end, prefix, strlen(prefix));
+  end += strlen(prefix);
+  end += base64_encode(end, digest, length);
+  *end = '\0';
+}
+
+/*
+ *  Hash some bytes with each of the digests asked for, and
+ *  store them as an integrity value (the digests in base64,
+ *  separated by spaces). The file's main digest can be
+ *  computed in the same pass (see `sri_shares_pass()`).
+ *
+ *  @param int algorithms The digests (SRI_SHA256, SRI_SHA384 and/or SRI_SHA512).
+ *  @param unsigned char *data The bytes.
+ *  @param size_t length The number of bytes.
+ *  @param char *variable The variable to store the value in
+ *                        (room for MAX_SRI_LENGTH + 1 characters).
+ *  @param int digest DIGEST_MD5 or DIGEST_SHA256 to compute it too, or -1 not to.
+ *  @param char *hex The variable to store that digest in, as hex
+ *                   (room for MAX_DIGEST_HEX_LENGTH + 1 characters).
+ *  @return void
+ */
+void sri_integrity(int algorithms, const unsigned char *data, size_t length, char *variable,
+                   int digest, char *hex) {
+
+  struct md5_context md5;
+  struct sha256_context sha256;
+  struct sha512_context sha384;
+  struct sha512_context sha512;
+  md5_init(&md5);
+  sha256_init(&sha256);
+  sha384_init(&sha384);
+  sha512_init(&sha512);
+
+  // A main sha256 digest is the same as the integrity value's.
+  int wants_md5 = digest == DIGEST_MD5;
+  int wants_sha256 = (algorithms & SRI_SHA256) || digest == DIGEST_SHA256;
+
+  // Feed each piece to every digest before moving on, so the
+  // file is only brought through the cache once.
+  size_t offset;
+  for (offset = 0; offset < length; offset += SRI_CHUNK_LENGTH) {
+    size_t chunk = length - offset < SRI_CHUNK_LENGTH ? length - offset : SRI_CHUNK_LENGTH;
+    if (wants_md5) {
+      md5_update(&md5, data + offset, chunk);
+    }
+    if (wants_sha256) {
+      sha256_update(&sha256, data + offset, chunk);
+    }
+    if (algorithms & SRI_SHA384) {
+      sha512_update(&sha384, data + offset, chunk);
+    }
+    if (algorithms & SRI_SHA512) {
+      sha512_update(&sha512, data + offset, chunk);
+    }
+  }
+
+  variable[0] = '\0';
+  unsigned char raw[SHA512_DIGEST_LENGTH];
+  if (wants_md5) {
+    md5_final(&md5, raw);
+    raw_digest_to_hex(DIGEST_MD5, raw, hex);
+  }
+  if (wants_sha256) {
+    sha256_final(&sha256, raw);
+    if (algorithms & SRI_SHA256) {
+      add_to_integrity(variable, "sha256-", raw, SHA256_DIGEST_LENGTH);
+    }
+    if (digest == DIGEST_SHA256) {
+      raw_digest_to_hex(DIGEST_SHA256, raw, hex);
+    }
+  }
+  if (algorithms & SRI_SHA384) {
+    sha512_final(&sha384, raw);
+    add_to_integrity(variable, "sha384-", raw, SHA384_DIGEST_LENGTH);
+  }
+  if (algorithms & SRI_SHA512) {
+    sha512_final(&sha512, raw);
+    add_to_integrity(variable, "sha512-", raw, SHA512_DIGEST_LENGTH);
+  }
+
+}
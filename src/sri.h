@@ -0,0 +1,58 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for sri.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef SRI_H
+#define SRI_H
+
+// For `size_t`.
+#include <stddef.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The digests an integrity value can have (a set of flags).
+#define SRI_SHA256 1
+#define SRI_SHA384 2
+#define SRI_SHA512 4
+
+// The digests are computed together, this many bytes at a
+// time, so each piece of the file is hashed by all of them
+// while it's still in the CPU's cache.
+#define SRI_CHUNK_LENGTH (32 * 1024)
+
+// The longest integrity value: all three digests, in base64,
+// with their prefixes and the spaces between them.
+#define MAX_SRI_LENGTH (7 + 44 + 1 + 7 + 64 + 1 + 7 + 88)
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in sri.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+int find_sri_algorithms(const char *list);
+int sri_shares_pass(int digest);
+void sri_integrity(int algorithms, const unsigned char *data, size_t length, char *variable,
+                   int digest, char *hex);
+
+#endif
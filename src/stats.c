@@ -0,0 +1,241 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides per-phase timers and counters
+ *    (`--stats`, `--stats-file <file>`).
+ *
+ *    Each phase (reading directories, stat'ing, reading files,
+ *    hashing, encoding, renaming, writing output, the cache,
+ *    the `--dedupe` report, `--sort`, `--compress` and
+ *    `--precompress`) adds up the monotonic time spent in it
+ *    and how many times it ran.
+ *    With `--jobs`, phase times are summed over all threads,
+ *    so they can add up to more than the wall time.
+ *
+ *    When stats are off, starting a timer returns 0 and stopping
+ *    it does nothing, so the cost is one branch per call.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For `clock_gettime()`.
+#include <time.h>
+
+// The counters are shared between threads.
+#include <stdatomic.h>
+
+// We need the header that declares the prototypes for this file.
+#include "stats.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  NON-CONSTANT VARIABLES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// Are we collecting stats?
+int stats_enabled = 0;
+
+// Where to write them as JSON (NULL means a summary on stderr).
+const char *stats_file_path = NULL;
+
+// The time spent in, and number of runs of, each phase.
+atomic_uint_fast64_t phase_nanoseconds[NUMBER_OF_PHASES];
+atomic_uint_fast64_t phase_calls[NUMBER_OF_PHASES];
+
+// The counters.
+atomic_uint_fast64_t counters[NUMBER_OF_COUNTERS];
+
+// When the run started.
+uint64_t run_started = 0;
+
+// Names for the report.
+static const char *phase_names[NUMBER_OF_PHASES] = {
+  "walk", "stat", "read", "hash", "base64", "rename", "output", "cache", "dedupe", "sort", "compress",
+  "precompress"
+};
+static const char *counter_names[NUMBER_OF_COUNTERS] = {
+  "files", "directories", "skipped", "bytes_read", "cache_hits",
+  "dedupe_partial", "dedupe_full", "sort_runs"
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in stats.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Turn stats on or off.
+ *
+ *  @param int flag 1 to collect stats, 0 not to.
+ *  @return void
+ */
+void set_stats(int flag) {
+  stats_enabled = flag;
+}
+
+/*
+ *  Collect stats, and write them to a JSON file at the end.
+ *
+ *  @param char *path The path to the file.
+ *  @return void
+ */
+void set_stats_file(const char *path) {
+  stats_file_path = path;
+  stats_enabled = 1;
+}
+
+/*
+ *  Are we collecting stats?
+ *
+ *  @return int 1 if yes, 0 if no.
+ */
+int stats_are_enabled(void) {
+  return stats_enabled;
+}
+
+/*
+ *  Read the monotonic clock.
+ *
+ *  @return uint64_t The time in nanoseconds.
+ */
+static uint64_t monotonic_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+/*
+ *  Start timing something.
+ *
+ *  @return uint64_t The start time (0 if stats are off).
+ */
+uint64_t start_timer(void) {
+  if (!stats_enabled) {
+    return 0;
+  }
+  return monotonic_now();
+}
+
+/*
+ *  Stop timing something, and add the time to a phase.
+ *
+ *  @param int phase One of the PHASE_* constants.
+ *  @param uint64_t started What `start_timer()` returned.
+ *  @return void
+ */
+void stop_timer(int phase, uint64_t started) {
+  if (!stats_enabled) {
+    return;
+  }
+  atomic_fetch_add_explicit(&phase_nanoseconds[phase], monotonic_now() - started, memory_order_relaxed);
+  atomic_fetch_add_explicit(&phase_calls[phase], 1, memory_order_relaxed);
+}
+
+/*
+ *  Add to a counter.
+ *
+ *  @param int counter One of the COUNT_* constants.
+ *  @param uint64_t amount How much to add.
+ *  @return void
+ */
+void count(int counter, uint64_t amount) {
+  if (!stats_enabled) {
+    return;
+  }
+  atomic_fetch_add_explicit(&counters[counter], amount, memory_order_relaxed);
+}
+
+/*
+ *  Note the start of the run.
+ *
+ *  @return void
+ */
+void start_stats(void) {
+  if (stats_enabled) {
+    run_started = monotonic_now();
+  }
+}
+
+/*
+ *  Print the stats: a summary on stderr, or JSON to the stats file.
+ *
+ *  @return void
+ */
+void report_stats(void) {
+
+  if (!stats_enabled) {
+    return;
+  }
+
+  double wall_seconds = (monotonic_now() - run_started) / 1e9;
+  int i;
+
+  // JSON, if we were given a file.
+  if (stats_file_path != NULL) {
+
+    FILE *file = fopen(stats_file_path, "w");
+    if (file == NULL) {
+      fprintf(stderr, "Could not write the stats file: %s\n", stats_file_path);
+      return;
+    }
+
+    fprintf(file, "{\"wall_seconds\":%.6f,\"phases\":{", wall_seconds);
+    for (i = 0; i < NUMBER_OF_PHASES; i++) {
+      fprintf(file, "%s\"%s\":{\"seconds\":%.6f,\"calls\":%llu}",
+              i > 0 ? "," : "", phase_names[i],
+              atomic_load(&phase_nanoseconds[i]) / 1e9,
+              (unsigned long long) atomic_load(&phase_calls[i]));
+    }
+    fprintf(file, "},\"counters\":{");
+    for (i = 0; i < NUMBER_OF_COUNTERS; i++) {
+      fprintf(file, "%s\"%s\":%llu", i > 0 ? "," : "", counter_names[i],
+              (unsigned long long) atomic_load(&counters[i]));
+    }
+    fprintf(file, "}}\n");
+
+    if (fclose(file) != 0) {
+      fprintf(stderr, "Could not write the stats file: %s\n", stats_file_path);
+    }
+    return;
+
+  }
+
+  // Otherwise, a summary on stderr.
+  fprintf(stderr, "\nassets stats (%.3f s wall)\n", wall_seconds);
+  fprintf(stderr, "  %-14s %12s %12s\n", "phase", "seconds", "calls");
+  for (i = 0; i < NUMBER_OF_PHASES; i++) {
+    fprintf(stderr, "  %-14s %12.6f %12llu\n", phase_names[i],
+            atomic_load(&phase_nanoseconds[i]) / 1e9,
+            (unsigned long long) atomic_load(&phase_calls[i]));
+  }
+  for (i = 0; i < NUMBER_OF_COUNTERS; i++) {
+    fprintf(stderr, "  %-14s %12llu\n", counter_names[i],
+            (unsigned long long) atomic_load(&counters[i]));
+  }
+
+}
@@ -0,0 +1,74 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for stats.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef STATS_H
+#define STATS_H
+
+// For fixed width integers, e.g., `uint64_t`.
+#include <stdint.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The phases we time.
+#define PHASE_WALK 0
+#define PHASE_STAT 1
+#define PHASE_READ 2
+#define PHASE_HASH 3
+#define PHASE_BASE64 4
+#define PHASE_RENAME 5
+#define PHASE_OUTPUT 6
+#define PHASE_CACHE 7
+#define PHASE_DEDUPE 8
+#define PHASE_SORT 9
+#define PHASE_COMPRESS 10
+#define PHASE_PRECOMPRESS 11
+#define NUMBER_OF_PHASES 12
+
+// The things we count.
+#define COUNT_FILES 0
+#define COUNT_DIRECTORIES 1
+#define COUNT_SKIPPED 2
+#define COUNT_BYTES_READ 3
+#define COUNT_CACHE_HITS 4
+#define COUNT_DEDUPE_PARTIAL 5
+#define COUNT_DEDUPE_FULL 6
+#define COUNT_SORT_RUNS 7
+#define NUMBER_OF_COUNTERS 8
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in stats.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void set_stats(int flag);
+void set_stats_file(const char *path);
+int stats_are_enabled(void);
+uint64_t start_timer(void);
+void stop_timer(int phase, uint64_t started);
+void count(int counter, uint64_t amount);
+void start_stats(void);
+void report_stats(void);
+
+#endif
@@ -0,0 +1,137 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides a string builder: a length-tracked,
+ *    bounds-checked replacement for chains of `strcat()`.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// For working with strings, e.g., `memcpy()`.
+#include <string.h>
+
+// We need the header that declares the prototypes for this file.
+#include "string_builder.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in string_builder.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Start building an (empty) string in a buffer.
+ *
+ *  @param struct string_builder *builder The builder to set up.
+ *  @param char *buffer The buffer to build the string in.
+ *  @param size_t capacity The size of the buffer, including room for the '\0'.
+ *  @return void
+ */
+void init_string_builder(struct string_builder *builder, char *buffer, size_t capacity) {
+  builder->data = buffer;
+  builder->capacity = capacity;
+  reset_string_builder(builder);
+}
+
+/*
+ *  Empty a builder, so it can be reused.
+ *
+ *  @param struct string_builder *builder The builder.
+ *  @return void
+ */
+void reset_string_builder(struct string_builder *builder) {
+  builder->length = 0;
+  builder->overflowed = 0;
+  if (builder->capacity > 0) {
+    builder->data[0] = '\0';
+  }
+}
+
+/*
+ *  Append some bytes to a builder.
+ *
+ *  @param struct string_builder *builder The builder.
+ *  @param char *bytes The bytes to add.
+ *  @param size_t length The number of bytes.
+ *  @return int 1 if they fit, 0 if not (in which case nothing is added).
+ */
+int append_bytes_to_builder(struct string_builder *builder, const char *bytes, size_t length) {
+  if (length > builder_room(builder)) {
+    builder->overflowed = 1;
+    return 0;
+  }
+  memcpy(builder->data + builder->length, bytes, length);
+  builder->length += length;
+  builder->data[builder->length] = '\0';
+  return 1;
+}
+
+/*
+ *  Append a string to a builder.
+ *
+ *  @param struct string_builder *builder The builder.
+ *  @param char *addition The string to add.
+ *  @return int 1 if it fit, 0 if not (in which case nothing is added).
+ */
+int append_to_builder(struct string_builder *builder, const char *addition) {
+  return append_bytes_to_builder(builder, addition, strlen(addition));
+}
+
+/*
+ *  Get a pointer to the end of the string, for writing into directly.
+ *
+ *  @param struct string_builder *builder The builder.
+ *  @return char * The end of the string.
+ */
+char *builder_end(struct string_builder *builder) {
+  return builder->data + builder->length;
+}
+
+/*
+ *  How many more characters will fit (not counting the '\0')?
+ *
+ *  @param struct string_builder *builder The builder.
+ *  @return size_t The number of characters.
+ */
+size_t builder_room(struct string_builder *builder) {
+  if (builder->capacity == 0) {
+    return 0;
+  }
+  return builder->capacity - 1 - builder->length;
+}
+
+/*
+ *  Take in characters that were written directly at `builder_end()`.
+ *
+ *  @param struct string_builder *builder The builder.
+ *  @param size_t length How many characters were written.
+ *  @return int 1 if they fit, 0 if not (in which case nothing is taken in).
+ */
+int extend_builder(struct string_builder *builder, size_t length) {
+  if (length > builder_room(builder)) {
+    builder->overflowed = 1;
+    builder->data[builder->length] = '\0';
+    return 0;
+  }
+  builder->length += length;
+  builder->data[builder->length] = '\0';
+  return 1;
+}
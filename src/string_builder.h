@@ -0,0 +1,59 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for string_builder.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef STRING_BUILDER_H
+#define STRING_BUILDER_H
+
+// For `size_t`.
+#include <stddef.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// A string being built in a fixed-size buffer. It knows its own
+// length, so appending never rescans what's already there, and
+// it knows its capacity, so appending never runs off the end.
+// If something doesn't fit, nothing is appended and `overflowed`
+// is set, so callers can check once when they're done.
+struct string_builder {
+  char *data;
+  size_t length;
+  size_t capacity;
+  int overflowed;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in string_builder.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void init_string_builder(struct string_builder *builder, char *buffer, size_t capacity);
+void reset_string_builder(struct string_builder *builder);
+int append_to_builder(struct string_builder *builder, const char *addition);
+int append_bytes_to_builder(struct string_builder *builder, const char *bytes, size_t length);
+char *builder_end(struct string_builder *builder);
+size_t builder_room(struct string_builder *builder);
+int extend_builder(struct string_builder *builder, size_t length);
+
+#endif
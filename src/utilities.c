@@ -40,6 +40,12 @@
 // For functions like `basename()`.
 #include <libgen.h>
 
+// We build paths with these.
+#include "string_builder.h"
+
+// We look extensions up in the table of types.
+#include "mime.h"
+
 // We need the header that declares the prototypes for this file.
 #include "utilities.h"
 
@@ -62,23 +68,6 @@ void initialize_string(char *name) {
   name[0] = '\0';
 }
 
-/*
- *  Add a string to a string (concat).
- *
- *  @param char *string The string to add to.
- *  @param char *addition The string to add.
- *  @return void
- */
-void add_to_string(char *string, const char *addition) {
-
-  // TODO - is there a maximum token size we can use to limit these string operations?
-
-  // TODO - I wouldn't use this function as an alias for strcat. We should be seeing the
-  // library calls so we understand what their limitations are.
-
-  strcat(string, addition);
-}
-
 /*
  *  Calculate the real path of the stipulated path,
  *  and store it in the specified variable.
@@ -100,53 +89,17 @@ void set_real_path(char *variable, const char *stipulated_path) {
 /*
  *  Build a path by appending a filename to a base path.
  *
- *  @return char *variable The variable to store the built path in.
- *  @return char *base_path The base path.
- *  @return char *filename The filename.
- *  @return void
+ *  @param struct string_builder *variable The builder to store the built path in.
+ *  @param char *base_path The base path.
+ *  @param char *filename The filename.
+ *  @return int 1 if the path fit, 0 if it was too long.
  */
-void build_path(char *variable, const char *base_path, const char *filename) {
-  initialize_string(variable);
-  add_to_string(variable, base_path);
-  add_to_string(variable, "/");
-  add_to_string(variable, filename);
-}
-
-/*
- *  Find if a string is in a comma separated list of strings.
- *
- *  @param char *haystack The comma separated list to look in.
- *  @param char *needle The string to look for.
- *  @return int 1 if it was found, 0 if not.
- */
-int string_is_in_list(const char *haystack, const char *needle) {
-
-  // TODO - is there a maximum token size we can use to
-  // limit these string operations?
-
-  // TODO - strlen doesn't count the terminating null. I've tried to fix this but please check my code.
-
-  // strtok is destructive, so we need to work on a copy of the haystack.
-  char haystack_copy[strlen(haystack)+1];
-  strcpy(haystack_copy, haystack);
-
-  // Walk through the haystack copy, looking for the needle.
-  char *token;
-  char delimiter[] = ",";
-  token = strtok(haystack_copy, delimiter);
-  while (token != NULL) {
-
-    // TODO - strlen here doesn't improve the strncmp call's security here.
-
-    if (strncmp(token, needle, strlen(needle)) == 0) {
-      return 1;
-    }
-    token = strtok(NULL, delimiter);
-  }
-
-  // No match was found if we got to here.
-  return 0;
-
+int build_path(struct string_builder *variable, const char *base_path, const char *filename) {
+  reset_string_builder(variable);
+  append_to_builder(variable, base_path);
+  append_to_builder(variable, "/");
+  append_to_builder(variable, filename);
+  return !variable->overflowed;
 }
 
 /*
@@ -187,31 +140,15 @@ int is_dir(struct stat *info) {
 }
 
 /*
- *  Is the item described by `info` an image?
+ *  Is a file with this extension an image we base64 encode
+ *  (gif, jpg, jpeg, png or svg)? The whole extension has to match.
  *
  *  @param *extension file extension.
  *  @return int 1 If true, 0 if false.
  */
-
-// TODO - use strncmp. I've tried to fix this but please check my code.
-
 int is_image(const char *extension) {
-  if(strncmp(extension, "gif", 3) == 0) {
-    return 1;
-  }
-  if(strncmp(extension, "jpg", 3) == 0) {
-    return 1;
-  }
-  if(strncmp(extension, "jpeg", 4) == 0) {
-    return 1;
-  }
-  if(strncmp(extension, "png", 3) == 0) {
-    return 1;
-  }
-  if(strncmp(extension, "svg", 3) == 0) {
-    return 1;
-  }
-  return 0;
+  const struct mime_type *type = find_mime_type(extension);
+  return type != NULL && (type->flags & MIME_IMAGE) ? 1 : 0;
 }
 
 /*
@@ -311,3 +248,47 @@ void explode(char *variable[], char *haystack, const char *delimiter) {
     token_position = strtok(NULL, delimiter);
   }
 }
+
+/*
+ *  Grow an array (if need be) so it has room for one more item.
+ *  It doubles, and the new items are all zeros.
+ *
+ *  @param void **array The array.
+ *  @param size_t *capacity How many items it has room for (updated).
+ *  @param size_t count How many items it holds.
+ *  @param size_t item_size The size of an item.
+ *  @param size_t initial_capacity How many items to make room for the first time.
+ *  @return void
+ */
+void make_room(void **array, size_t *capacity, size_t count, size_t item_size, size_t initial_capacity) {
+  if (count < *capacity) {
+    return;
+  }
+  size_t new_capacity = *capacity ? *capacity * 2 : initial_capacity;
+  void *grown = realloc(*array, new_capacity * item_size);
+  if (grown == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  memset((char *) grown + *capacity * item_size, 0, (new_capacity - *capacity) * item_size);
+  *array = grown;
+  *capacity = new_capacity;
+}
+
+/*
+ *  Hash some bytes (FNV-1a), for the hash tables that find
+ *  things by path, digest, etc.
+ *
+ *  @param char *bytes The bytes to hash.
+ *  @param size_t length The number of bytes.
+ *  @return uint32_t The hash.
+ */
+uint32_t hash_bytes(const char *bytes, size_t length) {
+  uint32_t hash = 2166136261u;
+  size_t i;
+  for (i = 0; i < length; i++) {
+    hash ^= (unsigned char) bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
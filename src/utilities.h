@@ -16,6 +16,18 @@
 #ifndef UTILITIES_H
 #define UTILITIES_H
 
+// For `size_t`.
+#include <stddef.h>
+
+// For fixed width integers, e.g., `uint32_t`.
+#include <stdint.h>
+
+// For `struct stat`.
+#include <sys/stat.h>
+
+// For `struct string_builder`.
+#include "string_builder.h"
+
 
 /*  ------------------------------------------------------------
  *
@@ -35,10 +47,8 @@
  */
 
 void initialize_string(char *name);
-void add_to_string(char *string, const char *addition);
 void set_real_path(char *variable, const char *stipulated_path);
-void build_path(char *variable, const char *base_path, const char *filename);
-int string_is_in_list(const char *haystack, const char *needle);
+int build_path(struct string_builder *variable, const char *base_path, const char *filename);
 int is_on_filesystem(const char *path);
 int is_dir(struct stat *info);
 int is_image(const char *extension);
@@ -48,5 +58,7 @@ void last_char_pos(int *index, const char *haystack, int needle);
 void substr(char *substring, const char *haystack, int index);
 int delimiter_count(const char *haystack, const char *delimiter);
 void explode(char *variable[], char *haystack, const char *delimiter);
+void make_room(void **array, size_t *capacity, size_t count, size_t item_size, size_t initial_capacity);
+uint32_t hash_bytes(const char *bytes, size_t length);
 
 #endif
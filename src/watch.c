@@ -0,0 +1,733 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides watch mode (`--watch`).
+ *
+ *    We walk the tree once, keeping every entry in memory
+ *    (keyed by path) and putting an inotify watch on every
+ *    directory we open. Then we wait for changes. A burst of
+ *    events is gathered until the tree has been quiet for
+ *    WATCH_QUIET_MILLISECONDS, and then only the paths that
+ *    changed are looked at again: changed files are processed,
+ *    new directories are walked, and anything that's gone is
+ *    dropped. Then the manifest is written out again from
+ *    memory. No other file is read or hashed again.
+ *
+ *    It runs until it's interrupted (SIGINT or SIGTERM).
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The standard C library.
+#include <stdio.h>
+
+// For things like `exit(0)`.
+#include <stdlib.h>
+
+// For working with strings, e.g., `strdup()`.
+#include <string.h>
+
+// For fixed width integers, e.g., `uint32_t`.
+#include <stdint.h>
+
+// For `errno`.
+#include <errno.h>
+
+// For `read()` and `close()`.
+#include <unistd.h>
+
+// For `stat()`.
+#include <sys/stat.h>
+
+// For `inotify_init1()` and friends.
+#include <sys/inotify.h>
+
+// For `poll()`.
+#include <poll.h>
+
+// For `sigaction()`.
+#include <signal.h>
+
+// For `clock_gettime()`.
+#include <time.h>
+
+// For the mutex that guards the tables during a `--jobs` walk.
+#include <pthread.h>
+
+// We walk and process files with these.
+#include "processing.h"
+
+// We write the manifest with these.
+#include "logging.h"
+
+// We sort the manifest (`--sort`) with these.
+#include "sort.h"
+
+// We build paths with these.
+#include "utilities.h"
+#include "string_builder.h"
+
+// We need the header that declares the prototypes for this file.
+#include "watch.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// The events that can change what's in the manifest.
+#define WATCH_EVENTS (IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE \
+                      | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+
+// Room for a batch of events from `read()`.
+#define WATCH_EVENT_BUFFER_LENGTH 65536
+
+
+/*  ------------------------------------------------------------
+ *
+ *  TYPES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// A file's record, in the order files were first seen.
+// When a file goes away, its record is dropped (NULL) but
+// its path stays, so it keeps its place if it comes back.
+struct watched_entry {
+  char *path;
+  struct asset_record *record;
+};
+
+// A path that changed, what happened to it, and its slot
+// in the hash table of pending changes.
+struct pending_change {
+  char *path;
+  uint32_t events;
+  size_t slot;
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  NON-CONSTANT VARIABLES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// Are we watching?
+int watching = 0;
+
+// The inotify descriptor.
+int inotify_descriptor = -1;
+
+// The entries, and a hash table (of indexes + 1, 0 for empty) to find them by path.
+struct watched_entry *watched_entries = NULL;
+size_t watched_entry_count = 0;
+size_t watched_entry_capacity = 0;
+size_t *entry_slots = NULL;
+size_t entry_slot_capacity = 0;
+
+// The path of each watched directory, indexed by watch descriptor.
+char **watched_directories = NULL;
+size_t watched_directory_capacity = 0;
+
+// Entries and watches can be added from several threads during the first walk.
+pthread_mutex_t watch_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// The changes gathered from a burst of events, and a hash
+// table (of indexes + 1, 0 for empty) to find them by path.
+struct pending_change *pending_changes = NULL;
+size_t pending_change_count = 0;
+size_t pending_change_capacity = 0;
+size_t *pending_slots = NULL;
+size_t pending_slot_capacity = 0;
+
+// Set when we're asked to stop.
+volatile sig_atomic_t stop_watching = 0;
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in watch.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Turn watch mode on or off.
+ *
+ *  @param int flag 1 to watch, 0 not to.
+ *  @return void
+ */
+void set_watch(int flag) {
+  watching = flag;
+}
+
+/*
+ *  Are we watching?
+ *
+ *  @return int 1 if yes, 0 if no.
+ */
+int watch_is_enabled(void) {
+  return watching;
+}
+
+/*
+ *  Copy a string.
+ *
+ *  @param char *string The string.
+ *  @return char * The copy.
+ */
+static char *copy_string(const char *string) {
+  char *copy = strdup(string);
+  if (copy == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  return copy;
+}
+
+/*
+ *  Find the hash table slot for a path: where it is, or
+ *  the empty slot where it would go.
+ *
+ *  @param char *path The path.
+ *  @return size_t * The slot.
+ */
+static size_t *find_entry_slot(const char *path) {
+  size_t mask = entry_slot_capacity - 1;
+  size_t index = hash_bytes(path, strlen(path)) & mask;
+  while (entry_slots[index] != 0
+         && strcmp(watched_entries[entry_slots[index] - 1].path, path) != 0) {
+    index = (index + 1) & mask;
+  }
+  return &entry_slots[index];
+}
+
+/*
+ *  Keep the hash table at most half full.
+ *
+ *  @return void
+ */
+static void grow_entry_slots(void) {
+  if ((watched_entry_count + 1) * 2 <= entry_slot_capacity) {
+    return;
+  }
+  free(entry_slots);
+  entry_slot_capacity = entry_slot_capacity ? entry_slot_capacity * 2 : 2 * INITIAL_WATCHED_ENTRIES;
+  entry_slots = calloc(entry_slot_capacity, sizeof(size_t));
+  if (entry_slots == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  size_t i;
+  for (i = 0; i < watched_entry_count; i++) {
+    *find_entry_slot(watched_entries[i].path) = i + 1;
+  }
+}
+
+/*
+ *  Store (or replace) a file's record. This is the scan's record handler.
+ *
+ *  @param struct asset_record *record The record.
+ *  @param void *context Unused.
+ *  @return void
+ */
+static void remember_record(const struct asset_record *record, void *context) {
+
+  // The manifest doesn't list itself: it changes every time we write it.
+  const char *path = record->path;
+  if (is_log_file(path)) {
+    return;
+  }
+
+  struct asset_record *copy = copy_record(record);
+
+  pthread_mutex_lock(&watch_lock);
+
+  grow_entry_slots();
+  size_t *slot = find_entry_slot(path);
+  if (*slot == 0) {
+    make_room((void **) &watched_entries, &watched_entry_capacity, watched_entry_count, sizeof(struct watched_entry), INITIAL_WATCHED_ENTRIES);
+    watched_entries[watched_entry_count].path = copy_string(path);
+    watched_entries[watched_entry_count].record = NULL;
+    *slot = ++watched_entry_count;
+  }
+  struct watched_entry *watched = &watched_entries[*slot - 1];
+  free(watched->record);
+  watched->record = copy;
+
+  pthread_mutex_unlock(&watch_lock);
+
+}
+
+/*
+ *  Drop a file's entry.
+ *
+ *  @param char *path The path to the file.
+ *  @return int 1 if it had one, 0 if not.
+ */
+static int forget_entry(const char *path) {
+  if (entry_slot_capacity == 0) {
+    return 0;
+  }
+  size_t *slot = find_entry_slot(path);
+  if (*slot == 0 || watched_entries[*slot - 1].record == NULL) {
+    return 0;
+  }
+  free(watched_entries[*slot - 1].record);
+  watched_entries[*slot - 1].record = NULL;
+  return 1;
+}
+
+/*
+ *  Is a path inside a folder?
+ *
+ *  @param char *path The path.
+ *  @param char *folder The folder.
+ *  @param size_t folder_length The length of the folder's path.
+ *  @return int 1 if yes, 0 if no.
+ */
+static int is_inside(const char *path, const char *folder, size_t folder_length) {
+  return strncmp(path, folder, folder_length) == 0 && path[folder_length] == '/';
+}
+
+/*
+ *  Drop the entries (and watches) for everything in a folder that's gone.
+ *
+ *  @param char *folder The folder.
+ *  @return int 1 if any entries were dropped, 0 if not.
+ */
+static int forget_folder(const char *folder) {
+
+  size_t folder_length = strlen(folder);
+  int changed = 0;
+  size_t i;
+
+  for (i = 0; i < watched_entry_count; i++) {
+    if (watched_entries[i].record != NULL && is_inside(watched_entries[i].path, folder, folder_length)) {
+      free(watched_entries[i].record);
+      watched_entries[i].record = NULL;
+      changed = 1;
+    }
+  }
+
+  // The kernel drops watches on deleted folders by itself,
+  // but a folder that was moved away is still being watched.
+  for (i = 0; i < watched_directory_capacity; i++) {
+    char *directory = watched_directories[i];
+    if (directory != NULL && (strcmp(directory, folder) == 0 || is_inside(directory, folder, folder_length))) {
+      inotify_rm_watch(inotify_descriptor, (int) i);
+      free(directory);
+      watched_directories[i] = NULL;
+    }
+  }
+
+  return changed;
+
+}
+
+/*
+ *  Watch a directory. This is the scan's directory handler.
+ *
+ *  @param char *path The path to the directory.
+ *  @param void *context Unused.
+ *  @return void
+ */
+static void watch_directory(const char *path, void *context) {
+
+  int descriptor = inotify_add_watch(inotify_descriptor, path, WATCH_EVENTS);
+  if (descriptor < 0) {
+    fprintf(stderr, "Could not watch this folder: %s (%s)\n", path, strerror(errno));
+    if (errno == ENOSPC) {
+      fprintf(stderr, "Try raising fs.inotify.max_user_watches.\n");
+    }
+    return;
+  }
+
+  // A folder that's moved (or watched twice) keeps its descriptor,
+  // so just note its current path.
+  pthread_mutex_lock(&watch_lock);
+  while ((size_t) descriptor >= watched_directory_capacity) {
+    make_room((void **) &watched_directories, &watched_directory_capacity, watched_directory_capacity, sizeof(char *), INITIAL_WATCHED_ENTRIES);
+  }
+  free(watched_directories[descriptor]);
+  watched_directories[descriptor] = copy_string(path);
+  pthread_mutex_unlock(&watch_lock);
+
+}
+
+/*
+ *  Write the manifest out from memory.
+ *
+ *  @return void
+ */
+static void write_manifest(void) {
+  start_logging();
+  size_t i;
+  for (i = 0; i < watched_entry_count; i++) {
+    if (watched_entries[i].record == NULL) {
+      continue;
+    }
+    if (sort_is_enabled()) {
+      sort_remember(watched_entries[i].record);
+    } else {
+      log_record(watched_entries[i].record);
+    }
+  }
+  if (sort_is_enabled()) {
+    finish_sort(log_record);
+  }
+  stop_logging();
+
+  // On stdout, each manifest goes on its own line.
+  if (get_logging_type() == 0) {
+    fputs("\n", stdout);
+    fflush(stdout);
+  }
+}
+
+/*
+ *  Find the hash table slot for a pending change: where it is,
+ *  or the empty slot where it would go.
+ *
+ *  @param char *path The path.
+ *  @return size_t The slot's index.
+ */
+static size_t find_pending_slot(const char *path) {
+  size_t mask = pending_slot_capacity - 1;
+  size_t index = hash_bytes(path, strlen(path)) & mask;
+  while (pending_slots[index] != 0
+         && strcmp(pending_changes[pending_slots[index] - 1].path, path) != 0) {
+    index = (index + 1) & mask;
+  }
+  return index;
+}
+
+/*
+ *  Keep the hash table of pending changes at most half full.
+ *
+ *  @return void
+ */
+static void grow_pending_slots(void) {
+  if ((pending_change_count + 1) * 2 <= pending_slot_capacity) {
+    return;
+  }
+  free(pending_slots);
+  pending_slot_capacity = pending_slot_capacity ? pending_slot_capacity * 2 : 2 * INITIAL_WATCHED_ENTRIES;
+  pending_slots = calloc(pending_slot_capacity, sizeof(size_t));
+  if (pending_slots == NULL) {
+    puts("malloc failure, wtf");
+    exit(1);
+  }
+  size_t i;
+  for (i = 0; i < pending_change_count; i++) {
+    pending_changes[i].slot = find_pending_slot(pending_changes[i].path);
+    pending_slots[pending_changes[i].slot] = i + 1;
+  }
+}
+
+/*
+ *  Note that a path changed. Each path is only noted once per
+ *  burst, with all of its events together.
+ *
+ *  @param char *path The path.
+ *  @param uint32_t events What happened to it.
+ *  @return void
+ */
+static void note_change(const char *path, uint32_t events) {
+  grow_pending_slots();
+  size_t slot = find_pending_slot(path);
+  if (pending_slots[slot] != 0) {
+    pending_changes[pending_slots[slot] - 1].events |= events;
+    return;
+  }
+  make_room((void **) &pending_changes, &pending_change_capacity, pending_change_count, sizeof(struct pending_change), INITIAL_WATCHED_ENTRIES);
+  pending_changes[pending_change_count].path = copy_string(path);
+  pending_changes[pending_change_count].events = events;
+  pending_changes[pending_change_count].slot = slot;
+  pending_slots[slot] = ++pending_change_count;
+}
+
+/*
+ *  Forget the changes from a burst. Only the slots they used are
+ *  emptied, so this costs as much as the burst, not the table.
+ *
+ *  @return void
+ */
+static void clear_pending_changes(void) {
+  size_t i;
+  for (i = 0; i < pending_change_count; i++) {
+    pending_slots[pending_changes[i].slot] = 0;
+    free(pending_changes[i].path);
+  }
+  pending_change_count = 0;
+}
+
+/*
+ *  Read whatever events are waiting, and note the changes.
+ *
+ *  @param struct scan *scan The scan (for the patterns to ignore).
+ *  @return int 1 if the kernel dropped events (so we have to start over), 0 if not.
+ */
+static int read_events(const struct scan *scan) {
+
+  char buffer[WATCH_EVENT_BUFFER_LENGTH] __attribute__((aligned(__alignof__(struct inotify_event))));
+  ssize_t length = read(inotify_descriptor, buffer, sizeof(buffer));
+  if (length <= 0) {
+    return 0;
+  }
+
+  int overflowed = 0;
+  char *position = buffer;
+  while (position < buffer + length) {
+
+    struct inotify_event *event = (struct inotify_event *) position;
+    position += sizeof(struct inotify_event) + event->len;
+
+    if (event->mask & IN_Q_OVERFLOW) {
+      overflowed = 1;
+      continue;
+    }
+
+    // The kernel stopped watching a folder (it was deleted).
+    if (event->mask & IN_IGNORED) {
+      if ((size_t) event->wd < watched_directory_capacity) {
+        free(watched_directories[event->wd]);
+        watched_directories[event->wd] = NULL;
+      }
+      continue;
+    }
+
+    // We only care about named things in folders we know about.
+    if (event->len == 0 || (size_t) event->wd >= watched_directory_capacity
+        || watched_directories[event->wd] == NULL) {
+      continue;
+    }
+
+    char path_buffer[MAX_PATH_LENGTH];
+    struct string_builder path;
+    init_string_builder(&path, path_buffer, sizeof(path_buffer));
+    if (build_path(&path, watched_directories[event->wd], event->name) && !is_log_file(path.data)
+        && !path_is_ignored(scan, path.data, (event->mask & IN_ISDIR) != 0)) {
+      note_change(path.data, event->mask);
+    }
+
+  }
+
+  return overflowed;
+
+}
+
+/*
+ *  Stop, if the scan went wrong.
+ *
+ *  @param struct scan *scan The scan.
+ *  @return void
+ */
+static void exit_if_failed(struct scan *scan) {
+  if (scan_failed(scan)) {
+    puts(scan->error);
+    exit(1);
+  }
+}
+
+/*
+ *  Report a path the scan couldn't handle, and go on watching
+ *  (only the first walk is allowed to stop us).
+ *
+ *  @param struct scan *scan The scan.
+ *  @return int 1 if something went wrong, 0 if not.
+ */
+static int report_if_failed(struct scan *scan) {
+  if (!scan_failed(scan)) {
+    return 0;
+  }
+  fprintf(stderr, "%s\n(skipped; still watching)\n", scan->error);
+  clear_scan_failure(scan);
+  return 1;
+}
+
+/*
+ *  Act on the changes from a burst of events.
+ *
+ *  @param struct scan *scan The scan.
+ *  @return int 1 if the manifest changed, 0 if not.
+ */
+static int apply_changes(struct scan *scan) {
+
+  int changed = 0;
+  size_t i;
+
+  for (i = 0; i < pending_change_count; i++) {
+
+    char *path = pending_changes[i].path;
+    uint32_t events = pending_changes[i].events;
+    struct stat info;
+
+    // It's gone: drop it (and, for a folder, everything in it).
+    if (stat(path, &info) != 0) {
+      changed |= forget_entry(path);
+      if (events & IN_ISDIR) {
+        changed |= forget_folder(path);
+      }
+    }
+
+    // A new folder (or one moved in): walk it.
+    else if (is_dir(&info)) {
+      if (events & (IN_CREATE | IN_MOVED_TO)) {
+        walk_directory(scan, path);
+        changed = 1;
+      }
+    }
+
+    // A new or changed file: process it again. If that fails,
+    // its old entry would be wrong, so it's dropped.
+    else if (is_file(&info)) {
+      process_file(scan, path, &info);
+      if (scan_failed(scan)) {
+        forget_entry(path);
+      }
+      changed = 1;
+    }
+
+    // Whatever went wrong with this path, the others still count.
+    report_if_failed(scan);
+
+  }
+
+  clear_pending_changes();
+  return changed;
+
+}
+
+/*
+ *  Get the monotonic time in milliseconds.
+ *
+ *  @return int64_t The time.
+ */
+static int64_t now_in_milliseconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/*
+ *  Ask the watch loop to stop.
+ *
+ *  @param int signal_number The signal.
+ *  @return void
+ */
+static void handle_stop_signal(int signal_number) {
+  (void) signal_number;
+  stop_watching = 1;
+}
+
+/*
+ *  Forget everything, and walk the whole tree again.
+ *
+ *  @param struct scan *scan The scan.
+ *  @param char *path The folder to walk.
+ *  @return void
+ */
+static void walk_everything(struct scan *scan, const char *path) {
+  size_t i;
+  for (i = 0; i < watched_entry_count; i++) {
+    free(watched_entries[i].record);
+    watched_entries[i].record = NULL;
+  }
+  walk(scan, path);
+}
+
+/*
+ *  Walk a tree, write the manifest, then keep it up to date
+ *  until we're interrupted.
+ *
+ *  @param struct scan *scan The scan (its handlers are ours while we watch).
+ *  @param char *path The folder to walk.
+ *  @return void
+ */
+void run_watch(struct scan *scan, const char *path) {
+
+  inotify_descriptor = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+  if (inotify_descriptor < 0) {
+    puts("Could not start watching (inotify isn't available).");
+    exit(1);
+  }
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = handle_stop_signal;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+
+  // The manifest is rewritten many times, so replace it in one go.
+  set_atomic_logging(1);
+
+  // Files change under us all the time now, so they're read, not mapped.
+  scan->never_map = 1;
+
+  // The first walk: keep the entries, and watch every folder.
+  scan->record_handler = remember_record;
+  scan->directory_handler = watch_directory;
+  walk_everything(scan, path);
+  exit_if_failed(scan);
+  write_manifest();
+
+  struct pollfd waiting;
+  waiting.fd = inotify_descriptor;
+  waiting.events = POLLIN;
+
+  while (!stop_watching) {
+
+    // Wait for something to happen.
+    if (poll(&waiting, 1, -1) <= 0) {
+      continue;
+    }
+
+    // Then gather events until things go quiet (or we've waited long enough).
+    int overflowed = 0;
+    int64_t first_event = now_in_milliseconds();
+    do {
+      overflowed |= read_events(scan);
+    } while (!stop_watching
+             && now_in_milliseconds() - first_event < WATCH_MAX_DELAY_MILLISECONDS
+             && poll(&waiting, 1, WATCH_QUIET_MILLISECONDS) > 0);
+
+    // If the kernel dropped events, we can't know what changed.
+    if (overflowed) {
+      fprintf(stderr, "Too many changes at once; walking the whole tree again.\n");
+      clear_pending_changes();
+      walk_everything(scan, path);
+      report_if_failed(scan);
+      write_manifest();
+    } else if (apply_changes(scan)) {
+      write_manifest();
+    }
+
+  }
+
+  close(inotify_descriptor);
+  scan->record_handler = NULL;
+  scan->directory_handler = NULL;
+
+}
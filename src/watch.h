@@ -0,0 +1,51 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for watch.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef WATCH_H
+#define WATCH_H
+
+// For `struct scan`.
+#include "processing.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+
+// How long the tree has to be quiet before we act on a burst of changes.
+#define WATCH_QUIET_MILLISECONDS 100
+
+// The longest we put off acting on changes while they keep coming.
+#define WATCH_MAX_DELAY_MILLISECONDS 1000
+
+#define INITIAL_WATCHED_ENTRIES 1024
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in watch.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+void set_watch(int flag);
+int watch_is_enabled(void);
+void run_watch(struct scan *scan, const char *path);
+
+#endif
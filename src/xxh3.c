@@ -0,0 +1,381 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file provides the 64 bit XXH3 hash (xxHash 0.8,
+ *    seed 0, default secret), computed in one shot over
+ *    a whole buffer.
+ *
+ *    XXH3 isn't a cryptographic hash, but it's many times
+ *    faster than md5, and a fingerprint for cachebusting is
+ *    all we need. Inputs up to 240 bytes take a short path;
+ *    longer ones go through 8 lanes of 64 bit accumulators,
+ *    which the compiler can vectorize.
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+
+/*  ------------------------------------------------------------
+ *
+ *  IMPORT LIBRARIES
+ *
+ *  ------------------------------------------------------------
+ */
+
+// We need the header that declares the prototypes for this file.
+#include "xxh3.h"
+
+
+/*  ------------------------------------------------------------
+ *
+ *  DEF/CONSTANTS
+ *
+ *  ------------------------------------------------------------
+ */
+#define XXH_PRIME32_1 0x9E3779B1U
+#define XXH_PRIME32_2 0x85EBCA77U
+#define XXH_PRIME32_3 0xC2B2AE3DU
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+#define XXH_PRIME_MX1 0x165667919E3779F9ULL
+#define XXH_PRIME_MX2 0x9FB21C651E98DF25ULL
+
+#define XXH_SECRET_LENGTH 192
+#define XXH_STRIPE_LENGTH 64
+#define XXH_SECRET_CONSUME_RATE 8
+#define XXH_ACCUMULATORS 8
+#define XXH_MIDSIZE_MAX 240
+#define XXH_MIDSIZE_START_OFFSET 3
+#define XXH_MIDSIZE_LAST_OFFSET 17
+#define XXH_SECRET_MIN_LENGTH 136
+#define XXH_LAST_STRIPE_OFFSET 7
+#define XXH_MERGE_OFFSET 11
+
+// The default secret.
+static const unsigned char xxh_secret[XXH_SECRET_LENGTH] = {
+  0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+  0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+  0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+  0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+  0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+  0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+  0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+  0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+  0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+  0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+  0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+  0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION DEFINITIONS
+ *  Note: function prototypes are defined in xxh3.h
+ *
+ *  ------------------------------------------------------------
+ */
+
+/*
+ *  Read a little-endian 32 bit word.
+ *
+ *  @param unsigned char *bytes The 4 bytes to read.
+ *  @return uint32_t The word.
+ */
+static uint32_t xxh_read32(const unsigned char *bytes) {
+  return (uint32_t) bytes[0]
+    | ((uint32_t) bytes[1] << 8)
+    | ((uint32_t) bytes[2] << 16)
+    | ((uint32_t) bytes[3] << 24);
+}
+
+/*
+ *  Read a little-endian 64 bit word.
+ *
+ *  @param unsigned char *bytes The 8 bytes to read.
+ *  @return uint64_t The word.
+ */
+static uint64_t xxh_read64(const unsigned char *bytes) {
+  return (uint64_t) xxh_read32(bytes) | ((uint64_t) xxh_read32(bytes + 4) << 32);
+}
+
+/*
+ *  Swap the bytes of a 64 bit word.
+ *
+ *  @param uint64_t x The word.
+ *  @return uint64_t The swapped word.
+ */
+static uint64_t xxh_swap64(uint64_t x) {
+  return __builtin_bswap64(x);
+}
+
+/*
+ *  Rotate a 64 bit word left.
+ *
+ *  @param uint64_t x The word.
+ *  @param int n How far.
+ *  @return uint64_t The rotated word.
+ */
+static uint64_t xxh_rotate64(uint64_t x, int n) {
+  return (x << n) | (x >> (64 - n));
+}
+
+/*
+ *  Multiply two 64 bit words to 128 bits, and fold the halves together.
+ *
+ *  @param uint64_t a The first word.
+ *  @param uint64_t b The second word.
+ *  @return uint64_t The low half xor the high half.
+ */
+static uint64_t xxh_multiply_fold(uint64_t a, uint64_t b) {
+  unsigned __int128 product = (unsigned __int128) a * b;
+  return (uint64_t) product ^ (uint64_t) (product >> 64);
+}
+
+/*
+ *  The XXH64 final mix.
+ *
+ *  @param uint64_t hash The hash so far.
+ *  @return uint64_t The mixed hash.
+ */
+static uint64_t xxh64_avalanche(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= XXH_PRIME64_2;
+  hash ^= hash >> 29;
+  hash *= XXH_PRIME64_3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+/*
+ *  The XXH3 final mix.
+ *
+ *  @param uint64_t hash The hash so far.
+ *  @return uint64_t The mixed hash.
+ */
+static uint64_t xxh3_avalanche(uint64_t hash) {
+  hash ^= hash >> 37;
+  hash *= XXH_PRIME_MX1;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+/*
+ *  The stronger final mix used for 4 to 8 byte inputs.
+ *
+ *  @param uint64_t hash The hash so far.
+ *  @param size_t length The length of the input.
+ *  @return uint64_t The mixed hash.
+ */
+static uint64_t xxh3_rrmxmx(uint64_t hash, size_t length) {
+  hash ^= xxh_rotate64(hash, 49) ^ xxh_rotate64(hash, 24);
+  hash *= XXH_PRIME_MX2;
+  hash ^= (hash >> 35) + length;
+  hash *= XXH_PRIME_MX2;
+  hash ^= hash >> 28;
+  return hash;
+}
+
+/*
+ *  Mix 16 bytes of input with 16 bytes of secret.
+ *
+ *  @param unsigned char *input The input.
+ *  @param unsigned char *secret The secret.
+ *  @return uint64_t The mix.
+ */
+static uint64_t xxh3_mix16(const unsigned char *input, const unsigned char *secret) {
+  return xxh_multiply_fold(xxh_read64(input) ^ xxh_read64(secret),
+                           xxh_read64(input + 8) ^ xxh_read64(secret + 8));
+}
+
+/*
+ *  Hash 0 to 16 bytes.
+ *
+ *  @param unsigned char *data The input.
+ *  @param size_t length The length of the input.
+ *  @return uint64_t The hash.
+ */
+static uint64_t xxh3_short(const unsigned char *data, size_t length) {
+
+  if (length > 8) {
+    uint64_t low = xxh_read64(data) ^ (xxh_read64(xxh_secret + 24) ^ xxh_read64(xxh_secret + 32));
+    uint64_t high = xxh_read64(data + length - 8) ^ (xxh_read64(xxh_secret + 40) ^ xxh_read64(xxh_secret + 48));
+    uint64_t accumulator = length + xxh_swap64(low) + high + xxh_multiply_fold(low, high);
+    return xxh3_avalanche(accumulator);
+  }
+
+  if (length >= 4) {
+    uint64_t first = xxh_read32(data);
+    uint64_t last = xxh_read32(data + length - 4);
+    uint64_t keyed = (last + (first << 32)) ^ (xxh_read64(xxh_secret + 8) ^ xxh_read64(xxh_secret + 16));
+    return xxh3_rrmxmx(keyed, length);
+  }
+
+  if (length > 0) {
+    uint32_t combined = ((uint32_t) data[0] << 16)
+      | ((uint32_t) data[length >> 1] << 24)
+      | (uint32_t) data[length - 1]
+      | ((uint32_t) length << 8);
+    uint64_t keyed = (uint64_t) combined ^ (uint64_t) (xxh_read32(xxh_secret) ^ xxh_read32(xxh_secret + 4));
+    return xxh64_avalanche(keyed);
+  }
+
+  return xxh64_avalanche(xxh_read64(xxh_secret + 56) ^ xxh_read64(xxh_secret + 64));
+
+}
+
+/*
+ *  Hash 17 to 240 bytes.
+ *
+ *  @param unsigned char *data The input.
+ *  @param size_t length The length of the input.
+ *  @return uint64_t The hash.
+ */
+static uint64_t xxh3_medium(const unsigned char *data, size_t length) {
+
+  uint64_t accumulator = length * XXH_PRIME64_1;
+
+  // Up to 128 bytes: pairs of 16 byte blocks from both ends, working in.
+  if (length <= 128) {
+    if (length > 32) {
+      if (length > 64) {
+        if (length > 96) {
+          accumulator += xxh3_mix16(data + 48, xxh_secret + 96);
+          accumulator += xxh3_mix16(data + length - 64, xxh_secret + 112);
+        }
+        accumulator += xxh3_mix16(data + 32, xxh_secret + 64);
+        accumulator += xxh3_mix16(data + length - 48, xxh_secret + 80);
+      }
+      accumulator += xxh3_mix16(data + 16, xxh_secret + 32);
+      accumulator += xxh3_mix16(data + length - 32, xxh_secret + 48);
+    }
+    accumulator += xxh3_mix16(data, xxh_secret);
+    accumulator += xxh3_mix16(data + length - 16, xxh_secret + 16);
+    return xxh3_avalanche(accumulator);
+  }
+
+  // Up to 240 bytes: the first 128 bytes, a mix, then the rest.
+  size_t rounds = length / 16;
+  size_t i;
+  for (i = 0; i < 8; i++) {
+    accumulator += xxh3_mix16(data + 16 * i, xxh_secret + 16 * i);
+  }
+  accumulator = xxh3_avalanche(accumulator);
+  for (i = 8; i < rounds; i++) {
+    accumulator += xxh3_mix16(data + 16 * i, xxh_secret + 16 * (i - 8) + XXH_MIDSIZE_START_OFFSET);
+  }
+  accumulator += xxh3_mix16(data + length - 16, xxh_secret + XXH_SECRET_MIN_LENGTH - XXH_MIDSIZE_LAST_OFFSET);
+  return xxh3_avalanche(accumulator);
+
+}
+
+/*
+ *  Feed one 64 byte stripe into the accumulators.
+ *
+ *  @param uint64_t accumulators[] The accumulators.
+ *  @param unsigned char *stripe The stripe.
+ *  @param unsigned char *secret The part of the secret to use.
+ *  @return void
+ */
+static void xxh3_accumulate(uint64_t accumulators[XXH_ACCUMULATORS], const unsigned char *stripe, const unsigned char *secret) {
+  int i;
+  for (i = 0; i < XXH_ACCUMULATORS; i++) {
+    uint64_t value = xxh_read64(stripe + 8 * i);
+    uint64_t keyed = value ^ xxh_read64(secret + 8 * i);
+    accumulators[i ^ 1] += value;
+    accumulators[i] += (keyed & 0xFFFFFFFFULL) * (keyed >> 32);
+  }
+}
+
+/*
+ *  Scramble the accumulators at the end of each block.
+ *
+ *  @param uint64_t accumulators[] The accumulators.
+ *  @param unsigned char *secret The part of the secret to use.
+ *  @return void
+ */
+static void xxh3_scramble(uint64_t accumulators[XXH_ACCUMULATORS], const unsigned char *secret) {
+  int i;
+  for (i = 0; i < XXH_ACCUMULATORS; i++) {
+    uint64_t accumulator = accumulators[i];
+    accumulator ^= accumulator >> 47;
+    accumulator ^= xxh_read64(secret + 8 * i);
+    accumulator *= XXH_PRIME32_1;
+    accumulators[i] = accumulator;
+  }
+}
+
+/*
+ *  Hash more than 240 bytes.
+ *
+ *  @param unsigned char *data The input.
+ *  @param size_t length The length of the input.
+ *  @return uint64_t The hash.
+ */
+static uint64_t xxh3_long(const unsigned char *data, size_t length) {
+
+  uint64_t accumulators[XXH_ACCUMULATORS] = {
+    XXH_PRIME32_3, XXH_PRIME64_1, XXH_PRIME64_2, XXH_PRIME64_3,
+    XXH_PRIME64_4, XXH_PRIME32_2, XXH_PRIME64_5, XXH_PRIME32_1
+  };
+
+  size_t stripes_per_block = (XXH_SECRET_LENGTH - XXH_STRIPE_LENGTH) / XXH_SECRET_CONSUME_RATE;
+  size_t block_length = XXH_STRIPE_LENGTH * stripes_per_block;
+  size_t blocks = (length - 1) / block_length;
+  size_t block, stripe;
+
+  // Whole blocks, each followed by a scramble.
+  for (block = 0; block < blocks; block++) {
+    for (stripe = 0; stripe < stripes_per_block; stripe++) {
+      xxh3_accumulate(accumulators, data + block * block_length + stripe * XXH_STRIPE_LENGTH,
+                      xxh_secret + stripe * XXH_SECRET_CONSUME_RATE);
+    }
+    xxh3_scramble(accumulators, xxh_secret + XXH_SECRET_LENGTH - XXH_STRIPE_LENGTH);
+  }
+
+  // The whole stripes of the last block, then the last 64 bytes.
+  size_t stripes = ((length - 1) - block_length * blocks) / XXH_STRIPE_LENGTH;
+  for (stripe = 0; stripe < stripes; stripe++) {
+    xxh3_accumulate(accumulators, data + blocks * block_length + stripe * XXH_STRIPE_LENGTH,
+                    xxh_secret + stripe * XXH_SECRET_CONSUME_RATE);
+  }
+  xxh3_accumulate(accumulators, data + length - XXH_STRIPE_LENGTH,
+                  xxh_secret + XXH_SECRET_LENGTH - XXH_STRIPE_LENGTH - XXH_LAST_STRIPE_OFFSET);
+
+  // Merge the accumulators.
+  uint64_t hash = length * XXH_PRIME64_1;
+  int i;
+  for (i = 0; i < XXH_ACCUMULATORS; i += 2) {
+    const unsigned char *secret = xxh_secret + XXH_MERGE_OFFSET + 8 * i;
+    hash += xxh_multiply_fold(accumulators[i] ^ xxh_read64(secret), accumulators[i + 1] ^ xxh_read64(secret + 8));
+  }
+  return xxh3_avalanche(hash);
+
+}
+
+/*
+ *  Get the 64 bit XXH3 hash of some bytes.
+ *
+ *  @param unsigned char *data The bytes.
+ *  @param size_t length The number of bytes.
+ *  @return uint64_t The hash.
+ */
+uint64_t xxh3_64(const unsigned char *data, size_t length) {
+  if (length <= 16) {
+    return xxh3_short(data, length);
+  }
+  if (length <= XXH_MIDSIZE_MAX) {
+    return xxh3_medium(data, length);
+  }
+  return xxh3_long(data, length);
+}
@@ -0,0 +1,36 @@
+/***************************************************************
+ *
+ *    ASSETS
+ *
+ *    This program crawls a directory tree and
+ *    makes a record of all assets it finds.
+ *
+ *    This file is the header for xxh3.c
+ *
+ *    Author JT Paasch
+ *    Copyright 2014 Nara Logics
+ *    License MIT (included with this source code)
+ *
+ **************************************************************/
+
+#ifndef XXH3_H
+#define XXH3_H
+
+// For `size_t`.
+#include <stddef.h>
+
+// For fixed width integers, e.g., `uint64_t`.
+#include <stdint.h>
+
+
+/*  ------------------------------------------------------------
+ *
+ *  FUNCTION PROTOTYPES
+ *  Note: These functions are implemented in xxh3.c
+ *
+ *  ------------------------------------------------------------
+ */
+
+uint64_t xxh3_64(const unsigned char *data, size_t length);
+
+#endif
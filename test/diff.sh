@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+#    ASSETS
+#
+#    Check `--diff` against old manifests that have
+#    tripped it up before.
+#
+#    Author JT Paasch
+#    Copyright 2014 Nara Logics
+#    License MIT (included with this source code)
+#
+
+set -e
+
+BUILD=${BUILD:-build}
+ASSETS=${ASSETS:-$BUILD/assets}
+WORK=${WORK:-$BUILD/test_diff}
+
+rm -rf "$WORK"
+mkdir -p "$WORK/tree"
+DIRECTORY=$(cd "$WORK/tree" && pwd)/
+printf 'MIT\n' > "$WORK/tree/LICENSE"
+printf 'hello\n' > "$WORK/tree/hello.txt"
+
+fail() {
+  echo "test/diff.sh: $1"
+  exit 1
+}
+
+# The old manifest starts with a file that has no extension (so
+# its "extension" is the first empty field the reader sees).
+printf '[{"key":"LICENSE","directory":"%s","filename":"LICENSE","extension":"","md5":"0"},' "$DIRECTORY" > "$WORK/old.json"
+printf '{"key":"hello","directory":"%s","filename":"hello.txt","extension":"txt","mime":"","md5":"0"}]\n' "$DIRECTORY" >> "$WORK/old.json"
+
+"$ASSETS" "$WORK/tree" "$WORK/new.json" --diff "$WORK/old.json" || fail "--diff exited with $?"
+grep -q '"change":"modified","key":"LICENSE"' "$WORK/new.json" || fail "LICENSE wasn't reported as modified"
+grep -q '"change":"modified","key":"hello"' "$WORK/new.json" || fail "hello.txt wasn't reported as modified"
+
+rm -rf "$WORK"
+echo "test/diff.sh: ok"